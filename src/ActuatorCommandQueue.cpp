@@ -0,0 +1,103 @@
+#include "ActuatorCommandQueue.h"
+
+ActuatorCommandQueue::ActuatorCommandQueue() : posted(0), coalesced(0), drains(0) {
+    for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+        slots[i].store(0);
+    }
+}
+
+void ActuatorCommandQueue::store(Slot slot, uint32_t word) {
+    uint32_t previous = slots[slot].exchange(word);
+    posted++;
+    if (previous & PENDING) {
+        coalesced++;
+    }
+}
+
+void ActuatorCommandQueue::postSwitch(Slot slot, SwitchCommand command) {
+    if (command == SwitchCommand::Keep || slot == Brightness || slot >= SLOT_COUNT) {
+        return;
+    }
+    if (command != SwitchCommand::Toggle) {
+        store(slot, PENDING | (uint32_t)command);
+        return;
+    }
+    
+    // A toggle depends on what is pending: merge with a compare-exchange loop
+    uint32_t previous = slots[slot].load();
+    uint32_t next;
+    do {
+        SwitchCommand merged = SwitchCommand::Toggle;
+        if (previous & PENDING) {
+            switch ((SwitchCommand)(previous & 0xFF)) {
+                case SwitchCommand::On:     merged = SwitchCommand::Off; break;
+                case SwitchCommand::Off:    merged = SwitchCommand::On; break;
+                default:                    merged = SwitchCommand::Keep; break;
+            }
+        }
+        next = merged == SwitchCommand::Keep ? 0 : PENDING | (uint32_t)merged;
+    } while (!slots[slot].compare_exchange_weak(previous, next));
+    posted++;
+    if (previous & PENDING) {
+        coalesced++;
+    }
+}
+
+void ActuatorCommandQueue::postBrightness(int brightness) {
+    store(Brightness, PENDING | (uint32_t)constrain(brightness, 0, 100));
+}
+
+void ActuatorCommandQueue::post(const ActuatorCommands& commands) {
+    postSwitch(Pump, commands.pump);
+    postSwitch(GrowLed, commands.growLed);
+    postSwitch(Boost, commands.boost);
+    postSwitch(RgbLeds, commands.rgbLeds);
+    if (commands.brightness >= 0) {
+        postBrightness(commands.brightness);
+    }
+}
+
+bool ActuatorCommandQueue::take(ActuatorCommands& commands) {
+    bool any = false;
+    SwitchCommand* switches[SLOT_COUNT] = { &commands.pump, &commands.growLed, nullptr, &commands.boost, &commands.rgbLeds };
+    for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+        uint32_t word = slots[i].exchange(0);
+        if (!(word & PENDING)) {
+            continue;
+        }
+        any = true;
+        if (i == Brightness) {
+            commands.brightness = (int8_t)(word & 0xFF);
+        } else {
+            *switches[i] = (SwitchCommand)(word & 0xFF);
+        }
+    }
+    if (any) {
+        drains++;
+    }
+    return any;
+}
+
+bool ActuatorCommandQueue::applyTo(DeviceController& devices) {
+    ActuatorCommands commands;
+    if (!take(commands)) {
+        return false;
+    }
+    devices.apply(commands);
+    return true;
+}
+
+ActuatorCommandQueue::Stats ActuatorCommandQueue::getStats() const {
+    Stats stats;
+    stats.posted = posted.load();
+    stats.coalesced = coalesced.load();
+    stats.drains = drains.load();
+    return stats;
+}
+
+size_t ActuatorCommandQueue::formatStats(char* buffer, size_t size) const {
+    Stats stats = getStats();
+    int n = snprintf(buffer, size, "actuator commands: posted %lu, coalesced %lu, applied batches %lu\n",
+                     (unsigned long)stats.posted, (unsigned long)stats.coalesced, (unsigned long)stats.drains);
+    return n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+}
@@ -0,0 +1,58 @@
+#ifndef ACTUATORCOMMANDQUEUE_H
+#define ACTUATORCOMMANDQUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "DeviceController.h"
+
+// Hand-off of actuator commands from HTTP handlers to the control loop.
+//
+// One mailbox word per actuator instead of a FIFO: a newer command replaces
+// a pending one (latest value wins), so the queue is bounded by construction
+// and a slider drag costs one analogWrite per drain, not one per request.
+// Toggles merge with what is pending (toggle + toggle = nothing, toggle of a
+// pending ON = OFF). post*() and take() are lock-free (one atomic per slot)
+// and safe from any task; take() is meant for a single consumer.
+class ActuatorCommandQueue {
+public:
+    enum Slot : uint8_t {
+        Pump,
+        GrowLed,
+        Brightness,
+        Boost,
+        RgbLeds,
+        SLOT_COUNT
+    };
+
+    struct Stats {
+        uint32_t posted;
+        uint32_t coalesced;     // replaced a pending command
+        uint32_t drains;        // take() calls that found work
+    };
+
+    ActuatorCommandQueue();
+
+    void postSwitch(Slot slot, SwitchCommand command);
+    void postBrightness(int brightness);                // 0-100
+    void post(const ActuatorCommands& commands);
+
+    // Moves every pending command into commands; false when there were none
+    bool take(ActuatorCommands& commands);
+    // take() and DeviceController::apply() in one step (the control loop's drain)
+    bool applyTo(DeviceController& devices);
+
+    Stats getStats() const;
+    size_t formatStats(char* buffer, size_t size) const;
+
+private:
+    static const uint32_t PENDING = 0x80000000UL;
+
+    std::atomic<uint32_t> slots[SLOT_COUNT];
+    std::atomic<uint32_t> posted;
+    std::atomic<uint32_t> coalesced;
+    std::atomic<uint32_t> drains;
+
+    void store(Slot slot, uint32_t word);
+};
+
+#endif // ACTUATORCOMMANDQUEUE_H
@@ -0,0 +1,200 @@
+#include "AnomalyDetector.h"
+#include "SensorBackend.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANOMALY_LATCHED (ANOMALY_BIT(PumpNoFlow) | ANOMALY_BIT(PumpNoSoil) | ANOMALY_BIT(WaterLoss))
+
+namespace {
+bool climateValid(float value) { return value > SENSOR_NO_READING + 1.0f; }
+int32_t centi(float value) { return (int32_t)lroundf(value * 100.0f); }
+}
+
+AnomalyDetector::AnomalyDetector()
+    : active(0), havePrevious(false), pumpRunning(false), runStartMs(0), runStartSoil(-1), runStartWater(-1),
+      runSoilRose(false), runWaterFell(false), waterRefMs(0), waterRef(-1), waterLow(-1),
+      waterLossSeen(false), waterLossSinceMs(0), lastSoilRaw(-1), soilChangedMs(0),
+      lastTemperature(0), lastHumidity(0), climateChangedMs(0) {
+    memset(alarms, 0, sizeof(alarms));
+    memset(&previous, 0, sizeof(previous));
+}
+
+const char* AnomalyDetector::kindName(AnomalyKind kind) {
+    switch (kind) {
+        case AnomalyKind::PumpNoFlow:      return "pump_no_flow";
+        case AnomalyKind::PumpNoSoil:      return "pump_no_soil";
+        case AnomalyKind::WaterLoss:       return "water_loss";
+        case AnomalyKind::SoilJump:        return "soil_jump";
+        case AnomalyKind::WaterJump:       return "water_jump";
+        case AnomalyKind::ClimateJump:     return "climate_jump";
+        case AnomalyKind::SoilFlatline:    return "soil_flatline";
+        case AnomalyKind::ClimateFlatline: return "climate_flatline";
+        default:                           return "?";
+    }
+}
+
+void AnomalyDetector::set(AnomalyKind kind, bool on, uint32_t nowMs, uint32_t& raised) {
+    Alarm& alarm = alarms[(int)kind];
+    if (!on) {
+        clear(kind);
+        return;
+    }
+    if (!isActive(kind)) {
+        active |= 1u << (int)kind;
+        raised |= 1u << (int)kind;
+        alarm.raised++;
+        alarm.sinceMs = nowMs;
+    }
+    alarm.lastMs = nowMs;
+}
+
+void AnomalyDetector::clearLatched() {
+    active &= ~ANOMALY_LATCHED;
+    waterRef = -1;              // new leak reference from the next sample
+    waterLossSeen = false;
+}
+
+uint32_t AnomalyDetector::update(const AnomalySample& s) {
+    const uint32_t now = s.nowMs;
+    const bool haveSoil = s.soilPercentage >= 0;
+    const bool haveWater = s.waterPercentage >= 0;
+    const bool haveClimate = climateValid(s.temperature) && climateValid(s.humidity);
+    uint32_t raised = 0;
+
+    // Latched alarms get one retry after ANOMALY_LATCH_S; a refill clears them
+    for (int k = 0; k < (int)AnomalyKind::COUNT; k++) {
+        if ((ANOMALY_LATCHED & active & (1u << k)) && now - alarms[k].sinceMs >= ANOMALY_LATCH_S * 1000UL) {
+            clear((AnomalyKind)k);
+            if (k == (int)AnomalyKind::WaterLoss) {
+                waterRef = -1;
+                waterLossSeen = false;
+            }
+        }
+    }
+    if (haveWater) {
+        if (waterLow < 0 || s.waterPercentage < waterLow) {
+            waterLow = s.waterPercentage;
+        } else if (s.waterPercentage >= waterLow + ANOMALY_REFILL_PCT) {
+            waterLow = s.waterPercentage;
+            clearLatched();
+        }
+    }
+
+    // Jumps against the previous cycle; a dropout in between is not a jump
+    if (havePrevious) {
+        bool soilJump = haveSoil && previous.soilPercentage >= 0 &&
+                        abs(s.soilPercentage - previous.soilPercentage) > ANOMALY_SOIL_JUMP_PCT;
+        bool waterJump = haveWater && previous.waterPercentage >= 0 &&
+                         previous.waterPercentage - s.waterPercentage > ANOMALY_WATER_JUMP_PCT;   // rises are refills
+        bool climateJump = haveClimate && climateValid(previous.temperature) && climateValid(previous.humidity) &&
+                           (fabsf(s.temperature - previous.temperature) > ANOMALY_TEMP_JUMP_C ||
+                            fabsf(s.humidity - previous.humidity) > ANOMALY_HUM_JUMP_PCT);
+        const AnomalyKind kinds[] = { AnomalyKind::SoilJump, AnomalyKind::WaterJump, AnomalyKind::ClimateJump };
+        const bool jumped[] = { soilJump, waterJump, climateJump };
+        for (int i = 0; i < 3; i++) {
+            if (jumped[i]) {
+                set(kinds[i], true, now, raised);
+            } else if (isActive(kinds[i]) && now - alarms[(int)kinds[i]].lastMs >= ANOMALY_JUMP_HOLD_S * 1000UL) {
+                clear(kinds[i]);
+            }
+        }
+    }
+
+    // Flatlines: real readings carry noise, a stuck or floating input does not
+    // (ADC noise for soil). A clamped 0 or 100 % is a real state, not a stuck probe.
+    const bool soilClamped = s.soilPercentage <= 0 || s.soilPercentage >= 100;
+    const bool haveSoilRaw = haveSoil && s.soilRaw >= 0 && !soilClamped;
+    if (haveSoilRaw && (s.soilRaw != lastSoilRaw || !havePrevious)) {
+        soilChangedMs = now;
+    }
+    lastSoilRaw = haveSoilRaw ? s.soilRaw : -1;
+    set(AnomalyKind::SoilFlatline, haveSoilRaw && now - soilChangedMs >= ANOMALY_FLATLINE_S * 1000UL, now, raised);
+    if (haveClimate) {
+        int32_t t = centi(s.temperature);
+        int32_t h = centi(s.humidity);
+        if (t != lastTemperature || h != lastHumidity || !havePrevious) {
+            lastTemperature = t;
+            lastHumidity = h;
+            climateChangedMs = now;
+        }
+    }
+    set(AnomalyKind::ClimateFlatline, haveClimate && now - climateChangedMs >= ANOMALY_FLATLINE_S * 1000UL,
+        now, raised);
+
+    // Pump runs: the soil should rise or the reservoir fall
+    if (s.pumpOn && !pumpRunning) {
+        pumpRunning = true;
+        runStartMs = now;
+        runStartSoil = haveSoil ? s.soilPercentage : -1;
+        runStartWater = haveWater ? s.waterPercentage : -1;
+        runSoilRose = false;
+        runWaterFell = false;
+    } else if (!s.pumpOn && pumpRunning) {
+        pumpRunning = false;
+        waterRef = -1;          // the reservoir settles from here
+        waterLossSeen = false;
+    }
+    if (pumpRunning) {
+        if (haveSoil && runStartSoil >= 0 && s.soilPercentage >= runStartSoil + ANOMALY_SOIL_RISE_PCT) {
+            runSoilRose = true;
+        }
+        if (haveWater && runStartWater >= 0 && s.waterPercentage <= runStartWater - ANOMALY_WATER_FALL_PCT) {
+            runWaterFell = true;
+        }
+        uint32_t running = now - runStartMs;
+        if (!runSoilRose && !runWaterFell && running >= ANOMALY_PUMP_FLOW_S * 1000UL) {
+            set(AnomalyKind::PumpNoFlow, true, now, raised);
+        }
+        if (runWaterFell && !runSoilRose && running >= ANOMALY_PUMP_SOIL_S * 1000UL) {
+            set(AnomalyKind::PumpNoSoil, true, now, raised);
+        }
+    } else if (haveWater) {
+        // Pump off: the reservoir may only fall slowly (evaporation). The
+        // reference is retaken every ANOMALY_LEAK_WINDOW_S and on any rise.
+        if (waterRef < 0 || s.waterPercentage > waterRef || now - waterRefMs >= ANOMALY_LEAK_WINDOW_S * 1000UL) {
+            if (!waterLossSeen) {
+                waterRef = s.waterPercentage;
+                waterRefMs = now;
+            }
+        }
+        if (waterRef >= 0 && waterRef - s.waterPercentage >= ANOMALY_LEAK_PCT) {
+            if (!waterLossSeen) {
+                waterLossSeen = true;
+                waterLossSinceMs = now;
+            } else if (now - waterLossSinceMs >= ANOMALY_LEAK_CONFIRM_S * 1000UL) {
+                set(AnomalyKind::WaterLoss, true, now, raised);
+            }
+        } else {
+            waterLossSeen = false;
+        }
+    }
+
+    previous = s;
+    havePrevious = true;
+    return raised;
+}
+
+size_t AnomalyDetector::formatReport(char* buffer, size_t size, uint32_t nowMs) const {
+    int n = snprintf(buffer, size, "blocks_pump: %s\n\n%-17s %7s %7s %9s %9s\n", blocksPump() ? "yes" : "no",
+                     "alarm", "active", "raised", "since_s", "last_s");
+    size_t used = n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+    for (int k = 0; k < (int)AnomalyKind::COUNT && used < size; k++) {
+        const Alarm& alarm = alarms[k];
+        bool on = isActive((AnomalyKind)k);
+        char since[12] = "-";
+        char last[12] = "-";
+        if (on) {
+            snprintf(since, sizeof(since), "%lu", (unsigned long)((nowMs - alarm.sinceMs) / 1000));
+        }
+        if (alarm.raised) {
+            snprintf(last, sizeof(last), "%lu", (unsigned long)((nowMs - alarm.lastMs) / 1000));
+        }
+        n = snprintf(buffer + used, size - used, "%-17s %7s %7lu %9s %9s%s\n", kindName((AnomalyKind)k),
+                     on ? "yes" : "no", (unsigned long)alarm.raised, since, last,
+                     (ANOMALY_BLOCKING & (1u << k)) ? "  (blocks pump)" : "");
+        used = n < 0 ? used : ((size_t)n < size - used ? used + n : size - 1);
+    }
+    return used;
+}
@@ -0,0 +1,108 @@
+#ifndef ANOMALYDETECTOR_H
+#define ANOMALYDETECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+// Streaming plausibility checks on the sensor readings and the pump, run once
+// per sensor cycle before the pump decision. Constant memory: the previous
+// sample, one reference point per check and per-alarm counters. Arduino-free;
+// the trace replayer runs it too.
+//
+// Pump checks correlate the relay with the readings: while it runs the soil
+// should rise or the reservoir fall, and while it is off the reservoir should
+// not fall. Signal checks flag jumps no real soil, tank or room can make in
+// one cycle, and values that stop moving altogether (a stuck or disconnected
+// sensor reads the same value every time; real readings carry noise). Soil is
+// checked on the raw ADC value: a healthy probe can hold one percentage for
+// hours, and soil dried out to the clamped 0 % (or soaked to 100 %) is real.
+//
+// Alarms in ANOMALY_BLOCKING stop the pump and hold off automatic starts
+// (decidePump's anomaly argument) from the cycle they are raised in. Pump
+// and leak alarms latch: they clear when the reservoir is refilled, after
+// ANOMALY_LATCH_S (one retry), or by clearLatched().
+enum class AnomalyKind : uint8_t {
+    PumpNoFlow,         // pump on, neither soil nor water moved: dry pump, blocked hose
+    PumpNoSoil,         // pump on, water falls but soil does not rise: hose off, probe misplaced
+    WaterLoss,          // reservoir falls with the pump off: leak
+    SoilJump,           // soil moved more than ANOMALY_SOIL_JUMP_PCT in one cycle
+    WaterJump,          // reservoir dropped more than ANOMALY_WATER_JUMP_PCT in one cycle
+    ClimateJump,        // temperature or humidity jumped
+    SoilFlatline,       // identical raw soil ADC value for ANOMALY_FLATLINE_S, off the 0/100 % ends
+    ClimateFlatline,    // identical temperature and humidity for ANOMALY_FLATLINE_S
+    COUNT
+};
+
+#define ANOMALY_BIT(kind) (1u << (int)(AnomalyKind::kind))
+#define ANOMALY_BLOCKING (ANOMALY_BIT(PumpNoFlow) | ANOMALY_BIT(PumpNoSoil) | ANOMALY_BIT(WaterLoss) | \
+                          ANOMALY_BIT(SoilJump) | ANOMALY_BIT(WaterJump))
+
+struct AnomalySample {
+    uint32_t nowMs;
+    bool pumpOn;                // relay state going into this cycle's decision
+    int soilPercentage;         // -1 if unavailable
+    int soilRaw;                // ADC value behind soilPercentage, -1 if unavailable
+    int waterPercentage;
+    float temperature;          // SENSOR_NO_READING if unavailable
+    float humidity;
+};
+
+class AnomalyDetector {
+public:
+    AnomalyDetector();
+
+    // Returns the alarms raised by this sample (not those already active)
+    uint32_t update(const AnomalySample& sample);
+
+    uint32_t getActive() const { return active; }
+    bool blocksPump() const { return (active & ANOMALY_BLOCKING) != 0; }
+    void clearLatched();
+
+    size_t formatReport(char* buffer, size_t size, uint32_t nowMs) const;
+    static const char* kindName(AnomalyKind kind);
+
+private:
+    struct Alarm {
+        uint32_t raised;        // times raised
+        uint32_t sinceMs;       // raised at, while active
+        uint32_t lastMs;        // last raised
+    };
+
+    Alarm alarms[(int)AnomalyKind::COUNT];
+    uint32_t active;
+
+    // Previous sample, for jumps
+    bool havePrevious;
+    AnomalySample previous;
+
+    // Pump run: readings when the relay came on
+    bool pumpRunning;
+    uint32_t runStartMs;
+    int runStartSoil;
+    int runStartWater;
+    bool runSoilRose;
+    bool runWaterFell;
+
+    // Reservoir reference while the pump is off, for WaterLoss
+    uint32_t waterRefMs;
+    int waterRef;
+
+    // Reservoir low point since the last refill
+    int waterLow;
+    bool waterLossSeen;         // loss condition holds, since waterLossSinceMs
+    uint32_t waterLossSinceMs;
+
+    // Last change per flatline channel
+    int lastSoilRaw;
+    uint32_t soilChangedMs;
+    int32_t lastTemperature;    // hundredths
+    int32_t lastHumidity;
+    uint32_t climateChangedMs;
+
+    void set(AnomalyKind kind, bool on, uint32_t nowMs, uint32_t& raised);
+    void clear(AnomalyKind kind) { active &= ~(1u << (int)kind); }
+    bool isActive(AnomalyKind kind) const { return (active & (1u << (int)kind)) != 0; }
+};
+
+#endif // ANOMALYDETECTOR_H
@@ -1,8 +1,18 @@
 #include "AuthManager.h"
+#include "BootProfiler.h"
 #include <cstring>
+#include <algorithm>
 
 AuthManager::AuthManager(const char* user, const char* pass)
-    : username(user), password(pass), isAuthenticated(false) {
+    : username(user), password(pass), isAuthenticated(false), networkCount(0),
+      lastScanTime(0), scanFailedTime(0), scanFailed(false), scanInProgress(false), scanPending(false), scanGeneration(0), networkOptionsLength(0),
+      settings(nullptr) {
+    networkOptions[0] = '\0';
+}
+
+void AuthManager::setSettingsStore(SettingsStore* store) {
+    settings = store;
+    station.setSettingsStore(store);
 }
 
 bool AuthManager::validateCredentials(const char* user, const char* pass) const {
@@ -12,24 +22,139 @@ bool AuthManager::validateCredentials(const char* user, const char* pass) const
     return (strcmp(user, username) == 0 && strcmp(pass, password) == 0);
 }
 
-void AuthManager::scanNetworks() {
-    networkList.clear();
-    int n = WiFi.scanNetworks();
+bool AuthManager::isScanCacheFresh() const {
+    return scanGeneration > 0 && millis() - lastScanTime < NETWORK_SCAN_TTL_MS;
+}
+
+void AuthManager::requestNetworkScan(bool force) {
+    // Concurrent refresh requests coalesce into the scan already running
+    if (scanInProgress || scanPending) {
+        return;
+    }
+    if (!force && isScanCacheFresh()) {
+        return;
+    }
+    // After a failed scan, on-demand requests wait one TTL (even with no cache yet)
+    if (!force && scanFailed && millis() - scanFailedTime < NETWORK_SCAN_TTL_MS) {
+        return;
+    }
+    scanPending = true;
+    startScan();
+}
+
+void AuthManager::startScan() {
+    // Scanning hops channels and would disturb an association in progress
+    if (station.isConnecting()) {
+        return;
+    }
+    
+    int16_t result = WiFi.scanNetworks(true);
+    if (result == WIFI_SCAN_FAILED) {
+        Serial.println("WiFi scan could not be started, will retry");
+        return;
+    }
+    scanPending = false;
+    scanInProgress = true;
+}
+
+bool AuthManager::updateNetworkScan() {
+    if (scanPending && !scanInProgress) {
+        startScan();
+        return false;
+    }
+    if (!scanInProgress) {
+        return false;
+    }
+    
+    int16_t n = WiFi.scanComplete();
+    if (n == WIFI_SCAN_RUNNING) {
+        return false;
+    }
+    scanInProgress = false;
+    BootProfiler::end("wifi-scan");   // no-op after the boot scan
+    if (n < 0) {
+        Serial.println("WiFi scan failed, keeping cached results");
+        scanFailed = true;
+        scanFailedTime = millis();
+        return false;
+    }
+    
+    // Results go straight into the fixed table; when it is full the weakest entry is replaced
+    networkCount = 0;
     for (int i = 0; i < n; ++i) {
-        networkList.push_back(WiFi.SSID(i));
+        char ssid[33];
+        strlcpy(ssid, WiFi.SSID(i).c_str(), sizeof(ssid));
+        if (ssid[0] == '\0') {
+            continue;   // hidden network
+        }
+        int32_t rssi = WiFi.RSSI(i);
+        
+        int existing = -1;
+        for (uint8_t j = 0; j < networkCount; j++) {
+            if (strcmp(networks[j].ssid, ssid) == 0) {
+                existing = j;
+                break;
+            }
+        }
+        
+        NetworkInfo* slot;
+        if (existing >= 0) {
+            if (rssi <= networks[existing].rssi) {
+                continue;
+            }
+            slot = &networks[existing];
+        } else if (networkCount < MAX_NETWORKS) {
+            slot = &networks[networkCount++];
+        } else {
+            slot = std::min_element(networks, networks + networkCount,
+                [](const NetworkInfo& a, const NetworkInfo& b) { return a.rssi < b.rssi; });
+            if (slot->rssi >= rssi) {
+                continue;
+            }
+        }
+        memcpy(slot->ssid, ssid, sizeof(ssid));
+        slot->rssi = rssi;
+        slot->channel = WiFi.channel(i);
+        slot->authMode = WiFi.encryptionType(i);
     }
+    WiFi.scanDelete();
+    
+    std::sort(networks, networks + networkCount, [](const NetworkInfo& a, const NetworkInfo& b) {
+        return a.rssi > b.rssi;
+    });
+    
+    rebuildNetworkOptions();
+    lastScanTime = millis();
+    scanFailed = false;
+    scanGeneration++;
+    Serial.printf("WiFi scan complete: %d networks (%d unique)\n", n, (int)networkCount);
+    return true;
 }
 
-String AuthManager::getNetworksAsOptions() const {
-    String options;
-    for (const String& network : networkList) {
-        options += "<option value=\"" + network + "\">" + network + "</option>";
+void AuthManager::rebuildNetworkOptions() {
+    ArenaWriter options(networkOptions, sizeof(networkOptions));
+    size_t complete = 0;
+    for (uint8_t i = 0; i < networkCount && !options.overflowed(); i++) {
+        const NetworkInfo& network = networks[i];
+        size_t ssidLength = strlen(network.ssid);
+        options.append("<option value=\"");
+        options.appendHtmlEscaped(network.ssid, ssidLength);
+        options.append("\">");
+        options.appendHtmlEscaped(network.ssid, ssidLength);
+        options.appendf(" (%d dBm%s)</option>", (int)network.rssi,
+                        network.authMode == WIFI_AUTH_OPEN ? ", open" : "");
+        if (!options.overflowed()) {
+            complete = options.length();
+        }
     }
-    return options;
+    // Never send a half-written <option>
+    networkOptions[complete] = '\0';
+    networkOptionsLength = complete;
 }
 
-String AuthManager::getLoginPageHTML() const {
-    String html = R"delimiter(
+// Login page is served in three pieces so nothing is copied per request:
+// static prefix (flash), cached <option> block (rebuilt only after a scan), static suffix (flash)
+static const char LOGIN_PAGE_PREFIX[] PROGMEM = R"delimiter(
 <!DOCTYPE html>
 <html>
 <head>
@@ -99,8 +224,20 @@ String AuthManager::getLoginPageHTML() const {
     </style>
     <script>
         function refreshNetworks() {
+            fetch('/scan-networks?refresh=1')
+                .then(response => response.json())
+                .then(status => waitForScan(status.generation));
+        }
+        function waitForScan(generation) {
             fetch('/scan-networks')
-                .then(response => window.location.reload());
+                .then(response => response.json())
+                .then(status => {
+                    if (status.generation != generation || !status.scanning) {
+                        window.location.reload();
+                    } else {
+                        setTimeout(() => waitForScan(generation), 1000);
+                    }
+                });
         }
     </script>
 </head>
@@ -111,7 +248,9 @@ String AuthManager::getLoginPageHTML() const {
         <form action="/connect" method="POST">
             <select name="network" required>
                 <option value="">Select WiFi Network</option>
-                %NETWORK_LIST%
+)delimiter";
+
+static const char LOGIN_PAGE_SUFFIX[] PROGMEM = R"delimiter(
             </select><br>
             <input type="password" name="wifi_password" placeholder="WiFi Password" required><br>
             <input type="text" name="username" placeholder="Login Username" required><br>
@@ -123,28 +262,43 @@ String AuthManager::getLoginPageHTML() const {
 </body>
 </html>
 )delimiter";
-    
-    html.replace("%NETWORK_LIST%", getNetworksAsOptions());
-    return html;
+
+const char* AuthManager::getLoginPagePrefix() {
+    return LOGIN_PAGE_PREFIX;
+}
+
+size_t AuthManager::getLoginPagePrefixLength() {
+    return sizeof(LOGIN_PAGE_PREFIX) - 1;
+}
+
+const char* AuthManager::getLoginPageSuffix() {
+    return LOGIN_PAGE_SUFFIX;
+}
+
+size_t AuthManager::getLoginPageSuffixLength() {
+    return sizeof(LOGIN_PAGE_SUFFIX) - 1;
+}
+
+size_t AuthManager::getLoginPageLength() const {
+    return getLoginPagePrefixLength() + networkOptionsLength + getLoginPageSuffixLength();
 }
 
 void AuthManager::initAccessPoint() {
     Serial.println("Initializing WiFi Access Point for ESP32-S3...");
     
-    // ESP32-S3 specific: Complete reset and initialization sequence
+    // ESP32-S3 specific: Complete reset and initialization sequence.
+    // mode() is synchronous; the AP start is awaited on its event bit below
+    // instead of fixed settle delays.
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
-    delay(500);
     
     // Enable WiFi in AP mode
     WiFi.mode(WIFI_AP);
-    delay(500);
     
     // Configure and start AP with simpler parameters for ESP32-S3
     Serial.println("Starting Access Point: GrowBox_Setup");
-    bool apSuccess = WiFi.softAP("GrowBox_Setup");
-    
-    delay(1000);  // Give more time for AP to stabilize on S3
+    bool apSuccess = WiFi.softAP("GrowBox_Setup") &&
+                     (WiFi.waitStatusBits(AP_STARTED_BIT, AP_START_TIMEOUT_MS) & AP_STARTED_BIT);
     
     if (apSuccess) {
         IPAddress IP = WiFi.softAPIP();
@@ -162,18 +316,15 @@ void AuthManager::initAccessPoint() {
         
         // Alternative approach with explicit IP configuration
         WiFi.mode(WIFI_OFF);
-        delay(500);
         WiFi.mode(WIFI_AP);
-        delay(500);
         
         IPAddress local_IP(192, 168, 4, 1);
         IPAddress gateway(192, 168, 4, 1);
         IPAddress subnet(255, 255, 255, 0);
         
         WiFi.softAPConfig(local_IP, gateway, subnet);
-        apSuccess = WiFi.softAP("GrowBox_Setup", "", 1, 0, 4);
-        
-        delay(1000);
+        apSuccess = WiFi.softAP("GrowBox_Setup", "", 1, 0, 4) &&
+                    (WiFi.waitStatusBits(AP_STARTED_BIT, AP_START_TIMEOUT_MS) & AP_STARTED_BIT);
         
         if (apSuccess) {
             IPAddress IP = WiFi.softAPIP();
@@ -187,36 +338,23 @@ void AuthManager::initAccessPoint() {
     }
 }
 
-bool AuthManager::connectToWiFi(const String& ssid, const String& password) {
-    if (WiFi.status() == WL_CONNECTED && WiFi.SSID() == ssid) {
-        Serial.println("Already connected to the requested network!");
-        return true;
+bool AuthManager::updateProvisioning() {
+    if (!station.update()) {
+        return false;
     }
-    
-    WiFi.disconnect(true);
-    delay(1000);
-    WiFi.mode(WIFI_AP_STA);
-    delay(1000);
-    
-    WiFi.begin(ssid.c_str(), password.c_str());
-    
-    Serial.print("Attempting to connect to: ");
-    Serial.println(ssid);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
+    // Joining a network (entered on /connect or stored) logs the user in
+    isAuthenticated = true;
+    if (settings) {
+        settings->setAuthenticated(true);
     }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nConnected successfully!");
-        Serial.print("IP Address: ");
-        Serial.println(WiFi.localIP());
-        return true;
+    return true;
+}
+
+const char* AuthManager::getProvisioningStateName() const {
+    switch (station.getProvisioningState()) {
+        case ProvisioningState::Connecting: return "connecting";
+        case ProvisioningState::Connected:  return "connected";
+        case ProvisioningState::Failed:     return "failed";
+        default:                            return "idle";
     }
-    
-    Serial.println("\nConnection failed!");
-    return false;
 }
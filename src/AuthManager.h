@@ -3,14 +3,47 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <vector>
+#include <functional>
+#include "Config.h"
+#include "RequestArena.h"
+#include "SettingsStore.h"
+#include "StationManager.h"
+
+#define MAX_NETWORKS          24     // scan results kept (strongest first)
+#define NETWORK_OPTIONS_SIZE  3072   // pre-rendered <option> block
+
+// One entry of the cached network scan (deduplicated by SSID, strongest BSSID wins)
+struct NetworkInfo {
+    char ssid[33];
+    int32_t rssi;
+    uint8_t channel;
+    wifi_auth_mode_t authMode;
+};
 
 class AuthManager {
 private:
     const char* username;
     const char* password;
     bool isAuthenticated;
-    std::vector<String> networkList;
+    NetworkInfo networks[MAX_NETWORKS];
+    uint8_t networkCount;
+    
+    // Background scan cache
+    unsigned long lastScanTime;
+    unsigned long scanFailedTime;
+    bool scanFailed;           // the last scan failed; on-demand rescans wait one TTL
+    bool scanInProgress;
+    bool scanPending;          // refresh requested while a scan could not start yet
+    uint32_t scanGeneration;   // increments every time networkList is replaced
+    char networkOptions[NETWORK_OPTIONS_SIZE];   // pre-rendered <option> block for the login page
+    size_t networkOptionsLength;
+    
+    void startScan();
+    void rebuildNetworkOptions();
+    
+    // STA link: stored networks, /connect provisioning and link recovery
+    StationManager station;
+    SettingsStore* settings;
     
 public:
     AuthManager(const char* user = "admin", const char* pass = "password123");
@@ -19,12 +52,43 @@ public:
     bool isUserAuthenticated() const { return isAuthenticated; }
     void setAuthenticated(bool state) { isAuthenticated = state; }
     
-    void scanNetworks();
-    String getNetworksAsOptions() const;
-    String getLoginPageHTML() const;
+    // Asynchronous network scan - never blocks; results land in the cache
+    void requestNetworkScan(bool force = false);
+    bool updateNetworkScan();   // call every loop; true when the cache was refreshed
+    bool isScanInProgress() const { return scanInProgress || scanPending; }
+    bool isScanCacheFresh() const;
+    uint32_t getScanGeneration() const { return scanGeneration; }
+    uint8_t getNetworkCount() const { return networkCount; }
+    const NetworkInfo& getNetwork(uint8_t index) const { return networks[index]; }
+    
+    // Login page pieces: prefix + getNetworkOptions() + suffix
+    static const char* getLoginPagePrefix();
+    static size_t getLoginPagePrefixLength();
+    static const char* getLoginPageSuffix();
+    static size_t getLoginPageSuffixLength();
+    const char* getNetworkOptions() const { return networkOptions; }
+    size_t getNetworkOptionsLength() const { return networkOptionsLength; }
+    size_t getLoginPageLength() const;
     
     static void initAccessPoint();
-    static bool connectToWiFi(const String& ssid, const String& password);
+    
+    // Networks are stored here on success; reconnectStored() joins them after a reboot
+    void setSettingsStore(SettingsStore* store);
+    bool reconnectStored() { return station.begin(); }
+    
+    // Non-blocking STA connect: returns immediately, progress via getProvisioningState()
+    void startProvisioning(const char* ssid, const char* password) { station.connect(ssid, password); }
+    bool updateProvisioning();   // call every loop; true each time the STA link comes up
+    ProvisioningState getProvisioningState() const { return station.getProvisioningState(); }
+    const char* getProvisioningStateName() const;
+    const char* getProvisioningSsid() const { return station.getProvisioningSsid(); }
+    unsigned long getProvisioningElapsed() const { return station.getProvisioningElapsed(); }
+    uint8_t getLastDisconnectReason() const { return station.getLastDisconnectReason(); }
+    const StationManager& getStation() const { return station; }
+    
+    // Called from the WiFi event task after connect/disconnect/scan-done so the
+    // loop can be woken (e.g. Scheduler::notify) instead of polling
+    void setWiFiEventCallback(std::function<void()> callback) { station.setEventCallback(callback); }
 };
 
 #endif // AUTHMANAGER_H
@@ -0,0 +1,20 @@
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <stddef.h>
+
+// Fixed-size records by key. SettingsStore keeps them in NVS; host tools
+// (tools/sensor_backend_check.cpp) use one in RAM. Lets Arduino-free code such
+// as SensorManagerBase persist its calibration curves.
+class BlobStore {
+public:
+    // Fails unless the stored size matches
+    virtual bool getBlob(const char* key, void* data, size_t size) = 0;
+    virtual void putBlob(const char* key, const void* data, size_t size) = 0;
+    virtual void removeBlob(const char* key) = 0;
+
+protected:
+    ~BlobStore() {}
+};
+
+#endif // BLOBSTORE_H
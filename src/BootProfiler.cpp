@@ -0,0 +1,167 @@
+#include "BootProfiler.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <cstring>
+
+#define BOOT_PROFILE_MAGIC 0x424F4F54UL   // "BOOT"
+
+// Survives everything except power-on/brownout (and is garbage after those)
+struct BootRetained {
+    uint32_t magic;
+    BootTimeline current;
+    BootTimeline previous;
+};
+
+static RTC_NOINIT_ATTR BootRetained retained;
+static portMUX_TYPE profilerLock = portMUX_INITIALIZER_UNLOCKED;
+
+const char* BootProfiler::resetReasonName(uint8_t reason) {
+    switch (reason) {
+        case ESP_RST_POWERON:   return "power-on";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "int-wdt";
+        case ESP_RST_TASK_WDT:  return "task-wdt";
+        case ESP_RST_WDT:       return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deep-sleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "sdio";
+        default:                return "unknown";
+    }
+}
+
+bool BootProfiler::isColdReset(uint8_t reason) {
+    return reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || reason == ESP_RST_UNKNOWN;
+}
+
+static uint32_t nowMicros() {
+    return (uint32_t)esp_timer_get_time();
+}
+
+void BootProfiler::begin() {
+    uint8_t reason = (uint8_t)esp_reset_reason();
+    bool valid = retained.magic == BOOT_PROFILE_MAGIC && !isColdReset(reason) &&
+                 retained.current.phaseCount <= BOOT_MAX_PHASES;
+
+    if (valid) {
+        retained.previous = retained.current;
+    } else {
+        memset(&retained, 0, sizeof(retained));
+        retained.magic = BOOT_PROFILE_MAGIC;
+    }
+
+    BootTimeline& t = retained.current;
+    uint32_t bootNumber = valid ? retained.previous.bootNumber + 1 : 1;
+    memset(&t, 0, sizeof(t));
+    t.bootNumber = bootNumber;
+    t.resetReason = reason;
+    t.setupUs = nowMicros();
+}
+
+void BootProfiler::start(const char* phase) {
+    uint32_t now = nowMicros();
+    portENTER_CRITICAL(&profilerLock);
+    BootTimeline& t = retained.current;
+    if (t.phaseCount < BOOT_MAX_PHASES) {
+        BootPhaseRecord& p = t.phases[t.phaseCount++];
+        strncpy(p.name, phase, sizeof(p.name) - 1);
+        p.name[sizeof(p.name) - 1] = '\0';
+        p.startUs = now;
+        p.durationUs = BOOT_PHASE_OPEN;
+        p.core = (uint8_t)xPortGetCoreID();
+    } else if (t.dropped < 0xFF) {
+        t.dropped++;
+    }
+    portEXIT_CRITICAL(&profilerLock);
+}
+
+void BootProfiler::end(const char* phase) {
+    uint32_t now = nowMicros();
+    portENTER_CRITICAL(&profilerLock);
+    BootTimeline& t = retained.current;
+    for (uint8_t i = t.phaseCount; i-- > 0;) {
+        BootPhaseRecord& p = t.phases[i];
+        if (p.durationUs == BOOT_PHASE_OPEN && strncmp(p.name, phase, sizeof(p.name) - 1) == 0) {
+            p.durationUs = now - p.startUs;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&profilerLock);
+}
+
+void BootProfiler::mark(const char* phase) {
+    start(phase);
+    end(phase);
+}
+
+void BootProfiler::finish() {
+    if (retained.current.readyUs != 0) {
+        return;
+    }
+    retained.current.readyUs = nowMicros();
+    printReport();
+}
+
+bool BootProfiler::isFinished() {
+    return retained.current.readyUs != 0;
+}
+
+uint32_t BootProfiler::getReadyMicros() {
+    return retained.current.readyUs;
+}
+
+void BootProfiler::printReport() {
+    const BootTimeline& t = retained.current;
+    Serial.printf("[boot] #%lu (%s reset), setup() at %lu us, ready at %lu us\n",
+                  (unsigned long)t.bootNumber, resetReasonName(t.resetReason),
+                  (unsigned long)t.setupUs, (unsigned long)t.readyUs);
+    for (uint8_t i = 0; i < t.phaseCount; i++) {
+        const BootPhaseRecord& p = t.phases[i];
+        if (p.durationUs == BOOT_PHASE_OPEN) {
+            Serial.printf("[boot]   %-15s %9lu us  (running)  core %u\n",
+                          p.name, (unsigned long)p.startUs, (unsigned)p.core);
+        } else {
+            Serial.printf("[boot]   %-15s %9lu us +%9lu us  core %u\n",
+                          p.name, (unsigned long)p.startUs, (unsigned long)p.durationUs, (unsigned)p.core);
+        }
+    }
+}
+
+size_t BootProfiler::formatTimeline(char* buffer, size_t size, const char* title, const BootTimeline& t) {
+    int n = snprintf(buffer, size,
+                     "[%s]\nboot_number: %lu\nreset_reason: %s\nsetup_us: %lu\nready_us: %lu\ndropped: %u\n"
+                     "%-15s %10s %12s %4s\n",
+                     title, (unsigned long)t.bootNumber, resetReasonName(t.resetReason),
+                     (unsigned long)t.setupUs, (unsigned long)t.readyUs, (unsigned)t.dropped,
+                     "phase", "start_us", "duration_us", "core");
+    size_t used = n < 0 ? 0 : (size_t)n;
+    uint8_t count = t.phaseCount <= BOOT_MAX_PHASES ? t.phaseCount : BOOT_MAX_PHASES;
+    for (uint8_t i = 0; i < count && used < size; i++) {
+        const BootPhaseRecord& p = t.phases[i];
+        if (p.durationUs == BOOT_PHASE_OPEN) {
+            n = snprintf(buffer + used, size - used, "%-15.15s %10lu %12s %4u\n",
+                         p.name, (unsigned long)p.startUs, "-", (unsigned)p.core);
+        } else {
+            n = snprintf(buffer + used, size - used, "%-15.15s %10lu %12lu %4u\n",
+                         p.name, (unsigned long)p.startUs, (unsigned long)p.durationUs, (unsigned)p.core);
+        }
+        used += n < 0 ? 0 : (size_t)n;
+    }
+    return used < size ? used : size - 1;
+}
+
+size_t BootProfiler::formatReport(char* buffer, size_t size) {
+    int n = snprintf(buffer, size, "build: %s %s\n\n", __DATE__, __TIME__);
+    size_t used = n < 0 ? 0 : (size_t)n;
+    if (used < size) {
+        used += formatTimeline(buffer + used, size - used, "current", retained.current);
+    }
+    if (retained.previous.bootNumber != 0 && used + 1 < size) {
+        buffer[used++] = '\n';
+        used += formatTimeline(buffer + used, size - used, "previous", retained.previous);
+    }
+    return used < size ? used : size - 1;
+}
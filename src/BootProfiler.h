@@ -0,0 +1,61 @@
+#ifndef BOOTPROFILER_H
+#define BOOTPROFILER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Boot timeline with microsecond timestamps (esp_timer, time since reset).
+//
+// setup() and the code it calls open and close named phases; phases may
+// overlap (the network init task runs next to sensor init) and record the
+// core they ran on. The timeline lives in RTC_NOINIT memory, so after a
+// software/watchdog/panic restart the previous boot's timeline is still
+// there next to the new one: /debug/boot shows both, which makes warm
+// restarts comparable with cold starts. A power-on starts a fresh record.
+struct BootPhaseRecord {
+    char name[BOOT_PHASE_NAME_LEN];
+    uint32_t startUs;
+    uint32_t durationUs;    // BOOT_PHASE_OPEN while running
+    uint8_t core;
+};
+
+struct BootTimeline {
+    uint32_t bootNumber;    // boots since the last power-on
+    uint8_t resetReason;    // esp_reset_reason_t
+    uint8_t phaseCount;
+    uint8_t dropped;        // phases that did not fit
+    uint32_t setupUs;       // when setup() started
+    uint32_t readyUs;       // 0 until finish()
+    BootPhaseRecord phases[BOOT_MAX_PHASES];
+};
+
+class BootProfiler {
+public:
+    // Times a phase for the lifetime of the object
+    class Scope {
+    public:
+        explicit Scope(const char* phase) : phase(phase) { start(phase); }
+        ~Scope() { end(phase); }
+    private:
+        const char* phase;
+    };
+
+    static void begin();                    // first line of setup()
+    static void start(const char* phase);
+    static void end(const char* phase);     // closes the open phase with this name; no-op otherwise
+    static void mark(const char* phase);    // zero-length event
+    static void finish();                   // boot complete: stamp ready time and print the report
+
+    static bool isFinished();
+    static uint32_t getReadyMicros();
+    static void printReport();
+    static size_t formatReport(char* buffer, size_t size);
+    
+    static const char* resetReasonName(uint8_t reason);    // esp_reset_reason_t
+    static bool isColdReset(uint8_t reason);                // RTC memory is garbage after these
+
+private:
+    static size_t formatTimeline(char* buffer, size_t size, const char* title, const BootTimeline& timeline);
+};
+
+#endif // BOOTPROFILER_H
@@ -0,0 +1,137 @@
+#include "Calibration.h"
+#include <math.h>
+#include <algorithm>
+
+CalibrationCurve::CalibrationCurve(uint16_t maxInput, uint8_t lutShift)
+    : data(), inputMax(maxInput), shift(lutShift), lutSize(0), lut() {
+    lutSize = (uint8_t)std::min((maxInput >> lutShift) + 2, CAL_LUT_SIZE);
+}
+
+bool CalibrationCurve::isValid(const CalibrationData& candidate) const {
+    if (candidate.version != CAL_DATA_VERSION ||
+        (candidate.mode != CalibrationMode::Linear && candidate.mode != CalibrationMode::Spline) ||
+        candidate.pointCount < 2 || candidate.pointCount > CAL_MAX_POINTS) {
+        return false;
+    }
+    for (uint8_t i = 0; i < candidate.pointCount; i++) {
+        if (candidate.points[i].raw > inputMax || candidate.points[i].percent > 100) {
+            return false;
+        }
+        for (uint8_t j = 0; j < i; j++) {
+            if (candidate.points[j].raw == candidate.points[i].raw) {
+                return false;   // two percentages for one raw value
+            }
+        }
+    }
+    return true;
+}
+
+bool CalibrationCurve::set(const CalibrationData& newData) {
+    if (!isValid(newData)) {
+        return false;
+    }
+    data = newData;
+    buildTable();
+    return true;
+}
+
+void CalibrationCurve::buildTable() {
+    // Runs only when the curve changes, so floats are fine here. set() only
+    // passes valid curves; the guard keeps the slope pass in bounds regardless
+    uint8_t n = data.pointCount;
+    if (n < 2 || n > CAL_MAX_POINTS) {
+        return;
+    }
+    // Insertion sort: at most CAL_MAX_POINTS points
+    CalibrationPoint p[CAL_MAX_POINTS] = {};
+    for (uint8_t k = 0; k < n; k++) {
+        uint8_t j = k;
+        while (j > 0 && p[j - 1].raw > data.points[k].raw) {
+            p[j] = p[j - 1];
+            j--;
+        }
+        p[j] = data.points[k];
+    }
+
+    // Fritsch-Carlson tangents keep the spline monotone between monotone points
+    float m[CAL_MAX_POINTS] = {};
+    float d[CAL_MAX_POINTS] = {};
+    for (uint8_t k = 0; k + 1 < n; k++) {
+        d[k] = ((float)p[k + 1].percent - p[k].percent) / ((float)p[k + 1].raw - p[k].raw);
+    }
+    m[0] = d[0];
+    m[n - 1] = d[n - 2];
+    for (uint8_t k = 1; k + 1 < n; k++) {
+        m[k] = d[k - 1] * d[k] <= 0.0f ? 0.0f : (d[k - 1] + d[k]) / 2.0f;
+    }
+    for (uint8_t k = 0; k + 1 < n; k++) {
+        if (d[k] == 0.0f) {
+            m[k] = m[k + 1] = 0.0f;
+            continue;
+        }
+        float a = m[k] / d[k];
+        float b = m[k + 1] / d[k];
+        float s = a * a + b * b;
+        if (s > 9.0f) {
+            float t = 3.0f / sqrtf(s);
+            m[k] = t * a * d[k];
+            m[k + 1] = t * b * d[k];
+        }
+    }
+
+    uint8_t segment = 0;
+    for (uint8_t i = 0; i < lutSize; i++) {
+        uint32_t x = std::min((uint32_t)i << shift, (uint32_t)inputMax);
+        float y;
+        if (x <= p[0].raw) {
+            y = p[0].percent;
+        } else if (x >= p[n - 1].raw) {
+            y = p[n - 1].percent;
+        } else {
+            while (x > p[segment + 1].raw) {
+                segment++;
+            }
+            float h = (float)p[segment + 1].raw - p[segment].raw;
+            float t = (x - p[segment].raw) / h;
+            float y0 = p[segment].percent;
+            float y1 = p[segment + 1].percent;
+            if (data.mode == CalibrationMode::Spline) {
+                float t2 = t * t;
+                float t3 = t2 * t;
+                y = (2 * t3 - 3 * t2 + 1) * y0 + (t3 - 2 * t2 + t) * h * m[segment] +
+                    (-2 * t3 + 3 * t2) * y1 + (t3 - t2) * h * m[segment + 1];
+            } else {
+                y = y0 + (y1 - y0) * t;
+            }
+        }
+        lut[i] = (int16_t)lroundf(std::max(0.0f, std::min(y, 100.0f)) * 256.0f);
+    }
+}
+
+int CalibrationCurve::evaluateQ8(int raw) const {
+    raw = std::max(0, std::min(raw, (int)inputMax));
+    int i = raw >> shift;
+    int frac = raw - (i << shift);
+    if (frac == 0) {
+        return lut[i];
+    }
+    return lut[i] + (((int32_t)(lut[i + 1] - lut[i]) * frac) >> shift);
+}
+
+int CalibrationCurve::compensate(const CalibrationData& curve, int raw, float temperature) {
+    if (curve.tempCoeffQ8 == 0 || temperature <= -998.0f) {
+        return raw;
+    }
+    // Undo the drift: the sensor reads tempCoeff counts higher per degree above tempRef
+    int32_t deltaTenths = lroundf(temperature * 10.0f) - (int32_t)curve.tempRefC * 10;
+    return raw - (int)((int32_t)curve.tempCoeffQ8 * deltaTenths / 2560);
+}
+
+int CalibrationCurve::evaluate(int raw, float temperature) const {
+    int q8 = evaluateQ8(compensate(raw, temperature));
+    return std::max(0, std::min((q8 + 128) >> 8, 100));
+}
+
+const char* CalibrationCurve::modeName(CalibrationMode mode) {
+    return mode == CalibrationMode::Spline ? "spline" : "linear";
+}
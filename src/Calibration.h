@@ -0,0 +1,77 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+// Raw sensor value -> percentage through a calibration curve.
+//
+// A curve is defined by up to CAL_MAX_POINTS (raw, percent) breakpoints,
+// joined either linearly or by a monotone cubic spline (no overshoot between
+// points). Whenever the points change they are resampled into a fixed-stride
+// table of Q8 percentages, one entry every 2^shift raw counts, so evaluation
+// is an index, one multiply and a shift - no search, no floats.
+// Between entries the table is linear, so a breakpoint that does not fall on
+// a multiple of 2^shift is not hit exactly: the knee is rounded off by up to
+// |slope change| * 2^shift / 4 percent (tools/sensor_backend_check.cpp measures
+// it). Put breakpoints on the stride where the knee matters.
+//
+// Optional temperature compensation shifts the raw value by
+// tempCoeffQ8 / 256 counts per degree C away from tempRefC before lookup.
+//
+// CalibrationData is stored as-is in NVS (see SettingsStore::putBlob) and in
+// sensor traces (TraceFormat.h), so CAL_DATA_VERSION must change whenever its
+// layout does. No Arduino dependencies: tools/trace_replay.cpp builds this file
+// on the host.
+#define CAL_DATA_VERSION 1
+#define CAL_LUT_SIZE 66             // enough for a 12-bit ADC at shift 6
+
+enum class CalibrationMode : uint8_t {
+    Linear,
+    Spline
+};
+
+struct CalibrationPoint {
+    uint16_t raw;
+    uint8_t percent;
+};
+
+struct CalibrationData {
+    uint8_t version;
+    CalibrationMode mode;
+    uint8_t pointCount;
+    int16_t tempCoeffQ8;            // raw counts per degree C, Q8; 0 = off
+    int8_t tempRefC;
+    CalibrationPoint points[CAL_MAX_POINTS];
+};
+
+class CalibrationCurve {
+private:
+    CalibrationData data;
+    uint16_t inputMax;
+    uint8_t shift;
+    uint8_t lutSize;
+    int16_t lut[CAL_LUT_SIZE];      // percent * 256 at raw = i << shift
+
+    void buildTable();
+
+public:
+    // Raw inputs are clamped to 0..maxInput; the table has (maxInput >> lutShift) + 2 entries
+    CalibrationCurve(uint16_t maxInput, uint8_t lutShift);
+
+    // Validates and applies; false leaves the current curve untouched
+    bool set(const CalibrationData& newData);
+    const CalibrationData& get() const { return data; }
+    uint16_t getInputMax() const { return inputMax; }
+
+    int evaluateQ8(int raw) const;
+    int evaluate(int raw, float temperature) const;   // 0-100, temperature <= -998 skips compensation
+    int compensate(int raw, float temperature) const { return compensate(data, raw, temperature); }
+    static int compensate(const CalibrationData& curve, int raw, float temperature);
+
+    bool isValid(const CalibrationData& candidate) const;
+    static const char* modeName(CalibrationMode mode);
+};
+
+#endif // CALIBRATION_H
@@ -0,0 +1,165 @@
+#include "CaptiveDns.h"
+#include <lwip/sockets.h>
+
+#define DNS_HEADER_SIZE 12
+#define DNS_TTL_SECONDS 60
+#define DNS_QTYPE_A     1
+#define DNS_QTYPE_ANY   255
+#define DNS_TASK_STACK  3072
+#define DNS_TASK_PRIORITY 2   // above loop() (1), well below the WiFi/lwIP tasks
+
+CaptiveDnsServer::CaptiveDnsServer()
+    : sock(-1), task(nullptr), stats(), secondStart(0), queriesAtSecondStart(0) {
+    memset(answerTemplate, 0, sizeof(answerTemplate));
+}
+
+bool CaptiveDnsServer::start(const IPAddress& ip, uint16_t port) {
+    if (task) {
+        return true;
+    }
+    
+    // Answer record is identical for every query - build it once
+    const uint8_t answer[16] = {
+        0xC0, 0x0C,                         // name: pointer to the question at offset 12
+        0x00, DNS_QTYPE_A,                  // type A
+        0x00, 0x01,                         // class IN
+        0x00, 0x00, 0x00, DNS_TTL_SECONDS,  // TTL
+        0x00, 0x04,                         // RDLENGTH
+        ip[0], ip[1], ip[2], ip[3]
+    };
+    memcpy(answerTemplate, answer, sizeof(answerTemplate));
+    
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        Serial.println("Captive DNS: socket() failed");
+        return false;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        Serial.println("Captive DNS: bind() failed");
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    // Wake at least once a second to roll the queries/sec counter
+    struct timeval timeout = { 1, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    secondStart = millis();
+    if (xTaskCreatePinnedToCore(taskEntry, "captive_dns", DNS_TASK_STACK, this,
+                                DNS_TASK_PRIORITY, &task, tskNO_AFFINITY) != pdPASS) {
+        Serial.println("Captive DNS: task creation failed");
+        close(sock);
+        sock = -1;
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void CaptiveDnsServer::taskEntry(void* arg) {
+    static_cast<CaptiveDnsServer*>(arg)->run();
+}
+
+void CaptiveDnsServer::run() {
+    for (;;) {
+        struct sockaddr_in client;
+        socklen_t clientLength = sizeof(client);
+        
+        // Block for the first query, then drain whatever else is queued
+        int length = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr*)&client, &clientLength);
+        uint32_t batch = 0;
+        while (length >= 0) {
+            batch++;
+            handlePacket(length, client);
+            clientLength = sizeof(client);
+            length = recvfrom(sock, packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr*)&client, &clientLength);
+        }
+        if (batch > stats.maxBatch) {
+            stats.maxBatch = batch;
+        }
+        updateRate();
+    }
+}
+
+void CaptiveDnsServer::handlePacket(int length, const struct sockaddr_in& client) {
+    stats.queries++;
+    
+    // Standard query (QR=0, OPCODE=0) with exactly one question
+    if (length < DNS_HEADER_SIZE + 5 || (packet[2] & 0xF8) != 0 ||
+        packet[4] != 0 || packet[5] != 1) {
+        stats.dropped++;
+        return;
+    }
+    
+    // Walk the QNAME labels (no compression allowed in a question)
+    int pos = DNS_HEADER_SIZE;
+    while (pos < length && packet[pos] != 0) {
+        if (packet[pos] & 0xC0) {
+            stats.dropped++;
+            return;
+        }
+        pos += packet[pos] + 1;
+    }
+    pos++;   // terminating zero label
+    if (pos + 4 > length) {
+        stats.dropped++;
+        return;
+    }
+    uint16_t qtype = (uint16_t)((packet[pos] << 8) | packet[pos + 1]);
+    pos += 4;   // QTYPE + QCLASS
+    
+    // Turn the query into the response in place; anything after the question
+    // (EDNS OPT records) is dropped
+    bool answer = (qtype == DNS_QTYPE_A || qtype == DNS_QTYPE_ANY) &&
+                  pos + (int)sizeof(answerTemplate) <= (int)sizeof(packet);
+    packet[2] = 0x84 | (packet[2] & 0x01);   // QR, AA, keep RD
+    packet[3] = 0x80;                        // RA, NOERROR
+    packet[6] = 0;
+    packet[7] = answer ? 1 : 0;              // ANCOUNT
+    packet[8] = packet[9] = 0;               // NSCOUNT
+    packet[10] = packet[11] = 0;             // ARCOUNT
+    if (answer) {
+        memcpy(&packet[pos], answerTemplate, sizeof(answerTemplate));
+        pos += sizeof(answerTemplate);
+        stats.answered++;
+    } else {
+        stats.emptyAnswers++;
+    }
+    
+    if (sendto(sock, packet, pos, 0, (const struct sockaddr*)&client, sizeof(client)) < 0) {
+        stats.sendErrors++;
+    }
+}
+
+void CaptiveDnsServer::updateRate() {
+    uint32_t now = millis();
+    if (now - secondStart < 1000) {
+        return;
+    }
+    uint32_t elapsed = now - secondStart;
+    uint32_t rate = (stats.queries - queriesAtSecondStart) * 1000 / elapsed;
+    stats.queriesPerSecond = rate;
+    if (rate > stats.peakQueriesPerSecond) {
+        stats.peakQueriesPerSecond = rate;
+    }
+    queriesAtSecondStart = stats.queries;
+    secondStart = now;
+}
+
+CaptiveDnsStats CaptiveDnsServer::getStats() const {
+    CaptiveDnsStats copy;
+    copy.queries = stats.queries;
+    copy.answered = stats.answered;
+    copy.emptyAnswers = stats.emptyAnswers;
+    copy.dropped = stats.dropped;
+    copy.sendErrors = stats.sendErrors;
+    copy.queriesPerSecond = stats.queriesPerSecond;
+    copy.peakQueriesPerSecond = stats.peakQueriesPerSecond;
+    copy.maxBatch = stats.maxBatch;
+    return copy;
+}
@@ -0,0 +1,45 @@
+#ifndef CAPTIVEDNS_H
+#define CAPTIVEDNS_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Wildcard DNS responder for the setup AP. Runs in its own FreeRTOS task so
+// portal detection keeps working while loop() is busy with sensors or I2C.
+// Every wakeup drains all queued queries; A/ANY questions are answered with a
+// precomputed record pointing at the AP, everything else gets an empty NOERROR.
+struct CaptiveDnsStats {
+    uint32_t queries;
+    uint32_t answered;
+    uint32_t emptyAnswers;     // non-A questions (AAAA, HTTPS, ...)
+    uint32_t dropped;          // malformed / not a standard query
+    uint32_t sendErrors;
+    uint32_t queriesPerSecond; // last full second
+    uint32_t peakQueriesPerSecond;
+    uint32_t maxBatch;         // most queries drained in one wakeup
+};
+
+class CaptiveDnsServer {
+private:
+    int sock;
+    TaskHandle_t task;
+    uint8_t answerTemplate[16];   // compressed name ptr, A, IN, TTL, RDLENGTH, IPv4
+    uint8_t packet[512];
+    volatile CaptiveDnsStats stats;
+    uint32_t secondStart;
+    uint32_t queriesAtSecondStart;
+    
+    static void taskEntry(void* arg);
+    void run();
+    void handlePacket(int length, const struct sockaddr_in& client);
+    void updateRate();
+    
+public:
+    CaptiveDnsServer();
+    bool start(const IPAddress& ip, uint16_t port = 53);
+    CaptiveDnsStats getStats() const;
+};
+
+#endif // CAPTIVEDNS_H
@@ -0,0 +1,30 @@
+#include "ClimateDriver.h"
+#include "Ens210Driver.h"
+#include "Sht4xDriver.h"
+#include <Wire.h>
+
+namespace {
+Ens210Driver ens210Driver;
+Sht4xDriver sht4xDriver;
+
+// Probe order: the on-PCB ENS210 of the current boards first
+ClimateDriver* const registry[] = {
+    &ens210Driver,
+    &sht4xDriver,
+};
+
+bool acknowledges(uint8_t address) {
+    Wire.beginTransmission(address);
+    return Wire.endTransmission() == 0;
+}
+}
+
+ClimateDriver* ClimateDriver::probe() {
+    for (ClimateDriver* driver : registry) {
+        // An empty address NACKs straight away; skip the driver's reset delays
+        if (acknowledges(driver->address()) && driver->begin()) {
+            return driver;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,50 @@
+#ifndef CLIMATEDRIVER_H
+#define CLIMATEDRIVER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Temperature/humidity sensor drivers and the registry that picks one at boot.
+//
+// Every PCB revision carries one climate sensor on the shared I2C bus. probe()
+// tries the registered drivers in order (address ACK first, then the driver's
+// own identification) and returns the one that answered. Drivers keep the
+// sensor converting on its own, so fetch() reads the latest sample without
+// waiting for a conversion.
+//
+// Samples use the ENS210 raw units (1/64 K, 1/512 %RH) and status codes
+// whatever the sensor, so traces, replay and the conversion to C/%RH
+// (traceCentiCelsius/traceCentiHumidity) stay the same for every board.
+enum ClimateStatus : uint8_t {
+    CLIMATE_STATUS_OK = 1,
+    CLIMATE_STATUS_INVALID = 2,     // no conversion finished yet
+    CLIMATE_STATUS_CRCERROR = 3,
+    CLIMATE_STATUS_I2CERROR = 4
+};
+
+struct ClimateSample {
+    uint16_t tData;                 // 1/64 K
+    uint16_t hData;                 // 1/512 %RH
+    uint8_t tStatus;                // ClimateStatus
+    uint8_t hStatus;
+};
+
+class ClimateDriver {
+public:
+    virtual ~ClimateDriver() {}
+    virtual const char* name() const = 0;
+    virtual uint8_t address() const = 0;
+
+    // Identify the sensor and start sampling; false if it is not this part.
+    // Also the restart after a failure (a brown-out leaves the sensor idle).
+    virtual bool begin() = 0;
+
+    // Latest sample; an I2C failure reports CLIMATE_STATUS_I2CERROR
+    virtual ClimateSample fetch() = 0;
+
+    // First registered driver whose sensor answers, nullptr if none.
+    // Called inside an I2cBus transaction.
+    static ClimateDriver* probe();
+};
+
+#endif // CLIMATEDRIVER_H
@@ -3,6 +3,14 @@
 
 // WiFi configuration is now handled through the web interface
 // No need for hardcoded credentials - users configure via GrowBox_Setup AP
+#define WIFI_CONNECT_TIMEOUT_MS 15000   // Give up on a full scan-and-join after this long
+#define WIFI_TARGETED_TIMEOUT_MS 4000   // ...and on a join with the cached BSSID/channel
+#define WIFI_MAX_NETWORKS 4             // Stored networks, most recently used first
+#define WIFI_BACKOFF_MIN_MS 2000        // Wait after a round that joined nothing...
+#define WIFI_BACKOFF_MAX_MS 300000      // ...doubling up to this
+#define WIFI_LATENCY_BUCKETS 10         // Recovery-time histogram: < 250 ms doubling, last is open-ended
+#define AP_START_TIMEOUT_MS 2000        // Wait for the AP-started event, not a fixed delay
+#define NETWORK_SCAN_TTL_MS 60000       // Cached scan results are reused for this long
 
 // SHT40 sensor configuration (I2C)
 // ESP32-S3-Mini-1: Only GPIO 0-21 are exposed. GPIO 22+ are used internally for flash.
@@ -28,6 +36,28 @@
 #define WATER_LEVEL_THRESHOLD 100       // Capacitive touch threshold
 #define WATER_LEVEL_MAX_SECTIONS 20     // Total 20 sections (8 low + 12 high)
 
+// Temperature/humidity sensor: whichever answers is bound at boot (see ClimateDriver.h)
+#define ENS210_I2C_ADDR 0x43            // On-PCB sensor, run in continuous mode
+#define SHT4X_I2C_ADDR 0x44             // SHT40 breakout (-AD1B; the -BD1B variant is 0x45)
+#define SHT4X_CONVERSION_MS 9           // High-repeatability conversion (8.3 ms max)
+
+// I2C fault handling (see I2cBus.h)
+#define I2C_TIMEOUT_MS 10               // Per Wire transaction; a 12-byte read takes ~1.5 ms at 100 kHz
+#define I2C_BACKOFF_MIN_MS 1000         // First retry delay after a device stops answering
+#define I2C_BACKOFF_MAX_MS 60000        // Backoff doubles up to this
+#define I2C_RECOVERY_FAILURES 3         // Consecutive failures (no device answering) before a bus reset
+#define I2C_RECOVERY_INTERVAL_MS 60000  // Minimum time between bus resets
+#define I2C_CYCLE_BUDGET_MS 50          // I2C time per sensor cycle (climate fetch + two water reads is ~5 ms)
+
+// Calibration curves (see Calibration.h). These defaults reproduce the linear
+// mapping above and apply until a curve is stored through /calibration.
+#define CAL_MAX_POINTS 8                // Breakpoints per curve
+#define SOIL_CAL_LUT_SHIFT 6            // Soil table entry every 64 ADC counts
+#define SOIL_CAL_DEFAULT_POINTS  { { SOIL_WET_VALUE, 100 }, { SOIL_DRY_VALUE, 0 } }
+#define WATER_CAL_DEFAULT_POINTS { { 0, 0 }, { WATER_LEVEL_MAX_SECTIONS, 100 } }
+#define SOIL_TEMP_COEFF_Q8 0            // Soil raw counts per degree C * 256, 0 = no compensation
+#define CAL_TEMP_REF_C 25               // Temperature the curve points were taken at
+
 // Sensor power control pins (to prevent corrosion)
 #define SOIL_POWER_PIN 6       // ESP32-S3 safe GPIO
 #define WATER_POWER_PIN 7      // Not used for Grove Water Level Sensor (I2C powered)
@@ -42,6 +72,39 @@
 #define GROWLED_PWM 12         // PWM capable pin
 #define GROWLED_BOOST 13       // Third wire for additional grow LED power (toggle HIGH/LOW)
 
+// Automatic pump control (see PumpPolicy.h)
+#define PUMP_WATER_MIN_PCT 10  // Stop at or below this water level (dry-run protection)
+#define PUMP_SOIL_WET_PCT 60   // Stop once the soil is this wet (GREEN)
+#define PUMP_SOIL_DRY_PCT 20   // Start below this (RED) while water is above PUMP_WATER_MIN_PCT
+
+// Pump runtime limits, enforced from a hardware timer interrupt (see PumpGuard.h,
+// accounting at /debug/pump). The defaults only catch a runaway relay; tighten
+// them for your pump and pot.
+#define PUMP_MAX_ON_S 300              // longest continuous run, 0 = no limit
+#define PUMP_MIN_OFF_S 0               // rest after every run before the next start, 0 = none
+#define PUMP_FLOW_ML_PER_MIN 1000      // placeholder: measure your pump; converts on-time to volume
+#define PUMP_DAILY_BUDGET_ML 0         // per 24 h of uptime (not calendar days), 0 = no budget
+#define PUMP_GUARD_TIMER 0             // hardware timer group/index (timerBegin)
+#define PUMP_GUARD_TICK_MS 100         // accounting resolution and worst-case cutoff delay
+
+// Sensor and pump anomaly detection (see AnomalyDetector.h, /debug/anomaly)
+#define ANOMALY_BLOCKS_PUMP true       // false: report alarms only, never stop the pump for them
+#define ANOMALY_PUMP_FLOW_S 30         // pump on this long with no soil rise and no water fall
+#define ANOMALY_PUMP_SOIL_S 45         // water falling but soil not rising this long
+#define ANOMALY_SOIL_RISE_PCT 3        // soil rise that shows water arrives
+#define ANOMALY_WATER_FALL_PCT 5       // one water section
+#define ANOMALY_LEAK_PCT 10            // reservoir loss with the pump off...
+#define ANOMALY_LEAK_WINDOW_S 3600     // ...within this long (evaporation is far slower)
+#define ANOMALY_LEAK_CONFIRM_S 10      // loss must persist this long (sensor glitches)
+#define ANOMALY_REFILL_PCT 10          // reservoir rise that counts as a refill and clears latched alarms
+#define ANOMALY_SOIL_JUMP_PCT 30       // per sensor cycle
+#define ANOMALY_WATER_JUMP_PCT 30      // drop per sensor cycle
+#define ANOMALY_TEMP_JUMP_C 5
+#define ANOMALY_HUM_JUMP_PCT 20
+#define ANOMALY_JUMP_HOLD_S 60         // a jump alarm stays up this long after the last jump
+#define ANOMALY_FLATLINE_S 1800        // identical readings (raw ADC for soil) this long
+#define ANOMALY_LATCH_S 1800           // pump/leak alarms clear after this for one retry
+
 // WS2812B RGB LED pins (addressable) - ESP32-S3 compatible
 #define SOIL_LED_PIN 35        // Data pin for soil moisture WS2812B
 #define WATER_LED_PIN 36       // Data pin for water level WS2812B
@@ -52,6 +115,14 @@
 #define GMT_OFFSET_SEC 0
 #define DAYLIGHT_OFFSET_SEC 3600
 
+// Boot
+#define SERIAL_WAIT_MS 0                // Set to e.g. 2000 to catch early logs on USB CDC
+#define SETTINGS_NAMESPACE "growbox"    // NVS namespace for credentials and settings
+#define SETTINGS_SAVE_INTERVAL_MS 30000 // Changed device settings are written at most this often
+#define BOOT_MAX_PHASES 20              // Boot profiler phases kept per boot (RTC memory)
+#define BOOT_PHASE_NAME_LEN 16          // Including the terminator
+#define BOOT_PHASE_OPEN 0xFFFFFFFFUL    // Duration of a phase that has not ended
+
 // Button debounce
 #define DEBOUNCE_DELAY 200
 
@@ -59,7 +130,76 @@
 // Set to 0 to disable periodic readings (only read on dashboard access)
 #define AUTO_SENSOR_INTERVAL 1000  // 1 second
 
+// Scheduler job periods (in milliseconds), see Scheduler.h
+#define WEB_CLIENT_TICK_MS       20        // handleClient() tick while a client is open (WebServer's own timeouts)
+#define WEB_READY_TASK_STACK     2048      // task that select()s on the HTTP sockets and wakes the loop
+#define NETWORK_POLL_INTERVAL_MS 1000      // join timeouts and backoff; WiFi events wake the job directly
+#define LED_REFRESH_INTERVAL_MS  1000
+#define LOG_INTERVAL_MS          1000
+#define ACTUATOR_APPLY_INTERVAL_MS 50      // queued web commands are applied this often
+#define NTP_RESYNC_INTERVAL_MS   3600000UL // 1 hour
+
+// Control-loop deadlines (see DeadlineMonitor.h, report at /debug/deadline)
+#define CONTROL_WDT_TIMEOUT_S 10       // task watchdog on the loop task, fed only by completed sensor cycles
+#define DEADLINE_CLIMATE_MS 50         // fetch of the latest sample, no conversion wait
+#define DEADLINE_WATER_MS 50           // two short I2C reads
+#define DEADLINE_SOIL_MS 300           // 250 ms of probe power-up and settle delays
+#define DEADLINE_PUMP_MS 20
+#define DEADLINE_CYCLE_LATE_MS 500     // a sensor cycle starting this late is a miss too
+
+// HTTP admission control (see HttpAdmission.h), checked before any handler runs
+#define HTTP_CLIENT_RATE_PER_SEC 5     // sustained requests per client IP
+#define HTTP_CLIENT_BURST 15           // a dashboard load plus favicon and fetches fits easily
+#define HTTP_GLOBAL_RATE_PER_SEC 20    // all clients together
+#define HTTP_GLOBAL_BURST 40
+#define HTTP_HEAVY_COST 3              // tokens for routes that render or read sensors
+#define HTTP_ADMISSION_CLIENTS 8       // tracked client IPs, the longest idle is reused
+
+// HTTPS front end (see HttpsProxy.h, counters at /debug/tls): TLS 1.2 with an
+// ECDSA P-256 identity generated on first boot and kept in NVS. The setup AP
+// stays on plain HTTP (captive-portal browsers refuse a self-signed
+// certificate); on the STA link plain HTTP is redirected to HTTPS_PORT.
+#define HTTPS_ENABLED true
+#define HTTPS_PORT 443
+#define HTTPS_HOSTNAME "growbox.local"   // certificate CN and SAN, with the AP address
+#define HTTPS_MAX_CONNECTIONS 2          // open TLS connections, ~22 KB each (mbedTLS buffers, response head)
+#define HTTPS_IDLE_TIMEOUT_S 30          // kept-alive connections idle this long are closed
+#define HTTPS_HANDSHAKE_TIMEOUT_MS 3000  // a client stalled mid-handshake loses its slot
+#define HTTPS_CLIENT_TIMEOUT_MS 500      // reads and writes on an established connection
+#define HTTPS_IO_TIMEOUT_MS 5000         // web server response, waited for without blocking other clients
+#define HTTPS_HEAD_MAX 2048              // request/response head, larger requests get 431
+#define HTTPS_SESSION_CACHE 8            // session-ID resumption entries
+#define HTTPS_SESSION_LIFETIME_S 86400   // cached sessions and tickets
+
 // Simulation mode - set to true to enable manual sensor input
 #define SIMULATION_MODE false
 
+// Soak test - replays SOAK_DAYS of traffic in compressed time and fails on heap
+// growth (see SoakDriver.h, report at /debug/soak). Bench use only: it toggles
+// the pump and LEDs and starts reconnects.
+#define SOAK_TEST_MODE false
+#define SOAK_DAYS 30
+#define SOAK_MINUTE_MS 100                        // real ms per simulated minute (30 days ~ 72 min)
+#define SOAK_WIFI_SSID "GrowBoxSoak"              // reconnect target, normally absent
+#define SOAK_WIFI_PASSWORD "soak-test-password"
+
+// Binary UDP telemetry for fleet collection (decode with tools/telemetry_collector.cpp)
+// Frames are only sent while connected to an external network (STA mode).
+#define TELEMETRY_ENABLED false
+#define TELEMETRY_BOX_ID 1               // Unique per box in the fleet
+#define TELEMETRY_HOST "255.255.255.255" // Collector IP (broadcast by default)
+#define TELEMETRY_PORT 5170
+#define TELEMETRY_BATCH_SIZE 10          // Frames per datagram (one frame per sensor cycle)
+
+// Sensor trace recorder: raw acquisitions, button edges and pump decisions in a
+// RAM ring (see TraceRecorder.h). Download from /debug/trace and replay on a
+// host with tools/trace_replay.cpp.
+#define TRACE_RECORDER_ENABLED true
+#define TRACE_BUFFER_SIZE 16384          // ~16 bytes per sensor cycle: about 17 min at 1 s
+
+// Rolling 1 min / 1 h / 24 h statistics per channel (see SensorStats.h, /api/stats).
+// Buckets per window: the windows slide in 1/STATS_BUCKETS steps; RAM is
+// 6 channels x 3 windows x STATS_BUCKETS x 24 bytes (~8.6 KB at 20).
+#define STATS_BUCKETS 20
+
 #endif // CONFIG_H
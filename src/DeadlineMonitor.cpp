@@ -0,0 +1,219 @@
+#include "DeadlineMonitor.h"
+#include "BootProfiler.h"
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <cstring>
+
+#define DEADLINE_MAGIC 0x444C4E45UL     // "DLNE"
+#define DEADLINE_JOB_NAME_LEN 12
+
+// Kept current while the loop runs, so after a reset it says where it was
+struct DeadlineRecord {
+    uint32_t cycles;                    // completed control cycles
+    uint32_t misses;
+    uint32_t lastFeedMs;                // uptime of the last completed cycle (watchdog feed)
+    uint32_t phaseStartMs;
+    uint32_t jobStartMs;
+    uint32_t watchdogMs;                // uptime when the watchdog fired, 0 if it did not
+    uint8_t phase;                      // ControlPhase
+    char job[DEADLINE_JOB_NAME_LEN];    // scheduler job holding the loop task, "" between jobs
+};
+
+struct DeadlineRetained {
+    uint32_t magic;
+    DeadlineRecord current;
+    DeadlineRecord previous;
+};
+
+static RTC_NOINIT_ATTR DeadlineRetained retained;
+
+namespace {
+const uint16_t PHASE_BUDGET_MS[(int)ControlPhase::COUNT] = {
+    0, DEADLINE_CLIMATE_MS, DEADLINE_WATER_MS, DEADLINE_SOIL_MS, DEADLINE_PUMP_MS
+};
+
+DeadlinePhaseStats phaseStats[(int)ControlPhase::COUNT];
+uint8_t resetReason = 0;
+bool previousValid = false;
+bool watchdogArmed = false;
+uint32_t cycleStartMs = 0;
+uint32_t lateCycles = 0;
+
+// Longest scheduler job since the last cycle started, blamed for late cycles
+const char* runningJob = "";
+const char* longestJob = "";
+uint32_t longestJobUs = 0;
+
+char lastMiss[80] = "";
+uint32_t lastMissMs = 0;
+
+bool isWatchdogReset(uint8_t reason) {
+    return reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT ||
+           reason == ESP_RST_PANIC;
+}
+
+void recordMiss(uint32_t now) {
+    retained.current.misses++;
+    lastMissMs = now;
+    Serial.printf("DEADLINE MISS: %s\n", lastMiss);
+}
+}
+
+// ESP-IDF calls this weak hook from the task watchdog interrupt before it
+// panics; stamping the time lets the next boot say how long the hang lasted
+extern "C" void IRAM_ATTR esp_task_wdt_isr_user_handler(void) {
+    DeadlineMonitor::onWatchdog();
+}
+
+void IRAM_ATTR DeadlineMonitor::onWatchdog() {
+    retained.current.watchdogMs = (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+const char* DeadlineMonitor::phaseName(ControlPhase phase) {
+    switch (phase) {
+        case ControlPhase::Climate: return "climate";
+        case ControlPhase::Water:   return "water";
+        case ControlPhase::Soil:    return "soil";
+        case ControlPhase::Pump:    return "pump";
+        default:                    return "idle";
+    }
+}
+
+void DeadlineMonitor::begin() {
+    resetReason = (uint8_t)esp_reset_reason();
+    previousValid = retained.magic == DEADLINE_MAGIC && !BootProfiler::isColdReset(resetReason) &&
+                    retained.current.phase < (uint8_t)ControlPhase::COUNT;
+    if (previousValid) {
+        retained.previous = retained.current;
+        retained.previous.job[DEADLINE_JOB_NAME_LEN - 1] = '\0';
+    } else {
+        memset(&retained, 0, sizeof(retained));
+        retained.magic = DEADLINE_MAGIC;
+    }
+    memset(&retained.current, 0, sizeof(retained.current));
+    
+    if (previousValid && isWatchdogReset(resetReason)) {
+        const DeadlineRecord& p = retained.previous;
+        Serial.printf("Previous reset (%s): control phase %s, job '%s', %lu cycles, %lu deadline misses\n",
+                      BootProfiler::resetReasonName(resetReason), phaseName((ControlPhase)p.phase),
+                      p.job, (unsigned long)p.cycles, (unsigned long)p.misses);
+        if (p.watchdogMs) {
+            Serial.printf("  watchdog fired %lu ms after the last completed cycle, %lu ms into the %s\n",
+                          (unsigned long)(p.watchdogMs - p.lastFeedMs),
+                          (unsigned long)(p.watchdogMs - (p.phase ? p.phaseStartMs : p.jobStartMs)),
+                          p.phase ? "phase" : "job");
+        }
+    }
+}
+
+void DeadlineMonitor::armWatchdog() {
+#if AUTO_SENSOR_INTERVAL > 0
+    // Reconfigures the watchdog the core already started, then subscribes
+    // the calling (loop) task: from here on only completeCycle() feeds it
+    esp_task_wdt_init(CONTROL_WDT_TIMEOUT_S, true);
+    watchdogArmed = esp_task_wdt_add(nullptr) == ESP_OK;
+    Serial.printf("Control watchdog: %s, %d s\n", watchdogArmed ? "armed" : "FAILED", CONTROL_WDT_TIMEOUT_S);
+#endif
+}
+
+void DeadlineMonitor::startCycle() {
+    uint32_t now = millis();
+    uint32_t gap = now - cycleStartMs;
+    if (cycleStartMs != 0 && gap > AUTO_SENSOR_INTERVAL + DEADLINE_CYCLE_LATE_MS) {
+        lateCycles++;
+        snprintf(lastMiss, sizeof(lastMiss), "cycle late by %lu ms, longest job '%s' %lu ms",
+                 (unsigned long)(gap - AUTO_SENSOR_INTERVAL), longestJob, (unsigned long)(longestJobUs / 1000));
+        recordMiss(now);
+    }
+    cycleStartMs = now;
+    longestJob = "";
+    longestJobUs = 0;
+}
+
+void DeadlineMonitor::phase(ControlPhase next) {
+    uint32_t now = millis();
+    DeadlineRecord& r = retained.current;
+    ControlPhase running = (ControlPhase)r.phase;
+    if (running != ControlPhase::Idle) {
+        uint32_t elapsed = now - r.phaseStartMs;
+        DeadlinePhaseStats& stats = phaseStats[(int)running];
+        stats.runs++;
+        stats.lastMs = elapsed;
+        if (elapsed > stats.maxMs) {
+            stats.maxMs = elapsed;
+        }
+        if (elapsed > PHASE_BUDGET_MS[(int)running]) {
+            stats.misses++;
+            snprintf(lastMiss, sizeof(lastMiss), "%s took %lu ms (budget %u)", phaseName(running),
+                     (unsigned long)elapsed, (unsigned)PHASE_BUDGET_MS[(int)running]);
+            recordMiss(now);
+        }
+    }
+    r.phase = (uint8_t)next;
+    r.phaseStartMs = now;
+}
+
+void DeadlineMonitor::completeCycle() {
+    phase(ControlPhase::Idle);
+    retained.current.cycles++;
+    retained.current.lastFeedMs = millis();
+    if (watchdogArmed) {
+        esp_task_wdt_reset();
+    }
+}
+
+void DeadlineMonitor::enterJob(const char* name) {
+    DeadlineRecord& r = retained.current;
+    strncpy(r.job, name, DEADLINE_JOB_NAME_LEN - 1);
+    r.job[DEADLINE_JOB_NAME_LEN - 1] = '\0';
+    r.jobStartMs = millis();
+    runningJob = name;
+}
+
+void DeadlineMonitor::exitJob(uint32_t runtimeUs) {
+    retained.current.job[0] = '\0';
+    if (runtimeUs > longestJobUs) {
+        longestJobUs = runtimeUs;
+        longestJob = runningJob;
+    }
+}
+
+size_t DeadlineMonitor::formatReport(char* buffer, size_t size) {
+    const DeadlineRecord& r = retained.current;
+    size_t used = 0;
+    int n = snprintf(buffer, size,
+                     "watchdog: %s (%d s, fed by completed sensor cycles)\ncycles: %lu\nmisses: %lu\n"
+                     "late_cycles: %lu\nlast_miss: %s\nlast_miss_age_ms: %lu\n\n"
+                     "%-8s %6s %8s %7s %7s %7s\n",
+                     watchdogArmed ? "armed" : "off", CONTROL_WDT_TIMEOUT_S,
+                     (unsigned long)r.cycles, (unsigned long)r.misses, (unsigned long)lateCycles,
+                     lastMiss[0] ? lastMiss : "none", lastMissMs ? (unsigned long)(millis() - lastMissMs) : 0UL,
+                     "phase", "budget", "runs", "misses", "last", "max");
+    if (n < 0 || (size_t)n >= size) {
+        return n < 0 ? 0 : size - 1;
+    }
+    used = n;
+    for (int i = 1; i < (int)ControlPhase::COUNT && used < size; i++) {
+        const DeadlinePhaseStats& s = phaseStats[i];
+        n = snprintf(buffer + used, size - used, "%-8s %6u %8lu %7lu %7lu %7lu\n",
+                     phaseName((ControlPhase)i), (unsigned)PHASE_BUDGET_MS[i], (unsigned long)s.runs,
+                     (unsigned long)s.misses, (unsigned long)s.lastMs, (unsigned long)s.maxMs);
+        used = n < 0 ? used : ((size_t)n < size - used ? used + n : size - 1);
+    }
+    
+    if (previousValid && used < size) {
+        const DeadlineRecord& p = retained.previous;
+        n = snprintf(buffer + used, size - used,
+                     "\nprevious boot (reset: %s)\nphase: %s\njob: %s\ncycles: %lu\nmisses: %lu\n",
+                     BootProfiler::resetReasonName(resetReason), phaseName((ControlPhase)p.phase),
+                     p.job[0] ? p.job : "-", (unsigned long)p.cycles, (unsigned long)p.misses);
+        used = n < 0 ? used : ((size_t)n < size - used ? used + n : size - 1);
+        if (p.watchdogMs && used < size) {
+            n = snprintf(buffer + used, size - used, "watchdog_after_last_cycle_ms: %lu\n",
+                         (unsigned long)(p.watchdogMs - p.lastFeedMs));
+            used = n < 0 ? used : ((size_t)n < size - used ? used + n : size - 1);
+        }
+    }
+    return used;
+}
@@ -0,0 +1,53 @@
+#ifndef DEADLINEMONITOR_H
+#define DEADLINEMONITOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Control-loop deadline monitor and task watchdog owner.
+//
+// runSensorCycle() marks its phases (climate, water, soil, pump); each has a
+// budget in Config.h and a phase that runs over counts a miss. A cycle that
+// starts more than DEADLINE_CYCLE_LATE_MS after its period is a miss too,
+// charged to the longest scheduler job that ran since the previous cycle.
+//
+// The loop task is subscribed to the ESP-IDF task watchdog and the watchdog
+// is fed only by completeCycle(): if anything on the loop task hangs (an I2C
+// wait, a stuck client) the pump stops being controlled, the watchdog resets
+// the chip and the pump relay drops. The phase and scheduler job in progress
+// are kept in RTC memory at all times, so the next boot reports what hung.
+enum class ControlPhase : uint8_t {
+    Idle,           // between cycles: another scheduler job or sleeping
+    Climate,
+    Water,
+    Soil,
+    Pump,
+    COUNT
+};
+
+struct DeadlinePhaseStats {
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t lastMs;
+    uint32_t maxMs;
+};
+
+class DeadlineMonitor {
+public:
+    static void begin();                    // setup(): report the previous reset, keep its record
+    static void armWatchdog();              // end of setup(), from the loop task
+
+    static void startCycle();
+    static void phase(ControlPhase next);   // ends the running phase, starts the next
+    static void completeCycle();            // ends the last phase and feeds the watchdog
+
+    // Scheduler hooks: which job holds the loop task
+    static void enterJob(const char* name);
+    static void exitJob(uint32_t runtimeUs);
+
+    static void IRAM_ATTR onWatchdog();     // from the watchdog interrupt, before the reset
+    static size_t formatReport(char* buffer, size_t size);
+    static const char* phaseName(ControlPhase phase);
+};
+
+#endif // DEADLINEMONITOR_H
@@ -1,4 +1,7 @@
 #include "DeviceController.h"
+#include "BootProfiler.h"
+#include "TraceRecorder.h"
+#include "PumpGuard.h"
 
 DeviceController::DeviceController() 
     : pumpState(false), growLedState(false), lastBrightness(0), savedBrightness(50),
@@ -24,6 +27,7 @@ void DeviceController::begin() {
     analogWrite(GROWLED_PWM, 0);       // PWM 0 at startup - no light leaking through
     
     // Initialize WS2812B RGB LEDs
+    BootProfiler::Scope phase("neopixel");
     soilLED.begin();
     soilLED.setBrightness(255);  // Full brightness
     soilLED.clear();
@@ -38,11 +42,35 @@ void DeviceController::begin() {
 }
 
 void DeviceController::setPumpState(bool state) {
+    PumpTrip lockout;
+    if (state && !PumpGuard::mayStart(&lockout)) {
+        Serial.printf("Pump start refused: %s, %lu ms left\n", PumpGuard::tripName(lockout),
+                      (unsigned long)PumpGuard::lockoutRemainingMs());
+        TraceRecorder::recordPump(false, true);
+        pumpState = false;      // also catches up with a cut not yet synced
+        digitalWrite(PUMP_RELAY, LOW);
+        return;
+    }
+    if (state != pumpState) {
+        TraceRecorder::recordPump(state);
+    }
     pumpState = state;
     digitalWrite(PUMP_RELAY, pumpState);
     Serial.printf("Pump relay set to: %s (GPIO %d = %d)\n", pumpState ? "ON" : "OFF", PUMP_RELAY, pumpState);
 }
 
+void DeviceController::syncPumpGuard() {
+    PumpTrip trip;
+    if (!PumpGuard::takeCutoff(&trip)) {
+        return;
+    }
+    Serial.printf(">>> PUMP CUT by guard: %s\n", PumpGuard::tripName(trip));
+    if (pumpState) {
+        TraceRecorder::recordPump(false, true);
+        pumpState = false;
+    }
+}
+
 void DeviceController::togglePump() {
     Serial.printf("Toggle pump called - current state: %s\n", pumpState ? "ON" : "OFF");
     setPumpState(!pumpState);
@@ -110,6 +138,41 @@ void DeviceController::toggleGrowLedBoost() {
     setGrowLedBoostState(!growLedBoostState);
 }
 
+static bool resolveSwitch(SwitchCommand command, bool current) {
+    switch (command) {
+        case SwitchCommand::Off:    return false;
+        case SwitchCommand::On:     return true;
+        case SwitchCommand::Toggle: return !current;
+        default:                    return current;
+    }
+}
+
+void DeviceController::apply(const ActuatorCommands& commands) {
+    bool pump = resolveSwitch(commands.pump, pumpState);
+    bool growLed = resolveSwitch(commands.growLed, growLedState);
+    if (commands.brightness > 0 && commands.growLed == SwitchCommand::Keep) {
+        growLed = true;     // like /brightness/{}: a brightness turns the LED on
+    }
+    bool boost = resolveSwitch(commands.boost, growLedBoostState) && growLed;   // boost needs the grow LED
+    bool rgb = resolveSwitch(commands.rgbLeds, rgbLedsEnabled);
+    
+    if (pump != pumpState) {
+        setPumpState(pump);
+    }
+    if (growLed != growLedState) {
+        setGrowLedState(growLed);   // ON restores the saved brightness, OFF also drops boost
+    }
+    if (growLed && commands.brightness >= 0) {
+        updateGrowLEDBrightness(commands.brightness);
+    }
+    if (boost != growLedBoostState) {
+        setGrowLedBoostState(boost);
+    }
+    if (rgb != rgbLedsEnabled) {
+        setRGBLedsEnabled(rgb);
+    }
+}
+
 void DeviceController::setSoilRGBColor(int red, int green, int blue) {
     // Clamp values between 0 and 255
     red = constrain(red, 0, 255);
@@ -5,6 +5,24 @@
 #include <Adafruit_NeoPixel.h>
 #include "Config.h"
 
+// How one actuator changes in an ActuatorCommands transaction
+enum class SwitchCommand : uint8_t {
+    Keep,
+    Off,
+    On,
+    Toggle
+};
+
+// A batch of actuator changes for DeviceController::apply(); untouched
+// actuators keep their state
+struct ActuatorCommands {
+    SwitchCommand pump = SwitchCommand::Keep;
+    SwitchCommand growLed = SwitchCommand::Keep;
+    SwitchCommand boost = SwitchCommand::Keep;
+    SwitchCommand rgbLeds = SwitchCommand::Keep;
+    int8_t brightness = -1;     // 0-100, -1 = keep
+};
+
 class DeviceController {
 private:
     bool pumpState;
@@ -29,10 +47,11 @@ public:
     DeviceController();
     void begin();
     
-    // Pump control
+    // Pump control; starts are subject to PumpGuard
     void setPumpState(bool state);
     bool getPumpState() const { return pumpState; }
     void togglePump();
+    void syncPumpGuard();   // picks up a relay cut made by the PumpGuard interrupt
     
     // Grow LED control
     void setGrowLedState(bool state);
@@ -65,6 +84,11 @@ public:
     bool getRGBLedsEnabled() const { return rgbLedsEnabled; }
     void toggleRGBLeds();
     
+    // Applies a batch in one pass against the state before it: toggles resolve
+    // first, then only the actuators that change are written, grow LED before
+    // its brightness and boost. Interlocks as in the single setters.
+    void apply(const ActuatorCommands& commands);
+    
     // Button handling
     bool checkButton();
 };
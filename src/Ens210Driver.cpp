@@ -0,0 +1,39 @@
+#include "Ens210Driver.h"
+
+#define ENS210_CONVERSION_MS 130        // temperature then humidity
+
+static_assert(CLIMATE_STATUS_OK == ENS210_STATUS_OK && CLIMATE_STATUS_INVALID == ENS210_STATUS_INVALID &&
+              CLIMATE_STATUS_CRCERROR == ENS210_STATUS_CRCERROR && CLIMATE_STATUS_I2CERROR == ENS210_STATUS_I2CERROR,
+              "ClimateStatus mirrors the ENS210 status codes");
+
+bool Ens210Driver::begin() {
+    // begin() resets the sensor and checks the part id; Wire is already set up
+    // on our pins by I2cBus
+    firstConversion = ens210.begin() && ens210.startcont();
+    startedAt = millis();
+    return firstConversion;
+}
+
+ClimateSample Ens210Driver::fetch() {
+    ClimateSample sample = {};
+    if (firstConversion) {
+        unsigned long elapsed = millis() - startedAt;
+        if (elapsed < ENS210_CONVERSION_MS) {
+            delay(ENS210_CONVERSION_MS - elapsed);
+        }
+        firstConversion = false;
+    }
+    uint32_t tVal = 0, hVal = 0;
+    if (!ens210.read(&tVal, &hVal)) {
+        sample.tStatus = sample.hStatus = CLIMATE_STATUS_I2CERROR;
+        return sample;
+    }
+    int data = 0, status = 0;
+    ens210.extract(tVal, &data, &status);
+    sample.tData = (uint16_t)data;
+    sample.tStatus = (uint8_t)status;
+    ens210.extract(hVal, &data, &status);
+    sample.hData = (uint16_t)data;
+    sample.hStatus = (uint8_t)status;
+    return sample;
+}
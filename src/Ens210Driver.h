@@ -0,0 +1,24 @@
+#ifndef ENS210DRIVER_H
+#define ENS210DRIVER_H
+
+#include <ens210.h>
+#include "ClimateDriver.h"
+
+// ENS210 (on-PCB, ENS210_I2C_ADDR) in continuous mode: the sensor converts
+// temperature and humidity back to back on its own (~130 ms per pair) and
+// fetch() only reads the two result registers, with their CRC and valid bit.
+// Only the first fetch after begin() can wait, for the first pair.
+class Ens210Driver : public ClimateDriver {
+private:
+    ENS210 ens210;
+    unsigned long startedAt = 0;    // millis() of startcont()
+    bool firstConversion = false;   // no result registered yet
+
+public:
+    const char* name() const override { return "ens210"; }
+    uint8_t address() const override { return ENS210_I2C_ADDR; }
+    bool begin() override;
+    ClimateSample fetch() override;
+};
+
+#endif // ENS210DRIVER_H
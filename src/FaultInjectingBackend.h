@@ -0,0 +1,94 @@
+#ifndef FAULTINJECTINGBACKEND_H
+#define FAULTINJECTINGBACKEND_H
+
+#include <stdio.h>
+#include "SensorBackend.h"
+
+// Faults applied on top of another backend's readings
+struct SensorFaults {
+    bool climateDropout;        // temperature/humidity read as SENSOR_NO_READING
+    bool waterDropout;          // water level reads 0 sections (sensor absent)
+    bool soilStuck;             // soil repeats its last raw value
+    int16_t soilOffset;         // added to the raw soil value (drift)
+    uint8_t dropoutPercent;     // chance per cycle of a climate + water dropout, 0-100
+};
+
+// Wraps any backend and corrupts its readings on demand, to exercise the pump
+// interlocks and N/A paths. Random dropouts use a fixed-seed xorshift so a
+// host run is reproducible.
+template <class Inner>
+class FaultInjectingBackend {
+private:
+    Inner inner;
+    SensorFaults faults = {};
+    uint32_t rng = 0x2545F491u;
+    bool dropCycle = false;
+    int lastSoilRaw = -1;
+    uint32_t injected = 0;
+
+    bool roll() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng % 100 < faults.dropoutPercent;
+    }
+
+public:
+    void begin() { inner.begin(); }
+    void beginCycle() {
+        inner.beginCycle();
+        dropCycle = faults.dropoutPercent > 0 && roll();
+    }
+    void endCycle() { inner.endCycle(); }
+    void measureClimate() { inner.measureClimate(); }
+    float readTemperature() {
+        float value = inner.readTemperature();
+        if (faults.climateDropout || dropCycle) {
+            injected++;
+            return SENSOR_NO_READING;
+        }
+        return value;
+    }
+    float readHumidity() {
+        float value = inner.readHumidity();
+        if (faults.climateDropout || dropCycle) {
+            injected++;
+            return SENSOR_NO_READING;
+        }
+        return value;
+    }
+    int readSoilRaw() {
+        int raw = faults.soilStuck && lastSoilRaw >= 0 ? lastSoilRaw : inner.readSoilRaw();
+        lastSoilRaw = raw;
+        if (faults.soilStuck || faults.soilOffset != 0) {
+            injected++;
+        }
+        raw += faults.soilOffset;
+        return raw < 0 ? 0 : (raw > 4095 ? 4095 : raw);
+    }
+    int readWaterSections() {
+        int sections = inner.readWaterSections();
+        if (faults.waterDropout || dropCycle) {
+            injected++;
+            return 0;
+        }
+        return sections;
+    }
+    size_t formatDiagnostics(char* buffer, size_t size) const {
+        int n = snprintf(buffer, size,
+                         "backend: fault-injecting\nclimate_dropout: %d\nwater_dropout: %d\nsoil_stuck: %d\n"
+                         "soil_offset: %d\ndropout_pct: %u\ninjected: %lu\n\n",
+                         faults.climateDropout, faults.waterDropout, faults.soilStuck, (int)faults.soilOffset,
+                         (unsigned)faults.dropoutPercent, (unsigned long)injected);
+        size_t used = n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+        return used + inner.formatDiagnostics(buffer + used, size - used);
+    }
+    static const char* name() { return "fault-injecting"; }
+
+    Inner& getInner() { return inner; }
+    void setFaults(const SensorFaults& newFaults) { faults = newFaults; }
+    const SensorFaults& getFaults() const { return faults; }
+    uint32_t getInjected() const { return injected; }
+};
+
+#endif // FAULTINJECTINGBACKEND_H
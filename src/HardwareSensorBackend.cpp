@@ -0,0 +1,155 @@
+#include "HardwareSensorBackend.h"
+#include "BootProfiler.h"
+#include "TraceRecorder.h"
+
+void HardwareSensorBackend::begin() {
+    // I2C bus recovery (if SDA is stuck) and Wire setup
+    bus.begin();
+
+    // Temperature/humidity: bind whichever sensor this PCB revision carries
+    if (bus.acquire(I2cDevice::Climate)) {
+        BootProfiler::start("climate-probe");
+        startClimate();
+        BootProfiler::end("climate-probe");
+        bus.release(I2cDevice::Climate, climateReady);
+    }
+    if (!climateReady) {
+        Serial.printf("ERROR: no ENS210 (0x%02X) or SHT4x (0x%02X) found! Check SDA=GPIO18, SCL=GPIO17 (will retry)\n",
+                      ENS210_I2C_ADDR, SHT4X_I2C_ADDR);
+    }
+
+    // Check Grove Water Level Sensor
+    unsigned char probe[12];
+    bool lowOk = readSections(I2cDevice::WaterLow, WATER_LEVEL_I2C_ADDR_LOW, probe, 8);
+    bool highOk = readSections(I2cDevice::WaterHigh, WATER_LEVEL_I2C_ADDR_HIGH, probe, 12);
+    if (lowOk && highOk) {
+        Serial.println("Grove Water Level Sensor OK (0x77, 0x78)");
+    } else {
+        Serial.printf("WARNING: Grove Water Level - 0x77: %s, 0x78: %s\n",
+                     lowOk ? "OK" : "MISSING",
+                     highOk ? "OK" : "MISSING");
+    }
+
+    // Initialize sensor power pins as outputs and turn them OFF initially
+    pinMode(SOIL_POWER_PIN, OUTPUT);
+    digitalWrite(SOIL_POWER_PIN, LOW);
+    pinMode(WATER_POWER_PIN, OUTPUT);
+    digitalWrite(WATER_POWER_PIN, LOW);
+
+    Serial.printf("Sensor power pins initialized (Soil: GPIO%d, Water: GPIO%d)\n", SOIL_POWER_PIN, WATER_POWER_PIN);
+}
+
+bool HardwareSensorBackend::startClimate() {
+    if (climate) {
+        climateReady = climate->begin();
+    } else {
+        climate = ClimateDriver::probe();
+        climateReady = climate != nullptr;
+        if (climateReady) {
+            bus.identify(I2cDevice::Climate, climate->name(), climate->address());
+        }
+    }
+    if (climateReady) {
+        Serial.printf("Climate sensor: %s OK (0x%02X)\n", climate->name(), climate->address());
+    }
+    return climateReady;
+}
+
+void HardwareSensorBackend::measureClimate() {
+    if (!bus.acquire(I2cDevice::Climate)) {
+        // Backing off: report N/A. Over budget: keep the previous reading.
+        if (!bus.isHealthy(I2cDevice::Climate)) {
+            lastClimate.tStatus = lastClimate.hStatus = CLIMATE_STATUS_I2CERROR;
+            recordClimate();
+        }
+        return;
+    }
+    if (!climateReady && !startClimate()) {
+        // Missing at boot or after a failure: probe again once the backoff expires
+        lastClimate.tStatus = lastClimate.hStatus = CLIMATE_STATUS_I2CERROR;
+        bus.release(I2cDevice::Climate, false);
+        recordClimate();
+        return;
+    }
+    // The sensor converts on its own; this only reads the latest sample
+    lastClimate = climate->fetch();
+    bool ok = lastClimate.tStatus != CLIMATE_STATUS_I2CERROR && lastClimate.hStatus != CLIMATE_STATUS_I2CERROR;
+    // A sensor that dropped off the bus may have lost power and with it the
+    // continuous mode; restart it on the next attempt
+    climateReady = ok;
+    bus.release(I2cDevice::Climate, ok);
+    recordClimate();
+}
+
+void HardwareSensorBackend::recordClimate() {
+    TraceRecorder::recordClimate(lastClimate.tData, lastClimate.hData, lastClimate.tStatus, lastClimate.hStatus,
+                                 lastClimate.tStatus == CLIMATE_STATUS_OK,
+                                 lastClimate.hStatus == CLIMATE_STATUS_OK);
+}
+
+float HardwareSensorBackend::readTemperature() {
+    if (lastClimate.tStatus != CLIMATE_STATUS_OK) return SENSOR_NO_READING;
+    return traceCentiCelsius(lastClimate.tData) / 100.0f;
+}
+
+float HardwareSensorBackend::readHumidity() {
+    if (lastClimate.hStatus != CLIMATE_STATUS_OK) return SENSOR_NO_READING;
+    return traceCentiHumidity(lastClimate.hData) / 100.0f;
+}
+
+int HardwareSensorBackend::readSoilRaw() {
+    // Ensure both sensors are OFF before reading
+    digitalWrite(SOIL_POWER_PIN, LOW);
+    digitalWrite(WATER_POWER_PIN, LOW);
+    delay(50);
+    
+    // Power ON the soil sensor
+    digitalWrite(SOIL_POWER_PIN, HIGH);
+    delay(150); // Wait for sensor to stabilize
+    
+    int soilValue = analogRead(SOIL_SENSOR_PIN);
+    TraceRecorder::recordSoil(soilValue);
+    
+    // Power OFF the soil sensor to prevent corrosion
+    digitalWrite(SOIL_POWER_PIN, LOW);
+    delay(50); // Give time for pin to fully discharge
+    
+    return soilValue;
+}
+
+bool HardwareSensorBackend::readSections(I2cDevice device, uint8_t address, unsigned char* data, uint8_t length) {
+    memset(data, 0, length);
+    if (!bus.acquire(device)) {
+        return false;
+    }
+    
+    // requestFrom() blocks until the bytes arrive or the Wire timeout expires;
+    // an absent device NACKs and returns 0, so no separate probe is needed
+    uint8_t received = Wire.requestFrom(address, length);
+    for (uint8_t i = 0; i < received && i < length; i++) {
+        data[i] = Wire.read();
+    }
+    bool ok = received == length;
+    bus.release(device, ok);
+    return ok;
+}
+
+int HardwareSensorBackend::readWaterSections() {
+    unsigned char low_data[8] = {0};
+    unsigned char high_data[12] = {0};
+    
+    // Read data from both I2C addresses. A device that is backing off reads as
+    // zeros (no water - stops the pump); a read skipped for the cycle budget
+    // repeats the previous level instead.
+    bool lowOk = readSections(I2cDevice::WaterLow, WATER_LEVEL_I2C_ADDR_LOW, low_data, 8);
+    bool highOk = readSections(I2cDevice::WaterHigh, WATER_LEVEL_I2C_ADDR_HIGH, high_data, 12);
+    if ((!lowOk || !highOk) && lastWaterSections >= 0 &&
+        bus.isHealthy(I2cDevice::WaterLow) && bus.isHealthy(I2cDevice::WaterHigh)) {
+        return lastWaterSections;
+    }
+    TraceRecorder::recordWater(low_data, high_data);
+    
+    // Count consecutive triggered sections from bottom (capacitive touch detection)
+    lastWaterSections = countWaterSections(low_data, high_data);
+    return lastWaterSections;
+}
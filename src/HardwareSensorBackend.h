@@ -0,0 +1,45 @@
+#ifndef HARDWARESENSORBACKEND_H
+#define HARDWARESENSORBACKEND_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Config.h"
+#include "SensorBackend.h"
+#include "I2cBus.h"
+#include "ClimateDriver.h"
+
+// The real board: temperature/humidity sensor (ENS210 or SHT4x, whichever the
+// PCB carries) and Grove water level on I2C (through I2cBus health tracking),
+// capacitive soil probe on the ADC with switched power.
+class HardwareSensorBackend {
+private:
+    // Bound at boot by ClimateDriver::probe(); restarted after an I2C failure
+    ClimateDriver* climate = nullptr;
+    bool climateReady = false;
+    ClimateSample lastClimate = {};
+
+    // Health, backoff and recovery for every I2C transaction
+    I2cBus bus;
+    int lastWaterSections = -1;
+
+    // Grove Water Level Sensor I2C helper
+    bool readSections(I2cDevice device, uint8_t address, unsigned char* data, uint8_t length);
+    bool startClimate();
+    void recordClimate();
+
+public:
+    void begin();
+    void beginCycle() { bus.beginCycle(); }
+    void endCycle() { bus.endCycle(); }
+    void measureClimate();
+    float readTemperature();
+    float readHumidity();
+    int readSoilRaw();
+    int readWaterSections();
+    size_t formatDiagnostics(char* buffer, size_t size) const { return bus.formatStats(buffer, size); }
+    static const char* name() { return "hardware"; }
+
+    const I2cBus& getBus() const { return bus; }
+};
+
+#endif // HARDWARESENSORBACKEND_H
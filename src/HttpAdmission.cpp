@@ -0,0 +1,113 @@
+#include "HttpAdmission.h"
+#include <stdio.h>
+
+HttpAdmission::HttpAdmission() : clients(), globalTokens(HTTP_GLOBAL_BURST * 1000UL), globalRefillMs(0), stats() {
+}
+
+void HttpAdmission::refill(uint32_t& tokens, uint32_t& lastMs, uint32_t nowMs, uint32_t ratePerSec, uint32_t burst) {
+    // ms * tokens/s = milli-tokens; cap elapsed so the product cannot overflow
+    uint32_t elapsed = nowMs - lastMs;
+    if (elapsed > 3600000UL) {
+        elapsed = 3600000UL;
+    }
+    uint32_t capacity = burst * 1000UL;
+    uint32_t added = elapsed * ratePerSec;
+    tokens = added >= capacity - tokens ? capacity : tokens + added;
+    lastMs = nowMs;
+}
+
+uint32_t HttpAdmission::secondsUntil(uint32_t tokens, uint32_t needed, uint32_t ratePerSec) {
+    uint32_t missingMs = (needed - tokens + ratePerSec - 1) / ratePerSec;
+    return missingMs / 1000 + 1;
+}
+
+AdmissionClient& HttpAdmission::lookup(uint32_t ip, uint32_t nowMs) {
+    // Known client, else a free slot, else the one idle longest
+    AdmissionClient* victim = nullptr;
+    uint32_t victimIdle = 0;
+    for (AdmissionClient& client : clients) {
+        if (client.ip == ip) {
+            return client;
+        }
+        uint32_t idle = client.ip == 0 ? UINT32_MAX : nowMs - client.lastRefillMs;
+        if (!victim || idle > victimIdle) {
+            victim = &client;
+            victimIdle = idle;
+        }
+    }
+    if (victim->ip != 0) {
+        stats.evictions++;
+    }
+    // New client: starts with a full burst
+    victim->ip = ip;
+    victim->tokens = HTTP_CLIENT_BURST * 1000UL;
+    victim->lastRefillMs = nowMs;
+    victim->accepted = 0;
+    victim->shed = 0;
+    return *victim;
+}
+
+AdmissionResult HttpAdmission::admit(uint32_t ip, uint8_t cost, uint32_t nowMs, uint32_t& retryAfterSec) {
+    retryAfterSec = 0;
+    if (ip == HTTP_LOOPBACK_IP) {
+        stats.exempt++;
+        return AdmissionResult::Accepted;
+    }
+    
+    uint32_t needed = cost * 1000UL;
+    AdmissionClient& client = lookup(ip, nowMs);
+    refill(client.tokens, client.lastRefillMs, nowMs, HTTP_CLIENT_RATE_PER_SEC, HTTP_CLIENT_BURST);
+    if (client.tokens < needed) {
+        client.shed++;
+        stats.shedClient++;
+        retryAfterSec = secondsUntil(client.tokens, needed, HTTP_CLIENT_RATE_PER_SEC);
+        return AdmissionResult::ShedClient;
+    }
+    refill(globalTokens, globalRefillMs, nowMs, HTTP_GLOBAL_RATE_PER_SEC, HTTP_GLOBAL_BURST);
+    if (globalTokens < needed) {
+        client.shed++;
+        stats.shedGlobal++;
+        retryAfterSec = secondsUntil(globalTokens, needed, HTTP_GLOBAL_RATE_PER_SEC);
+        return AdmissionResult::ShedGlobal;
+    }
+    
+    client.tokens -= needed;
+    globalTokens -= needed;
+    client.accepted++;
+    stats.accepted++;
+    return AdmissionResult::Accepted;
+}
+
+size_t HttpAdmission::formatStats(char* buffer, size_t size, uint32_t nowMs) const {
+    size_t used = 0;
+    int n = snprintf(buffer, size,
+                     "accepted: %lu\nshed_client: %lu\nshed_global: %lu\nexempt_loopback: %lu\nclient_evictions: %lu\n"
+                     "client_rate: %d/s burst %d\nglobal_rate: %d/s burst %d\nglobal_tokens: %lu.%03lu\n\n"
+                     "client            tokens  accepted      shed  idle_ms\n",
+                     (unsigned long)stats.accepted, (unsigned long)stats.shedClient, (unsigned long)stats.shedGlobal,
+                     (unsigned long)stats.exempt, (unsigned long)stats.evictions,
+                     HTTP_CLIENT_RATE_PER_SEC, HTTP_CLIENT_BURST, HTTP_GLOBAL_RATE_PER_SEC, HTTP_GLOBAL_BURST,
+                     (unsigned long)(globalTokens / 1000), (unsigned long)(globalTokens % 1000));
+    if (n < 0 || (size_t)n >= size) {
+        return n < 0 ? 0 : size - 1;
+    }
+    used = n;
+    for (const AdmissionClient& client : clients) {
+        if (client.ip == 0) {
+            continue;
+        }
+        // IPAddress keeps the first octet in the low byte
+        char ip[16];
+        snprintf(ip, sizeof(ip), "%u.%u.%u.%u", (unsigned)(client.ip & 0xFF), (unsigned)((client.ip >> 8) & 0xFF),
+                 (unsigned)((client.ip >> 16) & 0xFF), (unsigned)(client.ip >> 24));
+        n = snprintf(buffer + used, size - used, "%-15s %6lu.%lu %9lu %9lu %8lu\n", ip,
+                     (unsigned long)(client.tokens / 1000), (unsigned long)(client.tokens % 1000 / 100),
+                     (unsigned long)client.accepted, (unsigned long)client.shed,
+                     (unsigned long)(nowMs - client.lastRefillMs));
+        if (n < 0 || (size_t)n >= size - used) {
+            return size - 1;
+        }
+        used += n;
+    }
+    return used;
+}
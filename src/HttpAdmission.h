@@ -0,0 +1,68 @@
+#ifndef HTTPADMISSION_H
+#define HTTPADMISSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+// Request admission for the web server, checked before any handler runs.
+//
+// Each client IP has a token bucket (HTTP_CLIENT_RATE_PER_SEC sustained,
+// HTTP_CLIENT_BURST deep) and all clients share a global bucket. The server
+// handles one request at a time on the loop task, so the global bucket is
+// the concurrency cap: it bounds how much loop time web traffic takes per
+// second no matter how many clients there are. Routes that render the
+// dashboard cost HTTP_HEAVY_COST tokens, everything else 1. A request that
+// does not fit is answered with 503 and Retry-After and nothing else.
+//
+// Buckets are kept in milli-tokens for integer refill. The client table
+// holds HTTP_ADMISSION_CLIENTS entries; the least recently seen is reused.
+// Requests from HTTP_LOOPBACK_IP (the soak driver) are exempt; an address is
+// the IPAddress value, first octet in the low byte.
+#define HTTP_LOOPBACK_IP 0x0100007FUL   // 127.0.0.1
+
+enum class AdmissionResult : uint8_t {
+    Accepted,
+    ShedClient,     // this client is over its rate
+    ShedGlobal      // all clients together are over budget
+};
+
+struct AdmissionClient {
+    uint32_t ip;            // 0 = free slot
+    uint32_t tokens;        // milli-tokens
+    uint32_t lastRefillMs;
+    uint32_t accepted;
+    uint32_t shed;
+};
+
+struct AdmissionStats {
+    uint32_t accepted;
+    uint32_t shedClient;
+    uint32_t shedGlobal;
+    uint32_t exempt;        // loopback (soak driver)
+    uint32_t evictions;     // client slots reused for a new IP
+};
+
+class HttpAdmission {
+public:
+    HttpAdmission();
+
+    // Charges cost tokens to ip and the global bucket. On shedding,
+    // retryAfterSec is when the request would fit again.
+    AdmissionResult admit(uint32_t ip, uint8_t cost, uint32_t nowMs, uint32_t& retryAfterSec);
+
+    const AdmissionStats& getStats() const { return stats; }
+    size_t formatStats(char* buffer, size_t size, uint32_t nowMs) const;
+
+private:
+    AdmissionClient clients[HTTP_ADMISSION_CLIENTS];
+    uint32_t globalTokens;
+    uint32_t globalRefillMs;
+    AdmissionStats stats;
+
+    AdmissionClient& lookup(uint32_t ip, uint32_t nowMs);
+    static void refill(uint32_t& tokens, uint32_t& lastMs, uint32_t nowMs, uint32_t ratePerSec, uint32_t burst);
+    static uint32_t secondsUntil(uint32_t tokens, uint32_t needed, uint32_t ratePerSec);
+};
+
+#endif // HTTPADMISSION_H
@@ -0,0 +1,885 @@
+#include "HttpsProxy.h"
+#include <IPAddress.h>
+#include <lwip/sockets.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/oid.h>
+#include <mbedtls/sha256.h>
+#include <strings.h>
+
+#define HTTPS_TASK_STACK    8192    // ECDHE + ECDSA handshake peaks around 6 KB
+#define HTTPS_TASK_PRIORITY 1       // same as loop(): a handshake must not starve the control loop
+#define HTTPS_KEY_DER_MAX   160     // P-256 private key, ~121 bytes
+#define HTTPS_CERT_DER_MAX  640     // self-signed P-256 certificate, ~450 bytes
+#define HTTPS_IDENTITY_KEY  "tlsid"
+
+namespace {
+// Stored in NVS as one fixed-size blob
+struct TlsIdentity {
+    uint16_t keyLength;
+    uint16_t certLength;
+    uint8_t key[HTTPS_KEY_DER_MAX];
+    uint8_t cert[HTTPS_CERT_DER_MAX];
+};
+
+// Both have hardware AES on the S3; no CBC or RSA suites to negotiate down to
+const int CIPHERSUITES[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    0
+};
+const mbedtls_ecp_group_id CURVES[] = { MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_NONE };
+
+// Headers the proxy sets itself
+const char* const REQUEST_DROP[] = { "Connection", "Keep-Alive", "X-Forwarded-For", nullptr };
+const char* const RESPONSE_DROP[] = { "Connection", "Keep-Alive", nullptr };
+
+// Offset just past the blank line ending the head, -1 if not there yet
+int headEnd(const char* data, size_t length) {
+    for (size_t i = 3; i < length; i++) {
+        if (data[i] == '\n' && data[i - 1] == '\r' && data[i - 2] == '\n' && data[i - 3] == '\r') {
+            return (int)(i + 1);
+        }
+    }
+    return -1;
+}
+
+// Value of the first header called name, nullptr if absent
+const char* findHeader(const char* head, size_t length, const char* name, size_t* valueLength) {
+    size_t nameLength = strlen(name);
+    const char* end = head + length;
+    const char* line = (const char*)memchr(head, '\n', length);
+    while (line && ++line < end) {
+        const char* lineEnd = (const char*)memchr(line, '\r', end - line);
+        if (!lineEnd || lineEnd == line) {
+            break;
+        }
+        if ((size_t)(lineEnd - line) > nameLength && line[nameLength] == ':' &&
+            strncasecmp(line, name, nameLength) == 0) {
+            const char* value = line + nameLength + 1;
+            while (value < lineEnd && *value == ' ') {
+                value++;
+            }
+            *valueLength = lineEnd - value;
+            return value;
+        }
+        line = (const char*)memchr(lineEnd, '\n', end - lineEnd);
+    }
+    return nullptr;
+}
+
+bool hasToken(const char* value, size_t length, const char* token) {
+    size_t tokenLength = strlen(token);
+    for (size_t i = 0; i + tokenLength <= length; i++) {
+        if (strncasecmp(value + i, token, tokenLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Copies the head without the dropped headers, adds extra (complete header
+// lines) and the blank line. 0 if it does not fit.
+size_t rewriteHead(const char* head, size_t length, char* out, size_t size,
+                   const char* const* drop, const char* extra) {
+    size_t used = 0;
+    const char* end = head + length;
+    const char* line = head;
+    bool first = true;
+    while (line < end) {
+        const char* next = (const char*)memchr(line, '\n', end - line);
+        next = next ? next + 1 : end;
+        size_t lineLength = next - line;
+        if (lineLength <= 2 && !first) {
+            break;      // blank line
+        }
+        bool keep = true;
+        for (int i = 0; !first && drop[i]; i++) {
+            size_t dropLength = strlen(drop[i]);
+            if (lineLength > dropLength && line[dropLength] == ':' && strncasecmp(line, drop[i], dropLength) == 0) {
+                keep = false;
+            }
+        }
+        if (keep) {
+            if (used + lineLength > size) {
+                return 0;
+            }
+            memcpy(out + used, line, lineLength);
+            used += lineLength;
+        }
+        first = false;
+        line = next;
+    }
+    size_t extraLength = strlen(extra);
+    if (used + extraLength + 2 > size) {
+        return 0;
+    }
+    memcpy(out + used, extra, extraLength);
+    used += extraLength;
+    memcpy(out + used, "\r\n", 2);
+    return used + 2;
+}
+
+bool sendAll(int fd, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (length > 0) {
+        int n = send(fd, p, length, 0);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+void setTimeouts(int fd, uint32_t ms) {
+    struct timeval timeout = { (time_t)(ms / 1000), (suseconds_t)((ms % 1000) * 1000) };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int noDelay = 1;    // head and body go out as separate records
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+}
+}
+
+HttpsProxy::HttpsProxy()
+    : settings(nullptr), task(nullptr), listenFd(-1), running(false), identityGenerated(false),
+      resumption(Resumption::None) {
+    portMUX_TYPE unlocked = portMUX_INITIALIZER_UNLOCKED;
+    statsMux = unlocked;
+    memset(fingerprint, 0, sizeof(fingerprint));
+    memset(connections, 0, sizeof(connections));
+    for (Connection& connection : connections) {
+        connection.upstream = -1;
+    }
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool HttpsProxy::begin(SettingsStore* store) {
+    if (task) {
+        return true;
+    }
+    settings = store;
+    if (xTaskCreatePinnedToCore(taskEntry, "https", HTTPS_TASK_STACK, this,
+                                HTTPS_TASK_PRIORITY, &task, tskNO_AFFINITY) != pdPASS) {
+        Serial.println("HTTPS: task creation failed");
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void HttpsProxy::taskEntry(void* arg) {
+    static_cast<HttpsProxy*>(arg)->run();
+}
+
+void HttpsProxy::bump(uint32_t& counter) {
+    portENTER_CRITICAL(&statsMux);
+    counter++;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+HttpsStats HttpsProxy::getStats() {
+    portENTER_CRITICAL(&statsMux);
+    HttpsStats copy = stats;
+    portEXIT_CRITICAL(&statsMux);
+    return copy;
+}
+
+void HttpsProxy::run() {
+    if (!setupTls() || !openListener()) {
+        Serial.println("HTTPS: disabled");
+        vTaskDelete(nullptr);
+        return;
+    }
+    running = true;
+    Serial.printf("HTTPS: listening on port %d (%s identity, sha256 %.16s...)\n", HTTPS_PORT,
+                  identityGenerated ? "new" : "stored", fingerprint);
+
+    for (;;) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listenFd, &readable);
+        int maxFd = listenFd;
+        fd_set writable;
+        FD_ZERO(&writable);
+        bool buffered = false;      // decrypted bytes waiting, select() cannot see them
+        for (int i = 0; i < HTTPS_MAX_CONNECTIONS; i++) {
+            Connection& connection = connections[i];
+            if (connection.state == State::Free) {
+                continue;
+            }
+            // While a response is pending only the web server's side is watched
+            int fd = connection.state == State::Waiting ? connection.upstream : connection.net.fd;
+            FD_SET(fd, connection.wantWrite ? &writable : &readable);
+            if (fd > maxFd) {
+                maxFd = fd;
+            }
+            buffered |= connection.state == State::Open && mbedtls_ssl_get_bytes_avail(&connection.ssl) > 0;
+        }
+
+        // Wake at least once a second for the idle, handshake and upstream timeouts
+        struct timeval timeout = { buffered ? 0 : 1, 0 };
+        if (select(maxFd + 1, &readable, &writable, nullptr, &timeout) < 0) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        for (int i = 0; i < HTTPS_MAX_CONNECTIONS; i++) {
+            Connection& connection = connections[i];
+            if (connection.state == State::Handshaking) {
+                if (FD_ISSET(connection.net.fd, &readable) || FD_ISSET(connection.net.fd, &writable)) {
+                    continueHandshake(connection);
+                } else if (millis() - connection.lastActive > HTTPS_HANDSHAKE_TIMEOUT_MS) {
+                    portENTER_CRITICAL(&statsMux);
+                    stats.handshakeFailures++;
+                    stats.handshakeTimeouts++;
+                    portEXIT_CRITICAL(&statsMux);
+                    closeConnection(connection);
+                }
+                continue;
+            }
+            if (connection.state == State::Waiting) {
+                if (FD_ISSET(connection.upstream, &readable)) {
+                    if (!relayResponse(connection)) {
+                        closeConnection(connection);
+                    }
+                } else if (millis() - connection.upstreamSince > HTTPS_IO_TIMEOUT_MS) {
+                    bump(stats.upstreamErrors);
+                    if (!connection.headSent) {
+                        sendError(connection, 504, "Gateway Timeout");
+                    }
+                    closeConnection(connection);
+                }
+                continue;
+            }
+            if (connection.state != State::Open) {
+                continue;
+            }
+            if (FD_ISSET(connection.net.fd, &readable) || mbedtls_ssl_get_bytes_avail(&connection.ssl) > 0) {
+                if (serve(connection)) {
+                    connection.lastActive = millis();
+                } else {
+                    closeConnection(connection);
+                }
+            } else if (millis() - connection.lastActive > HTTPS_IDLE_TIMEOUT_S * 1000UL) {
+                bump(stats.idleCloses);
+                closeConnection(connection);
+            }
+        }
+        if (FD_ISSET(listenFd, &readable)) {
+            acceptClient();
+        }
+    }
+}
+
+bool HttpsProxy::setupTls() {
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_init(&certificate);
+    mbedtls_pk_init(&key);
+
+    const char* personalization = "growbox-https";
+    if (mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy,
+                              (const unsigned char*)personalization, strlen(personalization)) != 0) {
+        Serial.println("HTTPS: RNG seed failed");
+        return false;
+    }
+    if (!loadIdentity() && !generateIdentity()) {
+        return false;
+    }
+
+    int ret = mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret == 0) {
+        ret = mbedtls_ssl_conf_own_cert(&conf, &certificate, &key);
+    }
+    if (ret != 0) {
+        Serial.printf("HTTPS: TLS config failed (-0x%04x)\n", -ret);
+        return false;
+    }
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_min_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_ciphersuites(&conf, CIPHERSUITES);
+    mbedtls_ssl_conf_curves(&conf, CURVES);
+    mbedtls_ssl_conf_read_timeout(&conf, HTTPS_CLIENT_TIMEOUT_MS);
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_init(&cache);
+    mbedtls_ssl_cache_set_max_entries(&cache, HTTPS_SESSION_CACHE);
+    mbedtls_ssl_cache_set_timeout(&cache, HTTPS_SESSION_LIFETIME_S);
+    mbedtls_ssl_conf_session_cache(&conf, this, cacheGet, cacheSet);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    // Ticket keys live in RAM and rotate every lifetime; a reboot costs one full handshake per client
+    mbedtls_ssl_ticket_init(&tickets);
+    if (mbedtls_ssl_ticket_setup(&tickets, mbedtls_ctr_drbg_random, &drbg, MBEDTLS_CIPHER_AES_128_GCM,
+                                 HTTPS_SESSION_LIFETIME_S) == 0) {
+        mbedtls_ssl_conf_session_tickets_cb(&conf, ticketWrite, ticketParse, this);
+    } else {
+        Serial.println("HTTPS: session tickets unavailable");
+    }
+#endif
+    return true;
+}
+
+bool HttpsProxy::loadIdentity() {
+    TlsIdentity identity;
+    if (!settings || !settings->getBlob(HTTPS_IDENTITY_KEY, &identity, sizeof(identity))) {
+        return false;
+    }
+    if (identity.keyLength > sizeof(identity.key) || identity.certLength > sizeof(identity.cert) ||
+        mbedtls_pk_parse_key(&key, identity.key, identity.keyLength, nullptr, 0) != 0 ||
+        mbedtls_x509_crt_parse_der(&certificate, identity.cert, identity.certLength) != 0) {
+        Serial.println("HTTPS: stored identity unusable, generating a new one");
+        mbedtls_pk_free(&key);
+        mbedtls_pk_init(&key);
+        mbedtls_x509_crt_free(&certificate);
+        mbedtls_x509_crt_init(&certificate);
+        return false;
+    }
+    setFingerprint(identity.cert, identity.certLength);
+    return true;
+}
+
+bool HttpsProxy::generateIdentity() {
+    unsigned long start = millis();
+    TlsIdentity identity;
+    memset(&identity, 0, sizeof(identity));
+
+    int ret = mbedtls_pk_setup(&key, mbedtls_pk_info_from_type(MBEDTLS_PK_ECKEY));
+    if (ret == 0) {
+        ret = mbedtls_ecp_gen_key(MBEDTLS_ECP_DP_SECP256R1, mbedtls_pk_ec(key), mbedtls_ctr_drbg_random, &drbg);
+    }
+    // The DER writers fill the buffer from its end
+    int keyLength = ret == 0 ? mbedtls_pk_write_key_der(&key, identity.key, sizeof(identity.key)) : ret;
+    if (keyLength <= 0) {
+        Serial.printf("HTTPS: key generation failed (-0x%04x)\n", -keyLength);
+        return false;
+    }
+    memmove(identity.key, identity.key + sizeof(identity.key) - keyLength, keyLength);
+
+    // subjectAltName: dNSName HTTPS_HOSTNAME and iPAddress of the setup AP
+    // (192.168.4.1); the station address is DHCP-assigned and not covered
+    const size_t nameLength = strlen(HTTPS_HOSTNAME);
+    uint8_t altNames[4 + 32 + 6];
+    if (nameLength > 32) {
+        Serial.println("HTTPS: HTTPS_HOSTNAME too long");
+        return false;
+    }
+    size_t altLength = 0;
+    altNames[altLength++] = 0x30;                       // SEQUENCE
+    altNames[altLength++] = (uint8_t)(2 + nameLength + 6);
+    altNames[altLength++] = 0x82;                       // [2] dNSName
+    altNames[altLength++] = (uint8_t)nameLength;
+    memcpy(altNames + altLength, HTTPS_HOSTNAME, nameLength);
+    altLength += nameLength;
+    const uint8_t apAddress[6] = { 0x87, 4, 192, 168, 4, 1 };  // [7] iPAddress
+    memcpy(altNames + altLength, apAddress, sizeof(apAddress));
+    altLength += sizeof(apAddress);
+
+    uint8_t serialBytes[8];
+    mbedtls_ctr_drbg_random(&drbg, serialBytes, sizeof(serialBytes));
+    serialBytes[0] &= 0x7F;     // positive
+    char name[48];
+    snprintf(name, sizeof(name), "CN=%s", HTTPS_HOSTNAME);
+
+    mbedtls_x509write_cert writer;
+    mbedtls_mpi serial;
+    mbedtls_x509write_crt_init(&writer);
+    mbedtls_mpi_init(&serial);
+    mbedtls_x509write_crt_set_version(&writer, MBEDTLS_X509_CRT_VERSION_3);
+    mbedtls_x509write_crt_set_md_alg(&writer, MBEDTLS_MD_SHA256);
+    mbedtls_x509write_crt_set_subject_key(&writer, &key);
+    mbedtls_x509write_crt_set_issuer_key(&writer, &key);
+    ret = mbedtls_mpi_read_binary(&serial, serialBytes, sizeof(serialBytes));
+    if (ret == 0) ret = mbedtls_x509write_crt_set_serial(&writer, &serial);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_subject_name(&writer, name);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_issuer_name(&writer, name);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_validity(&writer, "20240101000000", "20491231235959");
+    if (ret == 0) ret = mbedtls_x509write_crt_set_basic_constraints(&writer, 0, -1);
+    if (ret == 0) ret = mbedtls_x509write_crt_set_extension(&writer, MBEDTLS_OID_SUBJECT_ALT_NAME,
+                                                            MBEDTLS_OID_SIZE(MBEDTLS_OID_SUBJECT_ALT_NAME), 0,
+                                                            altNames, altLength);
+    int certLength = ret == 0 ? mbedtls_x509write_crt_der(&writer, identity.cert, sizeof(identity.cert),
+                                                          mbedtls_ctr_drbg_random, &drbg)
+                              : ret;
+    mbedtls_x509write_crt_free(&writer);
+    mbedtls_mpi_free(&serial);
+    if (certLength <= 0) {
+        Serial.printf("HTTPS: certificate generation failed (-0x%04x)\n", -certLength);
+        return false;
+    }
+    memmove(identity.cert, identity.cert + sizeof(identity.cert) - certLength, certLength);
+    ret = mbedtls_x509_crt_parse_der(&certificate, identity.cert, certLength);
+    if (ret != 0) {
+        Serial.printf("HTTPS: generated certificate rejected (-0x%04x)\n", -ret);
+        return false;
+    }
+
+    identity.keyLength = (uint16_t)keyLength;
+    identity.certLength = (uint16_t)certLength;
+    if (settings) {
+        settings->putBlob(HTTPS_IDENTITY_KEY, &identity, sizeof(identity));
+    }
+    identityGenerated = true;
+    setFingerprint(identity.cert, identity.certLength);
+    Serial.printf("HTTPS: generated ECDSA P-256 identity for %s in %lu ms\n", HTTPS_HOSTNAME, millis() - start);
+    return true;
+}
+
+void HttpsProxy::setFingerprint(const uint8_t* der, size_t length) {
+    uint8_t digest[32];
+    mbedtls_sha256_ret(der, length, digest, 0);
+    for (int i = 0; i < 32; i++) {
+        snprintf(fingerprint + i * 2, 3, "%02x", digest[i]);
+    }
+}
+
+bool HttpsProxy::openListener() {
+    listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenFd < 0) {
+        Serial.println("HTTPS: socket() failed");
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(HTTPS_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, HTTPS_MAX_CONNECTIONS) < 0) {
+        Serial.println("HTTPS: bind()/listen() failed");
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void HttpsProxy::acceptClient() {
+    struct sockaddr_in client;
+    socklen_t clientLength = sizeof(client);
+    int fd = accept(listenFd, (struct sockaddr*)&client, &clientLength);
+    if (fd < 0) {
+        return;
+    }
+
+    // A free slot, else the least recently used connection makes room; one
+    // waiting for its response is not cut off
+    Connection* slot = nullptr;
+    for (int i = 0; i < HTTPS_MAX_CONNECTIONS && !slot; i++) {
+        if (connections[i].state == State::Free) {
+            slot = &connections[i];
+        }
+    }
+    if (!slot) {
+        for (int i = 0; i < HTTPS_MAX_CONNECTIONS; i++) {
+            Connection& candidate = connections[i];
+            if (candidate.state != State::Waiting &&
+                (!slot || candidate.lastActive - slot->lastActive > 0x80000000UL)) {   // older, wrap-safe
+                slot = &candidate;
+            }
+        }
+        if (!slot) {
+            close(fd);
+            return;
+        }
+        bump(stats.evictions);
+        closeConnection(*slot);
+    }
+    bump(stats.accepted);
+    setTimeouts(fd, HTTPS_CLIENT_TIMEOUT_MS);
+
+    // The context (and its record buffers) is allocated once per slot and reused
+    if (!slot->allocated) {
+        mbedtls_ssl_init(&slot->ssl);
+        int ret = mbedtls_ssl_setup(&slot->ssl, &conf);
+        if (ret != 0) {
+            Serial.printf("HTTPS: ssl setup failed (-0x%04x)\n", -ret);
+            mbedtls_ssl_free(&slot->ssl);
+            close(fd);
+            return;
+        }
+        slot->allocated = true;
+    } else {
+        mbedtls_ssl_session_reset(&slot->ssl);
+    }
+    slot->net.fd = fd;
+    slot->ip = client.sin_addr.s_addr;
+    slot->requests = 0;
+
+    // The handshake runs non-blocking, a step whenever the client's next
+    // records arrive, so the other connections are served in between
+    mbedtls_net_set_nonblock(&slot->net);
+    mbedtls_ssl_set_bio(&slot->ssl, &slot->net, mbedtls_net_send, mbedtls_net_recv, nullptr);
+    slot->state = State::Handshaking;
+    slot->wantWrite = false;
+    slot->resumption = Resumption::None;
+    slot->handshakeUs = 0;
+    slot->lastActive = millis();
+    continueHandshake(*slot);
+}
+
+void HttpsProxy::continueHandshake(Connection& connection) {
+    resumption = connection.resumption;
+    uint32_t start = micros();
+    int ret = mbedtls_ssl_handshake(&connection.ssl);
+    connection.handshakeUs += micros() - start;
+    connection.resumption = resumption;
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        connection.wantWrite = ret == MBEDTLS_ERR_SSL_WANT_WRITE;
+        return;
+    }
+    if (ret != 0) {
+        // Browsers that have not accepted the self-signed certificate yet end up here
+        bump(stats.handshakeFailures);
+        Serial.printf("HTTPS: handshake with %s failed (-0x%04x)\n", IPAddress(connection.ip).toString().c_str(), -ret);
+        closeConnection(connection);
+        return;
+    }
+
+    // Established: requests are read and answered in one go, blocking with
+    // HTTPS_CLIENT_TIMEOUT_MS
+    mbedtls_net_set_block(&connection.net);
+    mbedtls_ssl_set_bio(&connection.ssl, &connection.net, mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
+    uint32_t elapsed = connection.handshakeUs;
+    portENTER_CRITICAL(&statsMux);
+    if (connection.resumption == Resumption::None) {
+        stats.fullHandshakes++;
+        stats.lastFullUs = elapsed;
+        stats.totalFullUs += elapsed;
+        if (elapsed > stats.maxFullUs) {
+            stats.maxFullUs = elapsed;
+        }
+    } else {
+        if (connection.resumption == Resumption::Ticket) {
+            stats.ticketResumptions++;
+        } else {
+            stats.idResumptions++;
+        }
+        stats.lastResumedUs = elapsed;
+        stats.totalResumedUs += elapsed;
+    }
+    stats.openConnections++;
+    portEXIT_CRITICAL(&statsMux);
+
+    connection.state = State::Open;
+    connection.wantWrite = false;
+    connection.lastActive = millis();
+}
+
+void HttpsProxy::closeConnection(Connection& connection) {
+    if (connection.state == State::Free) {
+        return;
+    }
+    if (connection.upstream >= 0) {
+        close(connection.upstream);
+        connection.upstream = -1;
+    }
+    if (connection.state != State::Handshaking) {
+        mbedtls_ssl_close_notify(&connection.ssl);
+        portENTER_CRITICAL(&statsMux);
+        stats.openConnections--;
+        portEXIT_CRITICAL(&statsMux);
+    }
+    mbedtls_net_free(&connection.net);
+    connection.state = State::Free;
+    connection.wantWrite = false;
+}
+
+bool HttpsProxy::writeAll(Connection& connection, const void* data, size_t length) {
+    // The socket blocks for at most HTTPS_CLIENT_TIMEOUT_MS; when mbedTLS still
+    // asks to retry, wait on select for what is left of that time
+    unsigned long start = millis();
+    const uint8_t* p = (const uint8_t*)data;
+    while (length > 0) {
+        int n = mbedtls_ssl_write(&connection.ssl, p, length);
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            unsigned long waited = millis() - start;
+            if (waited >= HTTPS_CLIENT_TIMEOUT_MS) {
+                return false;
+            }
+            unsigned long left = HTTPS_CLIENT_TIMEOUT_MS - waited;
+            struct timeval timeout = { (time_t)(left / 1000), (suseconds_t)((left % 1000) * 1000) };
+            fd_set ready;
+            FD_ZERO(&ready);
+            FD_SET(connection.net.fd, &ready);
+            select(connection.net.fd + 1, n == MBEDTLS_ERR_SSL_WANT_READ ? &ready : nullptr,
+                   n == MBEDTLS_ERR_SSL_WANT_WRITE ? &ready : nullptr, nullptr, &timeout);
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+void HttpsProxy::sendError(Connection& connection, int code, const char* reason) {
+    char response[128];
+    int length = snprintf(response, sizeof(response),
+                          "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", code, reason);
+    writeAll(connection, response, length);
+}
+
+int HttpsProxy::connectUpstream() {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        return -1;
+    }
+    setTimeouts(fd, HTTPS_CLIENT_TIMEOUT_MS);   // the request goes into local socket buffers
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(80);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads a request and forwards it to the web server; the response is relayed
+// by relayResponse() as it arrives. False when the connection is to be closed.
+bool HttpsProxy::serve(Connection& connection) {
+    // Request head, possibly with the start of the body
+    size_t have = 0;
+    int end = -1;
+    while (end < 0) {
+        if (have == sizeof(head)) {
+            sendError(connection, 431, "Request Header Fields Too Large");
+            return false;
+        }
+        int n = mbedtls_ssl_read(&connection.ssl, (unsigned char*)head + have, sizeof(head) - have);
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;       // closed by the client, timeout or error
+        }
+        have += n;
+        end = headEnd(head, have);
+    }
+    bump(stats.requests);
+    if (connection.requests++ > 0) {
+        bump(stats.reusedRequests);
+    }
+
+    size_t valueLength;
+    const char* value;
+    if (findHeader(head, end, "Transfer-Encoding", &valueLength)) {
+        sendError(connection, 411, "Length Required");
+        return false;
+    }
+    size_t contentLength = 0;
+    if ((value = findHeader(head, end, "Content-Length", &valueLength)) != nullptr) {
+        contentLength = strtoul(value, nullptr, 10);
+    }
+    const char* requestLineEnd = (const char*)memchr(head, '\r', end);
+    bool http10 = requestLineEnd && requestLineEnd - head >= 8 && memcmp(requestLineEnd - 8, "HTTP/1.0", 8) == 0;
+    value = findHeader(head, end, "Connection", &valueLength);
+    connection.keepAlive = http10 ? value && hasToken(value, valueLength, "keep-alive")
+                                  : !(value && hasToken(value, valueLength, "close"));
+    connection.headRequest = strncmp(head, "HEAD ", 5) == 0;
+    size_t bodyInHead = have - end;
+    if (bodyInHead > contentLength) {
+        bodyInHead = contentLength;
+        connection.keepAlive = false;   // pipelined request, not supported
+    }
+
+    // WebServer answers one request per connection; it sees the client address
+    // in X-Forwarded-For
+    char extra[96];
+    IPAddress client(connection.ip);
+    snprintf(extra, sizeof(extra), "X-Forwarded-For: %u.%u.%u.%u\r\nConnection: close\r\n",
+             client[0], client[1], client[2], client[3]);
+    size_t forwardLength = rewriteHead(head, end, forward, sizeof(forward), REQUEST_DROP, extra);
+    if (forwardLength == 0) {
+        sendError(connection, 431, "Request Header Fields Too Large");
+        return false;
+    }
+    int upstream = connectUpstream();
+    bool ok = upstream >= 0 && sendAll(upstream, forward, forwardLength) &&
+              sendAll(upstream, head + end, bodyInHead);
+    for (size_t remaining = contentLength - bodyInHead; ok && remaining > 0;) {
+        int n = mbedtls_ssl_read(&connection.ssl, chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        ok = n > 0 && sendAll(upstream, chunk, n);
+        remaining -= n > 0 ? n : 0;
+    }
+    if (!ok) {
+        bump(stats.upstreamErrors);
+        if (upstream >= 0) {
+            close(upstream);
+        }
+        sendError(connection, 502, "Bad Gateway");
+        return false;
+    }
+
+    // The loop task answers when it gets to it (a dashboard render takes a
+    // while); run() waits for the response on select with the other clients
+    fcntl(upstream, F_SETFL, fcntl(upstream, F_GETFL, 0) | O_NONBLOCK);
+    connection.upstream = upstream;
+    connection.upstreamSince = millis();
+    connection.responseLength = 0;
+    connection.headSent = false;
+    connection.state = State::Waiting;
+    return true;
+}
+
+// Relays what the web server has written so far. False when the connection
+// is to be closed.
+bool HttpsProxy::relayResponse(Connection& connection) {
+    for (;;) {
+        int n;
+        if (connection.headSent) {
+            n = recv(connection.upstream, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                if (!writeAll(connection, chunk, n)) {
+                    return false;
+                }
+                continue;
+            }
+        } else {
+            n = recv(connection.upstream, connection.response + connection.responseLength,
+                     sizeof(connection.response) - connection.responseLength, 0);
+            if (n > 0) {
+                connection.responseLength += n;
+                int end = headEnd(connection.response, connection.responseLength);
+                if (end >= 0 || connection.responseLength == sizeof(connection.response)) {
+                    if (!sendResponseHead(connection, end)) {
+                        return false;
+                    }
+                }
+                continue;
+            }
+        }
+        if (n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN)) {
+            return true;        // more later
+        }
+        // The web server closed its side: the response is complete
+        close(connection.upstream);
+        connection.upstream = -1;
+        if (!connection.headSent) {
+            if (connection.responseLength == 0 || n < 0) {
+                bump(stats.upstreamErrors);
+                sendError(connection, 502, "Bad Gateway");
+                return false;
+            }
+            // Head without its blank line: pass it through and close
+            writeAll(connection, connection.response, connection.responseLength);
+            return false;
+        }
+        if (n < 0 || !connection.keepAlive) {
+            return false;
+        }
+        connection.state = State::Open;
+        connection.lastActive = millis();
+        return true;
+    }
+}
+
+// Writes the response head with the proxy's Connection headers, and any body
+// bytes that came with it. end is -1 for an oversized or malformed head.
+bool HttpsProxy::sendResponseHead(Connection& connection, int end) {
+    connection.headSent = true;
+    const char* response = connection.response;
+    size_t have = connection.responseLength;
+    if (end < 0) {
+        connection.keepAlive = false;
+        return writeAll(connection, response, have);
+    }
+
+    // Keep the connection only if the client can tell where this response ends
+    size_t valueLength;
+    int status = have > 12 ? atoi(response + 9) : 0;
+    const char* value = findHeader(response, end, "Transfer-Encoding", &valueLength);
+    bool delimited = connection.headRequest || status < 200 || status == 204 || status == 304 ||
+                     findHeader(response, end, "Content-Length", &valueLength) ||
+                     (value && hasToken(value, valueLength, "chunked"));
+    bool keep = connection.keepAlive && delimited;
+    char extra[96];
+    if (keep) {
+        snprintf(extra, sizeof(extra), "Connection: keep-alive\r\nKeep-Alive: timeout=%d\r\n", HTTPS_IDLE_TIMEOUT_S);
+    } else {
+        snprintf(extra, sizeof(extra), "Connection: close\r\n");
+    }
+    size_t forwardLength = rewriteHead(response, end, forward, sizeof(forward), RESPONSE_DROP, extra);
+    connection.keepAlive = keep && forwardLength > 0;
+    return forwardLength > 0 ? writeAll(connection, forward, forwardLength) &&
+                                   writeAll(connection, response + end, have - end)
+                             : writeAll(connection, response, have);
+}
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+int HttpsProxy::cacheGet(void* data, mbedtls_ssl_session* session) {
+    HttpsProxy* self = static_cast<HttpsProxy*>(data);
+    int ret = mbedtls_ssl_cache_get(&self->cache, session);
+    if (ret == 0) {
+        self->resumption = Resumption::SessionId;
+    }
+    return ret;
+}
+
+int HttpsProxy::cacheSet(void* data, const mbedtls_ssl_session* session) {
+    return mbedtls_ssl_cache_set(&static_cast<HttpsProxy*>(data)->cache, session);
+}
+#endif
+
+#if defined(MBEDTLS_SSL_TICKET_C)
+int HttpsProxy::ticketWrite(void* data, const mbedtls_ssl_session* session, unsigned char* start,
+                            const unsigned char* end, size_t* length, uint32_t* lifetime) {
+    return mbedtls_ssl_ticket_write(&static_cast<HttpsProxy*>(data)->tickets, session, start, end, length, lifetime);
+}
+
+int HttpsProxy::ticketParse(void* data, mbedtls_ssl_session* session, unsigned char* buffer, size_t length) {
+    HttpsProxy* self = static_cast<HttpsProxy*>(data);
+    int ret = mbedtls_ssl_ticket_parse(&self->tickets, session, buffer, length);
+    if (ret == 0) {
+        self->resumption = Resumption::Ticket;
+    }
+    return ret;
+}
+#endif
+
+size_t HttpsProxy::formatReport(char* buffer, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    HttpsStats s = getStats();
+    uint32_t resumed = s.idResumptions + s.ticketResumptions;
+    uint32_t handshakes = s.fullHandshakes + resumed;
+    int n = snprintf(buffer, size,
+                     "listener: %s, port %d\n"
+                     "identity: ECDSA P-256, CN=%s, %s\n"
+                     "certificate sha256: %s\n"
+                     "\n"
+                     "connections: %lu/%d open, %lu accepted, %lu evicted, %lu idle-closed\n"
+                     "full handshakes: %lu (last %lu ms, avg %lu ms, max %lu ms), %lu failed (%lu timed out)\n"
+                     "resumptions: %lu session id, %lu ticket (last %lu ms, avg %lu ms)\n"
+                     "requests: %lu, %lu on a kept-alive connection, %lu upstream errors\n"
+                     "handshakes per 100 requests: %lu\n",
+                     running ? "running" : "stopped", HTTPS_PORT,
+                     HTTPS_HOSTNAME, identityGenerated ? "generated this boot" : "loaded from NVS",
+                     fingerprint[0] ? fingerprint : "-",
+                     (unsigned long)s.openConnections, HTTPS_MAX_CONNECTIONS, (unsigned long)s.accepted,
+                     (unsigned long)s.evictions, (unsigned long)s.idleCloses,
+                     (unsigned long)s.fullHandshakes, (unsigned long)(s.lastFullUs / 1000),
+                     (unsigned long)(s.fullHandshakes ? s.totalFullUs / s.fullHandshakes / 1000 : 0),
+                     (unsigned long)(s.maxFullUs / 1000), (unsigned long)s.handshakeFailures,
+                     (unsigned long)s.handshakeTimeouts,
+                     (unsigned long)s.idResumptions, (unsigned long)s.ticketResumptions,
+                     (unsigned long)(s.lastResumedUs / 1000),
+                     (unsigned long)(resumed ? s.totalResumedUs / resumed / 1000 : 0),
+                     (unsigned long)s.requests, (unsigned long)s.reusedRequests, (unsigned long)s.upstreamErrors,
+                     (unsigned long)(s.requests ? (uint64_t)handshakes * 100 / s.requests : 0));
+    size_t used = n < 0 ? 0 : (size_t)n;
+    return used < size ? used : size - 1;
+}
@@ -0,0 +1,158 @@
+#ifndef HTTPSPROXY_H
+#define HTTPSPROXY_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/pk.h>
+#if defined(MBEDTLS_SSL_CACHE_C)
+#include <mbedtls/ssl_cache.h>
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+#include <mbedtls/ssl_ticket.h>
+#endif
+#include "Config.h"
+#include "SettingsStore.h"
+
+// HTTPS front end for the web server, in its own FreeRTOS task.
+//
+// Terminates TLS 1.2 on HTTPS_PORT and forwards each request over loopback to
+// the plain WebServer on port 80, so every route, handler and the admission
+// control work unchanged (the client address travels in X-Forwarded-For).
+//
+// A full ECDHE-ECDSA handshake costs the S3 a few hundred ms, so it is paid
+// rarely:
+// - the identity (ECDSA P-256 key and self-signed certificate) is generated
+//   once and kept in NVS, so returning clients keep their session and trust
+// - resumption by session ID (HTTPS_SESSION_CACHE entries) and by session
+//   ticket (no server state) skips the key exchange and the signature
+// - up to HTTPS_MAX_CONNECTIONS connections are kept alive between requests
+//   when the response length is known (Connection: close from WebServer is
+//   rewritten), so a poller reuses one connection; when all are in use the
+//   least recently used one is closed for a new client
+//
+// One task serves every connection, so it never waits on a single peer:
+// - the handshake runs non-blocking and run() steps it whenever the client's
+//   records arrive; a client stalled for HTTPS_HANDSHAKE_TIMEOUT_MS loses its slot
+// - the request is forwarded and the web server's response is read
+//   non-blocking from run()'s select() as the loop task produces it, so a slow
+//   dashboard render only delays its own client (504 after HTTPS_IO_TIMEOUT_MS)
+// - reads and writes on the client side block for at most HTTPS_CLIENT_TIMEOUT_MS
+// Handshake times are the task time spent in mbedtls_ssl_handshake.
+struct HttpsStats {
+    uint32_t accepted;
+    uint32_t evictions;             // kept-alive connections closed for a new client
+    uint32_t idleCloses;
+    uint32_t handshakeFailures;
+    uint32_t handshakeTimeouts;     // of the failures, clients that stalled mid-handshake
+    uint32_t fullHandshakes;
+    uint32_t idResumptions;
+    uint32_t ticketResumptions;
+    uint32_t lastFullUs;
+    uint32_t maxFullUs;
+    uint64_t totalFullUs;
+    uint32_t lastResumedUs;
+    uint64_t totalResumedUs;
+    uint32_t requests;
+    uint32_t reusedRequests;        // served on an already open connection
+    uint32_t upstreamErrors;
+    uint32_t openConnections;
+};
+
+class HttpsProxy {
+private:
+    enum class Resumption : uint8_t { None, SessionId, Ticket };
+    enum class State : uint8_t { Free, Handshaking, Open, Waiting };   // Waiting: for the web server's response
+
+    struct Connection {
+        mbedtls_ssl_context ssl;
+        mbedtls_net_context net;
+        bool allocated;             // ssl set up; kept and reset for the next client
+        State state;
+        bool wantWrite;             // handshake waits for the socket to drain
+        Resumption resumption;
+        uint32_t ip;
+        unsigned long lastActive;   // accept time while handshaking
+        uint32_t handshakeUs;       // task time spent in the handshake so far
+        uint32_t requests;
+        int upstream;               // web server socket while Waiting, else -1
+        unsigned long upstreamSince;
+        bool keepAlive;             // of the request, then of the response being relayed
+        bool headRequest;
+        bool headSent;
+        size_t responseLength;      // response head bytes buffered so far
+        char response[HTTPS_HEAD_MAX];
+    };
+
+    SettingsStore* settings;
+    TaskHandle_t task;
+    int listenFd;
+    volatile bool running;          // identity ready and listening
+    bool identityGenerated;         // this boot, rather than loaded from NVS
+    char fingerprint[65];           // SHA-256 of the certificate, hex
+
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt certificate;
+    mbedtls_pk_context key;
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_context cache;
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    mbedtls_ssl_ticket_context tickets;
+#endif
+
+    Connection connections[HTTPS_MAX_CONNECTIONS];
+    Resumption resumption;          // set by the callbacks during a handshake step
+    char head[HTTPS_HEAD_MAX];      // request head
+    char forward[HTTPS_HEAD_MAX + 128];
+    uint8_t chunk[1024];
+
+    portMUX_TYPE statsMux;
+    HttpsStats stats;
+
+    static void taskEntry(void* arg);
+    void run();
+    bool loadIdentity();
+    bool generateIdentity();
+    bool setupTls();
+    bool openListener();
+    void acceptClient();
+    void continueHandshake(Connection& connection);
+    bool serve(Connection& connection);
+    bool relayResponse(Connection& connection);
+    bool sendResponseHead(Connection& connection, int end);
+    void closeConnection(Connection& connection);
+    bool writeAll(Connection& connection, const void* data, size_t length);
+    void sendError(Connection& connection, int code, const char* reason);
+    int connectUpstream();
+    void setFingerprint(const uint8_t* der, size_t length);
+    void bump(uint32_t& counter);
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+    static int cacheGet(void* data, mbedtls_ssl_session* session);
+    static int cacheSet(void* data, const mbedtls_ssl_session* session);
+#endif
+#if defined(MBEDTLS_SSL_TICKET_C)
+    static int ticketWrite(void* data, const mbedtls_ssl_session* session, unsigned char* start,
+                           const unsigned char* end, size_t* length, uint32_t* lifetime);
+    static int ticketParse(void* data, mbedtls_ssl_session* session, unsigned char* buffer, size_t length);
+#endif
+
+public:
+    HttpsProxy();
+    // After the web server is listening; the identity is loaded or generated
+    // in the proxy task, off the boot path
+    bool begin(SettingsStore* store);
+
+    HttpsStats getStats();
+    size_t formatReport(char* buffer, size_t size);
+};
+
+#endif // HTTPSPROXY_H
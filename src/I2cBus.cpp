@@ -0,0 +1,183 @@
+#include "I2cBus.h"
+#include "BootProfiler.h"
+
+I2cBus::I2cBus()
+    : stats(), busFailures(0), lastRecovery(0), cycleStart(0), cycleOpen(false), transactionStart(0) {
+    static const struct { const char* name; uint8_t address; } table[] = {
+        { "climate",    ENS210_I2C_ADDR },
+        { "water_low",  WATER_LEVEL_I2C_ADDR_LOW },
+        { "water_high", WATER_LEVEL_I2C_ADDR_HIGH },
+    };
+    for (size_t i = 0; i < (size_t)I2cDevice::COUNT; i++) {
+        devices[i] = I2cDeviceHealth();
+        devices[i].name = table[i].name;
+        devices[i].address = table[i].address;
+        devices[i].healthy = true;
+    }
+}
+
+bool I2cBus::releaseStuckBus() {
+    // If the climate sensor or any device is holding SDA low after power-on/reset,
+    // manually clock SCL 9 times to force the device to release SDA.
+    // A healthy bus (SDA idles high) skips this entirely.
+    pinMode(SHT40_SDA, INPUT_PULLUP);
+    delayMicroseconds(5);
+    bool stuck = digitalRead(SHT40_SDA) == LOW;
+    if (stuck) {
+        Serial.println("I2C: SDA held low, recovering bus");
+        pinMode(SHT40_SCL, OUTPUT);
+        for (int i = 0; i < 9; i++) {
+            digitalWrite(SHT40_SCL, HIGH); delayMicroseconds(5);
+            digitalWrite(SHT40_SCL, LOW);  delayMicroseconds(5);
+        }
+        // Send a STOP condition (SDA low→high while SCL high)
+        pinMode(SHT40_SDA, OUTPUT);
+        digitalWrite(SHT40_SDA, LOW);  delayMicroseconds(5);
+        digitalWrite(SHT40_SCL, HIGH); delayMicroseconds(5);
+        digitalWrite(SHT40_SDA, HIGH); delayMicroseconds(5);
+        // Pins back to input before Wire takes over
+        pinMode(SHT40_SCL, INPUT);
+    }
+    pinMode(SHT40_SDA, INPUT);
+    return stuck;
+}
+
+void I2cBus::startWire() {
+    // Wire must be initialised with our custom pins BEFORE Ens210Driver::begin(),
+    // because the ENS210 library's _i2c_init() calls Wire.begin() with no arguments.
+    Wire.begin(SHT40_SDA, SHT40_SCL);   // SDA=GPIO18, SCL=GPIO17
+    Wire.setClock(100000);
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+}
+
+void I2cBus::begin() {
+    BootProfiler::start("i2c-recovery");
+    if (releaseStuckBus()) {
+        stats.stuckDetected++;
+    }
+    BootProfiler::end("i2c-recovery");
+    startWire();
+}
+
+void I2cBus::recover(const char* reason) {
+    unsigned long now = millis();
+    if (lastRecovery != 0 && now - lastRecovery < I2C_RECOVERY_INTERVAL_MS) {
+        return;
+    }
+    lastRecovery = now;
+    stats.recoveries++;
+    Serial.printf("I2C: bus recovery (%s)\n", reason);
+
+    Wire.end();
+    if (releaseStuckBus()) {
+        stats.stuckDetected++;
+    }
+    startWire();
+    busFailures = 0;
+}
+
+void I2cBus::beginCycle() {
+    cycleStart = micros();
+    cycleOpen = true;
+}
+
+void I2cBus::endCycle() {
+    if (!cycleOpen) {
+        return;
+    }
+    cycleOpen = false;
+    uint32_t elapsed = micros() - cycleStart;
+    stats.cycles++;
+    stats.lastCycleMicros = elapsed;
+    if (elapsed > stats.maxCycleMicros) {
+        stats.maxCycleMicros = elapsed;
+    }
+}
+
+bool I2cBus::acquire(I2cDevice device) {
+    I2cDeviceHealth& d = devices[(size_t)device];
+    if (!d.healthy && (long)(millis() - d.nextAttempt) < 0) {
+        d.backoffSkips++;
+        return false;
+    }
+    if (cycleOpen && micros() - cycleStart > (unsigned long)I2C_CYCLE_BUDGET_MS * 1000UL) {
+        stats.budgetSkips++;
+        return false;
+    }
+    transactionStart = micros();
+    return true;
+}
+
+void I2cBus::identify(I2cDevice device, const char* name, uint8_t address) {
+    devices[(size_t)device].name = name;
+    devices[(size_t)device].address = address;
+}
+
+void I2cBus::release(I2cDevice device, bool ok) {
+    I2cDeviceHealth& d = devices[(size_t)device];
+    d.lastMicros = micros() - transactionStart;
+    if (d.lastMicros > d.maxMicros) {
+        d.maxMicros = d.lastMicros;
+    }
+
+    if (ok) {
+        d.successes++;
+        if (!d.healthy) {
+            Serial.printf("I2C: %s (0x%02X) back after %u failures\n", d.name, d.address, d.consecutiveFailures);
+        }
+        d.healthy = true;
+        d.consecutiveFailures = 0;
+        d.backoffMs = 0;
+        busFailures = 0;
+        return;
+    }
+
+    d.failures++;
+    if (d.consecutiveFailures < 0xFF) {
+        d.consecutiveFailures++;
+    }
+    d.backoffMs = d.backoffMs == 0 ? I2C_BACKOFF_MIN_MS : d.backoffMs * 2;
+    if (d.backoffMs > I2C_BACKOFF_MAX_MS) {
+        d.backoffMs = I2C_BACKOFF_MAX_MS;
+    }
+    d.nextAttempt = millis() + d.backoffMs;
+    if (d.healthy) {
+        Serial.printf("I2C: %s (0x%02X) not responding, retry in %lu ms\n",
+                      d.name, d.address, (unsigned long)d.backoffMs);
+    }
+    d.healthy = false;
+
+    // A slave holding SDA blocks every device; repeated failures suggest a wedged controller
+    if (busFailures < 0xFF) {
+        busFailures++;
+    }
+    if (digitalRead(SHT40_SDA) == LOW) {
+        recover("SDA stuck low");
+    } else if (busFailures >= I2C_RECOVERY_FAILURES) {
+        recover("repeated failures");
+    }
+}
+
+size_t I2cBus::formatStats(char* buffer, size_t size) const {
+    unsigned long now = millis();
+    int n = snprintf(buffer, size,
+                     "recoveries: %lu\nstuck_detected: %lu\ncycles: %lu\nbudget_skips: %lu\n"
+                     "last_cycle_us: %lu\nmax_cycle_us: %lu\ncycle_budget_ms: %d\n\n"
+                     "%-10s %4s %7s %9s %9s %9s %6s %9s %9s %8s\n",
+                     (unsigned long)stats.recoveries, (unsigned long)stats.stuckDetected,
+                     (unsigned long)stats.cycles, (unsigned long)stats.budgetSkips,
+                     (unsigned long)stats.lastCycleMicros, (unsigned long)stats.maxCycleMicros, I2C_CYCLE_BUDGET_MS,
+                     "device", "addr", "state", "ok", "failed", "skipped", "streak", "backoff", "retry_in", "max_us");
+    size_t used = n < 0 ? 0 : (size_t)n;
+    for (size_t i = 0; i < (size_t)I2cDevice::COUNT && used < size; i++) {
+        const I2cDeviceHealth& d = devices[i];
+        unsigned long retryIn = !d.healthy && (long)(d.nextAttempt - now) > 0 ? d.nextAttempt - now : 0;
+        n = snprintf(buffer + used, size - used, "%-10s 0x%02X %7s %9lu %9lu %9lu %6u %9lu %9lu %8lu\n",
+                     d.name, d.address, d.healthy ? "ok" : "backoff",
+                     (unsigned long)d.successes, (unsigned long)d.failures, (unsigned long)d.backoffSkips,
+                     (unsigned)d.consecutiveFailures, (unsigned long)d.backoffMs, retryIn,
+                     (unsigned long)d.maxMicros);
+        used += n < 0 ? 0 : (size_t)n;
+    }
+    return used < size ? used : size - 1;
+}
@@ -0,0 +1,84 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Config.h"
+
+// Sensor I2C bus with per-device health tracking.
+//
+// Every transaction is bracketed by acquire()/release(). A device that fails
+// is skipped with exponential backoff (I2C_BACKOFF_MIN_MS doubling up to
+// I2C_BACKOFF_MAX_MS), so an absent or dead sensor costs at most one
+// Wire timeout per backoff period instead of one per cycle. A failure with
+// SDA held low, or I2C_RECOVERY_FAILURES failures in a row, re-runs the
+// 9-clock bus recovery and re-initialises Wire (rate limited).
+//
+// beginCycle() opens a time budget: once I2C_CYCLE_BUDGET_MS has been spent,
+// further acquire() calls in the same cycle fail and the caller keeps its
+// previous value, which bounds the worst case of one sensor cycle.
+enum class I2cDevice : uint8_t {
+    Climate,        // temperature/humidity sensor bound by ClimateDriver::probe()
+    WaterLow,
+    WaterHigh,
+    COUNT
+};
+
+struct I2cDeviceHealth {
+    const char* name;
+    uint8_t address;
+    bool healthy;
+    uint8_t consecutiveFailures;
+    uint32_t backoffMs;
+    unsigned long nextAttempt;      // millis(); only meaningful while !healthy
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t backoffSkips;
+    uint32_t lastMicros;
+    uint32_t maxMicros;
+};
+
+struct I2cBusStats {
+    uint32_t recoveries;
+    uint32_t stuckDetected;
+    uint32_t cycles;
+    uint32_t budgetSkips;
+    uint32_t lastCycleMicros;
+    uint32_t maxCycleMicros;
+};
+
+class I2cBus {
+private:
+    I2cDeviceHealth devices[(size_t)I2cDevice::COUNT];
+    I2cBusStats stats;
+    uint8_t busFailures;            // consecutive failures on any device
+    unsigned long lastRecovery;
+    unsigned long cycleStart;       // micros()
+    bool cycleOpen;
+    unsigned long transactionStart; // micros()
+
+    void startWire();
+    bool releaseStuckBus();         // true if SDA was held low
+    void recover(const char* reason);
+
+public:
+    I2cBus();
+    void begin();
+
+    void beginCycle();
+    void endCycle();
+
+    // false: skip the transaction (device backing off or cycle budget spent)
+    bool acquire(I2cDevice device);
+    void release(I2cDevice device, bool ok);
+
+    // Names the device after the part found at boot (health is kept)
+    void identify(I2cDevice device, const char* name, uint8_t address);
+
+    bool isHealthy(I2cDevice device) const { return devices[(size_t)device].healthy; }
+    const I2cDeviceHealth& getHealth(I2cDevice device) const { return devices[(size_t)device]; }
+    const I2cBusStats& getStats() const { return stats; }
+    size_t formatStats(char* buffer, size_t size) const;
+};
+
+#endif // I2CBUS_H
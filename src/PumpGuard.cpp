@@ -0,0 +1,219 @@
+#include "PumpGuard.h"
+#include "BootProfiler.h"
+#include <esp_system.h>
+#include <soc/gpio_struct.h>
+#include <cstring>
+
+#define PUMP_GUARD_MAGIC 0x44524750UL   // "PGRD"
+
+static_assert(PUMP_RELAY < 32, "PumpGuard reads and clears the relay in the low GPIO bank");
+
+// The day window and its pump time; a watchdog reset must not refill the budget
+struct PumpGuardRetained {
+    uint32_t magic;
+    uint32_t windowTicks;
+    uint32_t usedTicks;
+    uint32_t days;
+};
+
+static RTC_NOINIT_ATTR PumpGuardRetained retained;
+
+namespace {
+const uint32_t MAX_ON_TICKS = PUMP_MAX_ON_S * 1000UL / PUMP_GUARD_TICK_MS;
+const uint32_t MIN_OFF_TICKS = PUMP_MIN_OFF_S * 1000UL / PUMP_GUARD_TICK_MS;
+const uint32_t DAY_TICKS = 86400000UL / PUMP_GUARD_TICK_MS;
+const uint32_t OFF_TICKS_MAX = UINT32_MAX / PUMP_GUARD_TICK_MS;   // off_ms saturates, ~49 days
+// Pump ticks that deliver the daily budget, 0 = no budget
+const uint32_t BUDGET_TICKS = (uint32_t)((uint64_t)PUMP_DAILY_BUDGET_ML * 60000UL /
+                                         ((uint64_t)PUMP_FLOW_ML_PER_MIN * PUMP_GUARD_TICK_MS));
+
+portMUX_TYPE guardMux = portMUX_INITIALIZER_UNLOCKED;
+hw_timer_t* timer = nullptr;
+void (*cutoffHook)() = nullptr;
+
+// Owned by the timer ISR; the loop side reads them under guardMux
+bool running = false;
+uint32_t runTicks = 0;
+uint32_t offTicks = MIN_OFF_TICKS;      // the first start is never locked out
+uint32_t longestRunTicks = 0;
+uint32_t runs = 0;
+uint32_t trips[(int)PumpTrip::COUNT];
+uint32_t refusals = 0;
+PumpTrip lastTrip = PumpTrip::None;
+PumpTrip pendingCut = PumpTrip::None;
+
+inline uint32_t ticksToMs(uint32_t ticks) { return ticks * PUMP_GUARD_TICK_MS; }
+
+uint32_t ticksToMl(uint32_t ticks) {
+    return (uint32_t)((uint64_t)ticks * PUMP_GUARD_TICK_MS * PUMP_FLOW_ML_PER_MIN / 60000UL);
+}
+
+// Called under guardMux
+PumpTrip lockoutReason() {
+    if (!running && offTicks < MIN_OFF_TICKS) {
+        return PumpTrip::MinOffTime;
+    }
+    if (BUDGET_TICKS && retained.usedTicks >= BUDGET_TICKS) {
+        return PumpTrip::DailyBudget;
+    }
+    return PumpTrip::None;
+}
+
+void IRAM_ATTR onTick() {
+    PumpTrip trip = PumpTrip::None;
+    portENTER_CRITICAL_ISR(&guardMux);
+    if (++retained.windowTicks >= DAY_TICKS) {
+        retained.windowTicks = 0;
+        retained.usedTicks = 0;
+        retained.days++;
+    }
+
+    bool on = (GPIO.out >> PUMP_RELAY) & 1;
+    if (on && !running) {
+        running = true;
+        runTicks = 0;
+        runs++;
+        if (offTicks < MIN_OFF_TICKS) {
+            trip = PumpTrip::MinOffTime;    // switched on without asking mayStart()
+        }
+    }
+    if (on) {
+        runTicks++;
+        retained.usedTicks++;
+        if (trip == PumpTrip::None && MAX_ON_TICKS && runTicks >= MAX_ON_TICKS) {
+            trip = PumpTrip::MaxOnTime;
+        } else if (trip == PumpTrip::None && BUDGET_TICKS && retained.usedTicks >= BUDGET_TICKS) {
+            trip = PumpTrip::DailyBudget;
+        }
+    }
+    if (trip != PumpTrip::None) {
+        GPIO.out_w1tc = 1UL << PUMP_RELAY;
+        trips[(int)trip]++;
+        lastTrip = pendingCut = trip;
+        on = false;
+    }
+
+    if (!on && running) {
+        running = false;
+        offTicks = 0;
+        if (runTicks > longestRunTicks) {
+            longestRunTicks = runTicks;
+        }
+    } else if (!on && offTicks < OFF_TICKS_MAX) {
+        offTicks++;
+    }
+    portEXIT_CRITICAL_ISR(&guardMux);
+
+    if (trip != PumpTrip::None && cutoffHook) {
+        cutoffHook();
+    }
+}
+}
+
+const char* PumpGuard::tripName(PumpTrip trip) {
+    switch (trip) {
+        case PumpTrip::MaxOnTime:   return "max-on-time";
+        case PumpTrip::MinOffTime:  return "min-off-time";
+        case PumpTrip::DailyBudget: return "daily-budget";
+        default:                    return "none";
+    }
+}
+
+void PumpGuard::begin(void (*onCutoff)()) {
+    uint8_t reason = (uint8_t)esp_reset_reason();
+    if (retained.magic != PUMP_GUARD_MAGIC || BootProfiler::isColdReset(reason) ||
+        retained.windowTicks >= DAY_TICKS) {
+        memset(&retained, 0, sizeof(retained));
+        retained.magic = PUMP_GUARD_MAGIC;
+    }
+    cutoffHook = onCutoff;
+
+    // 1 µs timer ticks from the 80 MHz APB clock, alarm every guard tick
+    timer = timerBegin(PUMP_GUARD_TIMER, 80, true);
+    if (!timer) {
+        Serial.println("Pump guard: FAILED to start hardware timer");
+        return;
+    }
+    timerAttachInterrupt(timer, &onTick, true);
+    timerAlarmWrite(timer, PUMP_GUARD_TICK_MS * 1000UL, true);
+    timerAlarmEnable(timer);
+    Serial.printf("Pump guard: max on %d s, min off %d s, budget %d ml/day (%lu ml used)\n",
+                  PUMP_MAX_ON_S, PUMP_MIN_OFF_S, PUMP_DAILY_BUDGET_ML,
+                  (unsigned long)ticksToMl(retained.usedTicks));
+}
+
+bool PumpGuard::mayStart(PumpTrip* reason) {
+    portENTER_CRITICAL(&guardMux);
+    PumpTrip lockout = lockoutReason();
+    if (lockout != PumpTrip::None) {
+        refusals++;
+    }
+    portEXIT_CRITICAL(&guardMux);
+    if (reason) {
+        *reason = lockout;
+    }
+    return lockout == PumpTrip::None;
+}
+
+bool PumpGuard::takeCutoff(PumpTrip* reason) {
+    portENTER_CRITICAL(&guardMux);
+    PumpTrip cut = pendingCut;
+    pendingCut = PumpTrip::None;
+    portEXIT_CRITICAL(&guardMux);
+    if (reason) {
+        *reason = cut;
+    }
+    return cut != PumpTrip::None;
+}
+
+uint32_t PumpGuard::lockoutRemainingMs() {
+    portENTER_CRITICAL(&guardMux);
+    PumpTrip lockout = lockoutReason();
+    uint32_t ticks = 0;
+    if (lockout == PumpTrip::MinOffTime) {
+        ticks = MIN_OFF_TICKS - offTicks;
+    } else if (lockout == PumpTrip::DailyBudget) {
+        ticks = DAY_TICKS - retained.windowTicks;   // until the window rolls over
+    }
+    portEXIT_CRITICAL(&guardMux);
+    return ticksToMs(ticks);
+}
+
+PumpGuardStats PumpGuard::getStats() {
+    PumpGuardStats stats;
+    portENTER_CRITICAL(&guardMux);
+    stats.runs = runs;
+    memcpy(stats.trips, trips, sizeof(stats.trips));
+    stats.refusals = refusals;
+    stats.runMs = ticksToMs(runTicks);
+    stats.longestRunMs = ticksToMs(longestRunTicks > runTicks ? longestRunTicks : runTicks);
+    stats.offMs = running ? 0 : ticksToMs(offTicks);
+    stats.usedMl = ticksToMl(retained.usedTicks);
+    stats.windowMs = ticksToMs(retained.windowTicks);
+    stats.days = retained.days;
+    stats.running = running;
+    stats.lastTrip = lastTrip;
+    portEXIT_CRITICAL(&guardMux);
+    return stats;
+}
+
+size_t PumpGuard::formatReport(char* buffer, size_t size) {
+    PumpGuardStats s = getStats();
+    uint32_t budgetMl = ticksToMl(BUDGET_TICKS);
+    int n = snprintf(buffer, size,
+                     "guard: %s (timer %d, tick %d ms)\nmax_on_s: %d\nmin_off_s: %d\nflow_ml_per_min: %d\n"
+                     "budget_ml_per_day: %d\n\npump: %s\nrun_ms: %lu\nlongest_run_ms: %lu\noff_ms: %lu\n"
+                     "lockout_ms: %lu\nused_ml: %lu\nremaining_ml: %lu\nwindow_elapsed_s: %lu\ndays: %lu\n\n"
+                     "runs: %lu\nrefused_starts: %lu\ntrips_max_on: %lu\ntrips_min_off: %lu\ntrips_budget: %lu\n"
+                     "last_trip: %s\n",
+                     timer ? "running" : "off", PUMP_GUARD_TIMER, PUMP_GUARD_TICK_MS, PUMP_MAX_ON_S,
+                     PUMP_MIN_OFF_S, PUMP_FLOW_ML_PER_MIN, PUMP_DAILY_BUDGET_ML,
+                     s.running ? "on" : "off", (unsigned long)s.runMs, (unsigned long)s.longestRunMs,
+                     (unsigned long)s.offMs, (unsigned long)lockoutRemainingMs(), (unsigned long)s.usedMl,
+                     (unsigned long)(budgetMl > s.usedMl ? budgetMl - s.usedMl : 0),
+                     (unsigned long)(s.windowMs / 1000), (unsigned long)s.days, (unsigned long)s.runs,
+                     (unsigned long)s.refusals, (unsigned long)s.trips[(int)PumpTrip::MaxOnTime],
+                     (unsigned long)s.trips[(int)PumpTrip::MinOffTime],
+                     (unsigned long)s.trips[(int)PumpTrip::DailyBudget], tripName(s.lastTrip));
+    return n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+}
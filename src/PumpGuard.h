@@ -0,0 +1,62 @@
+#ifndef PUMPGUARD_H
+#define PUMPGUARD_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Pump runtime limiter on a hardware timer interrupt.
+//
+// Every PUMP_GUARD_TICK_MS the timer ISR samples the relay output register
+// and does the accounting: continuous on-time, off-time since the last run and
+// the pump time used in the current day window. It cuts the relay itself when
+// a run exceeds PUMP_MAX_ON_S, when the daily volume budget is spent, or when
+// the relay was switched on before PUMP_MIN_OFF_S had passed - whoever
+// switched it and whether or not the loop task is running.
+//
+// setPumpState() asks mayStart() first, so normal starts are refused instead
+// of being cut. After a cut the ISR calls the cutoff hook (it notifies a
+// scheduler job) and takeCutoff() lets the loop side catch up.
+//
+// Volume is estimated from on-time and PUMP_FLOW_ML_PER_MIN. The day window is
+// 24 h of timer ticks, i.e. of uptime, not a calendar day: it starts at a cold
+// boot and does not follow the clock. It and the used budget survive warm resets.
+// A limit of 0 disables it.
+enum class PumpTrip : uint8_t {
+    None,
+    MaxOnTime,
+    MinOffTime,
+    DailyBudget,
+    COUNT
+};
+
+struct PumpGuardStats {
+    uint32_t runs;                  // off -> on edges seen by the timer
+    uint32_t trips[(int)PumpTrip::COUNT];
+    uint32_t refusals;              // starts refused by mayStart()
+    uint32_t runMs;                 // current or last run
+    uint32_t longestRunMs;
+    uint32_t offMs;                 // since the last run ended (saturates)
+    uint32_t usedMl;                // in this day window
+    uint32_t windowMs;              // into this day window
+    uint32_t days;                  // windows completed since a cold boot
+    bool running;
+    PumpTrip lastTrip;
+};
+
+class PumpGuard {
+public:
+    // After the relay pin is configured; the hook runs in the timer ISR
+    static void begin(void (*onCutoff)());
+
+    // Loop side: false (and counted) during the min-off lockout or with the
+    // budget spent; the reason goes to *reason
+    static bool mayStart(PumpTrip* reason = nullptr);
+    static bool takeCutoff(PumpTrip* reason = nullptr);   // true once per ISR cut
+
+    static PumpGuardStats getStats();
+    static uint32_t lockoutRemainingMs();
+    static size_t formatReport(char* buffer, size_t size);
+    static const char* tripName(PumpTrip trip);
+};
+
+#endif // PUMPGUARD_H
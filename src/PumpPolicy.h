@@ -0,0 +1,52 @@
+#ifndef PUMPPOLICY_H
+#define PUMPPOLICY_H
+
+#include <stdint.h>
+#include "Config.h"
+
+// Automatic pump decision for one sensor cycle. Pure and Arduino-free: the
+// firmware (runSensorCycle) and the host trace replayer (tools/trace_replay.cpp)
+// run the same code, so a replayed trace shows what this build would have done.
+
+enum class PumpAction : uint8_t {
+    None,
+    StopWaterLow,       // 1. safety: water at or below PUMP_WATER_MIN_PCT
+    StopSoilWet,        // 3. soil reached PUMP_SOIL_WET_PCT
+    StartSoilDry,       // 4. soil below PUMP_SOIL_DRY_PCT, water available, no anomaly
+    StopAnomaly         // 2. an AnomalyDetector alarm says the readings or the pump can't be trusted
+};
+
+// Rules in priority order; returns None when the pump should stay as it is.
+// anomaly: AnomalyDetector::blocksPump() for this cycle
+inline PumpAction decidePump(int soilPercentage, int waterPercentage, bool pumpOn, bool anomaly = false) {
+    if (pumpOn) {
+        if (waterPercentage <= PUMP_WATER_MIN_PCT) {
+            return PumpAction::StopWaterLow;
+        }
+        if (anomaly) {
+            return PumpAction::StopAnomaly;
+        }
+        if (soilPercentage >= PUMP_SOIL_WET_PCT) {
+            return PumpAction::StopSoilWet;
+        }
+    } else if (!anomaly && soilPercentage < PUMP_SOIL_DRY_PCT && waterPercentage > PUMP_WATER_MIN_PCT) {
+        return PumpAction::StartSoilDry;
+    }
+    return PumpAction::None;
+}
+
+inline bool pumpActionState(PumpAction action, bool pumpOn) {
+    return action == PumpAction::None ? pumpOn : action == PumpAction::StartSoilDry;
+}
+
+inline const char* pumpActionName(PumpAction action) {
+    switch (action) {
+        case PumpAction::StopWaterLow: return "stop-water-low";
+        case PumpAction::StopSoilWet:  return "stop-soil-wet";
+        case PumpAction::StartSoilDry: return "start-soil-dry";
+        case PumpAction::StopAnomaly:  return "stop-anomaly";
+        default:                       return "none";
+    }
+}
+
+#endif // PUMPPOLICY_H
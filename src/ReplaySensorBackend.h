@@ -0,0 +1,65 @@
+#ifndef REPLAYSENSORBACKEND_H
+#define REPLAYSENSORBACKEND_H
+
+#include <stdio.h>
+#include "SensorBackend.h"
+
+// Plays back recorded raw samples, one per sensor cycle (measureClimate()
+// advances). At the end the trace either restarts or holds its last sample.
+// The samples are not copied and must outlive the backend.
+class ReplaySensorBackend {
+private:
+    const SensorSample* samples = nullptr;
+    size_t count = 0;
+    size_t next = 0;
+    size_t current = 0;
+    bool repeat = true;
+    bool finished = false;
+    uint32_t cycles = 0;
+
+    const SensorSample* sample() const { return count ? &samples[current] : nullptr; }
+
+public:
+    void load(const SensorSample* trace, size_t length, bool loop = true) {
+        samples = trace;
+        count = length;
+        next = 0;
+        current = 0;
+        repeat = loop;
+        finished = false;
+        cycles = 0;
+    }
+
+    void begin() {}
+    void beginCycle() {}
+    void endCycle() {}
+    void measureClimate() {
+        if (count == 0) {
+            return;
+        }
+        if (next >= count) {
+            if (!repeat) {
+                finished = true;
+                return;     // hold the last sample
+            }
+            next = 0;
+        }
+        current = next++;
+        cycles++;
+    }
+    float readTemperature() { return count ? sample()->temperature : SENSOR_NO_READING; }
+    float readHumidity() { return count ? sample()->humidity : SENSOR_NO_READING; }
+    int readSoilRaw() { return count ? sample()->soilRaw : 4095; }
+    int readWaterSections() { return count ? sample()->waterSections : 0; }
+    size_t formatDiagnostics(char* buffer, size_t size) const {
+        int n = snprintf(buffer, size, "backend: replay\nsamples: %u\nposition: %u\ncycles: %lu\nfinished: %s\n",
+                         (unsigned)count, (unsigned)current, (unsigned long)cycles, finished ? "yes" : "no");
+        return n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+    }
+    static const char* name() { return "replay"; }
+
+    bool isFinished() const { return finished; }
+    size_t getPosition() const { return current; }
+};
+
+#endif // REPLAYSENSORBACKEND_H
@@ -0,0 +1,182 @@
+#include "RequestArena.h"
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <stdarg.h>
+
+bool StrView::equals(const char* text) const {
+    return strlen(text) == length && memcmp(data, text, length) == 0;
+}
+
+bool StrView::toInt(int& out) const {
+    size_t i = 0;
+    bool negative = false;
+    if (i < length && (data[i] == '-' || data[i] == '+')) {
+        negative = data[i] == '-';
+        i++;
+    }
+    if (i == length) {
+        return false;
+    }
+    long long value = 0;
+    for (; i < length; i++) {
+        char c = data[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+        if (value > (long long)INT_MAX + 1) {
+            return false;
+        }
+    }
+    if (negative) {
+        value = -value;
+    }
+    if (value > INT_MAX || value < INT_MIN) {
+        return false;
+    }
+    out = (int)value;
+    return true;
+}
+
+bool StrView::toFloat(float& out) const {
+    if (length == 0 || data[length] != '\0') {
+        return false;
+    }
+    char* end = nullptr;
+    float value = strtof(data, &end);
+    if (end != data + length) {
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+ArenaWriter::ArenaWriter(char* storage, size_t size)
+    : buffer(storage), capacity(storage ? size : 0), used(0), truncated(false) {
+    if (capacity > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+void ArenaWriter::clear() {
+    used = 0;
+    truncated = false;
+    if (capacity > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+void ArenaWriter::append(const char* text, size_t length) {
+    size_t space = remaining();
+    if (length > space) {
+        length = space;
+        truncated = true;
+    }
+    if (length == 0) {
+        return;
+    }
+    memcpy(buffer + used, text, length);
+    used += length;
+    buffer[used] = '\0';
+}
+
+void ArenaWriter::append(const char* text) {
+    append(text, strlen(text));
+}
+
+void ArenaWriter::append(char c) {
+    append(&c, 1);
+}
+
+void ArenaWriter::appendInt(long value) {
+    char digits[12];
+    int n = snprintf(digits, sizeof(digits), "%ld", value);
+    append(digits, n);
+}
+
+void ArenaWriter::appendUnsigned(unsigned long value) {
+    char digits[12];
+    int n = snprintf(digits, sizeof(digits), "%lu", value);
+    append(digits, n);
+}
+
+void ArenaWriter::appendf(const char* format, ...) {
+    if (capacity == 0) {
+        truncated = true;
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + used, capacity - used, format, args);
+    va_end(args);
+    if (n < 0) {
+        buffer[used] = '\0';
+        return;
+    }
+    if ((size_t)n > remaining()) {
+        truncated = true;
+        used = capacity - 1;   // vsnprintf already wrote as much as fits
+    } else {
+        used += n;
+    }
+}
+
+void ArenaWriter::appendJsonEscaped(const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        switch (c) {
+            case '"':  append("\\\"", 2); break;
+            case '\\': append("\\\\", 2); break;
+            default:
+                if ((uint8_t)c < 0x20) {
+                    appendf("\\u%04x", (unsigned)(uint8_t)c);
+                } else {
+                    append(c);
+                }
+                break;
+        }
+    }
+}
+
+void ArenaWriter::appendHtmlEscaped(const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        switch (c) {
+            case '&':  append("&amp;", 5); break;
+            case '<':  append("&lt;", 4); break;
+            case '>':  append("&gt;", 4); break;
+            case '"':  append("&quot;", 6); break;
+            case '\'': append("&#39;", 5); break;
+            default:   append(c); break;
+        }
+    }
+}
+
+void RequestArena::reset() {
+    used = 0;
+    resets++;
+}
+
+char* RequestArena::alloc(size_t size) {
+    // Keep allocations 4-byte aligned so callers may store small structs
+    size_t aligned = (size + 3) & ~(size_t)3;
+    if (aligned > sizeof(storage) - used) {
+        exhausted++;
+        return nullptr;
+    }
+    char* block = storage + used;
+    used += aligned;
+    if (used > highWater) {
+        highWater = used;
+    }
+    return block;
+}
+
+ArenaWriter RequestArena::writer(size_t size) {
+    if (size == 0) {
+        size = sizeof(storage) - used;
+    }
+    char* block = alloc(size);
+    return block ? ArenaWriter(block, size) : ArenaWriter();
+}
@@ -0,0 +1,79 @@
+#ifndef REQUESTARENA_H
+#define REQUESTARENA_H
+
+#include <Arduino.h>
+
+// Heap-free building blocks for the web and auth paths.
+//
+// RequestArena is a fixed bump allocator owned by WebServerManager and reset
+// before every request, so per-request scratch (response bodies, formatted
+// values) never touches malloc. ArenaWriter appends text into any fixed buffer
+// (an arena allocation or a member array) and truncates instead of growing.
+// StrView is a non-owning view used to parse request arguments in place.
+
+#define REQUEST_ARENA_SIZE 4096
+
+struct StrView {
+    const char* data;   // NUL-terminated when it comes from WebServerManager::Server::argView()
+    size_t length;
+
+    StrView() : data(""), length(0) {}
+    StrView(const char* text, size_t len) : data(text), length(len) {}
+
+    bool empty() const { return length == 0; }
+    bool equals(const char* text) const;
+    bool toInt(int& out) const;       // optional sign + digits only, false on overflow/garbage
+    bool toFloat(float& out) const;   // whole view must parse
+};
+
+class ArenaWriter {
+private:
+    char* buffer;
+    size_t capacity;    // including the terminating NUL
+    size_t used;
+    bool truncated;
+
+public:
+    ArenaWriter() : buffer(nullptr), capacity(0), used(0), truncated(false) {}
+    ArenaWriter(char* storage, size_t size);
+
+    void clear();
+    void append(char c);
+    void append(const char* text);
+    void append(const char* text, size_t length);
+    void append(const StrView& text) { append(text.data, text.length); }
+    void appendInt(long value);
+    void appendUnsigned(unsigned long value);
+    void appendf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void appendJsonEscaped(const char* text, size_t length);
+    void appendHtmlEscaped(const char* text, size_t length);
+
+    const char* c_str() const { return buffer ? buffer : ""; }
+    size_t length() const { return used; }
+    size_t remaining() const { return capacity > used ? capacity - used - 1 : 0; }
+    bool overflowed() const { return truncated; }
+};
+
+class RequestArena {
+private:
+    alignas(4) char storage[REQUEST_ARENA_SIZE];
+    size_t used;
+    size_t highWater;
+    uint32_t resets;
+    uint32_t exhausted;   // allocations refused because the arena was full
+
+public:
+    RequestArena() : used(0), highWater(0), resets(0), exhausted(0) {}
+
+    void reset();
+    char* alloc(size_t size);               // nullptr when it does not fit
+    ArenaWriter writer(size_t size = 0);    // 0 = everything that is left
+
+    size_t getCapacity() const { return sizeof(storage); }
+    size_t getUsed() const { return used; }
+    size_t getHighWater() const { return highWater; }
+    uint32_t getResets() const { return resets; }
+    uint32_t getExhausted() const { return exhausted; }
+};
+
+#endif // REQUESTARENA_H
@@ -0,0 +1,59 @@
+#include "Routes.h"
+
+namespace Routes {
+
+static const Route* lookup(const char* path, size_t length, bool withParam) {
+    uint8_t index = SLOTS[hash(path, length) & (ROUTE_SLOT_COUNT - 1)];
+    if (index == ROUTE_NONE) {
+        return nullptr;
+    }
+    const Route& route = TABLE[index];
+    if (route.hasParam != withParam || route.length != length || memcmp(route.path, path, length) != 0) {
+        return nullptr;
+    }
+    return &route;
+}
+
+// Accepts an optional '-' followed by 1-6 digits, nothing else
+static bool parseIntSegment(const char* text, int& value) {
+    bool negative = (*text == '-');
+    if (negative) {
+        text++;
+    }
+    int digits = 0;
+    long result = 0;
+    for (; *text; text++, digits++) {
+        if (*text < '0' || *text > '9' || digits >= 6) {
+            return false;
+        }
+        result = result * 10 + (*text - '0');
+    }
+    if (digits == 0) {
+        return false;
+    }
+    value = negative ? -(int)result : (int)result;
+    return true;
+}
+
+RouteMatch resolve(HTTPMethod method, const char* uri) {
+    RouteMatch match = { RouteId::NotFound, 0 };
+    size_t length = strlen(uri);
+    
+    const Route* route = lookup(uri, length, false);
+    if (!route) {
+        // Try "/prefix/" + integer segment
+        const char* slash = strrchr(uri, '/');
+        if (slash && parseIntSegment(slash + 1, match.param)) {
+            route = lookup(uri, (size_t)(slash - uri) + 1, true);
+        }
+    }
+    
+    if (route && (route->method == HTTP_ANY || route->method == method)) {
+        match.id = route->id;
+    } else {
+        match.param = 0;
+    }
+    return match;
+}
+
+} // namespace Routes
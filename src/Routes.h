@@ -0,0 +1,178 @@
+#ifndef ROUTES_H
+#define ROUTES_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include "Config.h"
+
+// Compile-time route table for WebServerManager.
+//
+// Every URL lives in Routes::TABLE below. At compile time each path is hashed
+// (FNV-1a) into one of ROUTE_SLOT_COUNT slots and the slot -> route index table
+// is generated from that table, so a lookup is one hash, one table read and
+// one string compare regardless of how many routes exist. If a new route
+// collides with an existing one the isPerfect() static_assert fails the build;
+// count ROUTE_HASH_SEED up until every route gets a slot of its own.
+//
+// Parameterised routes ("/toggle/{}") are stored by their prefix including the
+// trailing '/' and receive the last path segment as a typed int.
+
+#define ROUTE_SLOT_COUNT 128           // power of two, keep well above the route count
+#define ROUTE_HASH_SEED  2166136271u   // FNV-1a offset basis + 10, the first without collisions
+#define ROUTE_NONE       0xFF
+
+enum class RouteId : uint8_t {
+    Root,
+    Connect,
+    ConnectStatus,
+    ScanNetworks,
+    Dashboard,
+    Toggle,
+    Brightness,
+    Commands,
+    Stats,
+    Simulation,
+    Favicon,
+    CaptiveRedirect,   // OS connectivity probes -> redirect to the portal
+    CaptiveNoContent,  // answer 204 directly
+    CaptiveOk,         // answer 200 with empty body
+    DebugRoutes,
+    DebugDns,
+    DebugScheduler,
+    DebugHeap,
+    DebugSoak,
+    DebugBoot,
+    DebugI2c,
+    DebugWifi,
+    DebugHttp,
+    DebugDeadline,
+    DebugPump,
+    DebugAnomaly,
+    DebugTrace,
+    DebugTls,
+    Calibration,
+    NotFound
+};
+
+struct Route {
+    const char* path;
+    uint8_t length;
+    HTTPMethod method;
+    RouteId id;
+    bool hasParam;     // path is a prefix followed by one integer segment
+};
+
+struct RouteMatch {
+    RouteId id;
+    int param;
+};
+
+#define ROUTE(path, method, id)       { path, sizeof(path) - 1, method, RouteId::id, false }
+#define ROUTE_PARAM(path, method, id) { path, sizeof(path) - 1, method, RouteId::id, true }
+
+namespace Routes {
+
+constexpr Route TABLE[] = {
+    ROUTE("/",                          HTTP_ANY,  Root),
+    ROUTE("/connect",                   HTTP_POST, Connect),
+    ROUTE("/connect-status",            HTTP_GET,  ConnectStatus),
+    ROUTE("/scan-networks",             HTTP_GET,  ScanNetworks),
+    ROUTE("/dashboard",                 HTTP_GET,  Dashboard),
+    ROUTE_PARAM("/toggle/",             HTTP_ANY,  Toggle),
+    ROUTE_PARAM("/brightness/",         HTTP_ANY,  Brightness),
+    ROUTE("/api/commands",              HTTP_POST, Commands),
+    ROUTE("/api/stats",                 HTTP_GET,  Stats),
+#if SIMULATION_MODE
+    ROUTE("/simulation",                HTTP_POST, Simulation),
+#endif
+    ROUTE("/favicon.ico",               HTTP_ANY,  Favicon),
+    ROUTE("/calibration",               HTTP_ANY,  Calibration),
+    ROUTE("/debug/routes",              HTTP_GET,  DebugRoutes),
+    ROUTE("/debug/dns",                 HTTP_GET,  DebugDns),
+    ROUTE("/debug/scheduler",           HTTP_GET,  DebugScheduler),
+    ROUTE("/debug/heap",                HTTP_GET,  DebugHeap),
+    ROUTE("/debug/boot",                HTTP_GET,  DebugBoot),
+    ROUTE("/debug/i2c",                 HTTP_GET,  DebugI2c),
+    ROUTE("/debug/wifi",                HTTP_GET,  DebugWifi),
+    ROUTE("/debug/http",                HTTP_GET,  DebugHttp),
+    ROUTE("/debug/deadline",            HTTP_GET,  DebugDeadline),
+    ROUTE("/debug/pump",                HTTP_GET,  DebugPump),
+    ROUTE("/debug/anomaly",             HTTP_ANY,  DebugAnomaly),
+#if TRACE_RECORDER_ENABLED
+    ROUTE("/debug/trace",               HTTP_ANY,  DebugTrace),
+#endif
+#if HTTPS_ENABLED
+    ROUTE("/debug/tls",                 HTTP_GET,  DebugTls),
+#endif
+#if SOAK_TEST_MODE
+    ROUTE("/debug/soak",                HTTP_GET,  DebugSoak),
+#endif
+
+    // Captive portal detection routes (for various devices/OS)
+    // Android
+    ROUTE("/generate_204",              HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/gen_204",                   HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/204",                       HTTP_ANY,  CaptiveNoContent),
+    // Apple/iOS
+    ROUTE("/hotspot-detect.html",       HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/library/test/success.html", HTTP_ANY,  CaptiveRedirect),
+    // Windows
+    ROUTE("/ncsi.txt",                  HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/connecttest.txt",           HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/redirect",                  HTTP_ANY,  CaptiveRedirect),
+    // Other
+    ROUTE("/canonical.html",            HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/success.txt",               HTTP_ANY,  CaptiveRedirect),
+    ROUTE("/ipv6check",                 HTTP_ANY,  CaptiveOk),
+};
+
+constexpr size_t COUNT = sizeof(TABLE) / sizeof(TABLE[0]);
+
+constexpr uint32_t hash(const char* s, size_t n, uint32_t h = ROUTE_HASH_SEED) {
+    return n == 0 ? h : hash(s + 1, n - 1, (h ^ (uint8_t)*s) * 16777619u);
+}
+
+constexpr uint32_t slotOf(const Route& r) {
+    return hash(r.path, r.length) & (ROUTE_SLOT_COUNT - 1);
+}
+
+// Index of the route owning slot k, or ROUTE_NONE
+constexpr uint8_t findSlot(uint32_t k, size_t i = 0) {
+    return i == COUNT ? ROUTE_NONE : (slotOf(TABLE[i]) == k ? (uint8_t)i : findSlot(k, i + 1));
+}
+
+// True if no route after j shares route i's slot
+constexpr bool slotUnique(size_t i, size_t j) {
+    return j >= COUNT ? true : slotOf(TABLE[i]) != slotOf(TABLE[j]) && slotUnique(i, j + 1);
+}
+
+// Nested rather than one pairwise chain, so the constexpr depth grows with
+// COUNT instead of COUNT^2 (GCC stops at 512)
+constexpr bool isPerfect(size_t i = 0) {
+    return i >= COUNT ? true : slotUnique(i, i + 1) && isPerfect(i + 1);
+}
+
+static_assert(COUNT < ROUTE_NONE, "Too many routes for 8-bit slot indices");
+static_assert(ROUTE_SLOT_COUNT == 128, "SLOTS initializer below assumes 128 slots");
+static_assert(isPerfect(), "Route hash collision - increment ROUTE_HASH_SEED");
+
+#define ROUTE_SLOTS_8(k) findSlot(k), findSlot(k + 1), findSlot(k + 2), findSlot(k + 3), \
+                         findSlot(k + 4), findSlot(k + 5), findSlot(k + 6), findSlot(k + 7)
+#define ROUTE_SLOTS_32(k) ROUTE_SLOTS_8(k), ROUTE_SLOTS_8(k + 8), ROUTE_SLOTS_8(k + 16), ROUTE_SLOTS_8(k + 24)
+
+constexpr uint8_t SLOTS[ROUTE_SLOT_COUNT] = {
+    ROUTE_SLOTS_32(0), ROUTE_SLOTS_32(32), ROUTE_SLOTS_32(64), ROUTE_SLOTS_32(96)
+};
+
+#undef ROUTE_SLOTS_32
+#undef ROUTE_SLOTS_8
+
+// Resolves a request path (no query string) to a route; NotFound if nothing matches
+RouteMatch resolve(HTTPMethod method, const char* uri);
+
+} // namespace Routes
+
+#undef ROUTE
+#undef ROUTE_PARAM
+
+#endif // ROUTES_H
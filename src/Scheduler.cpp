@@ -0,0 +1,223 @@
+#include "Scheduler.h"
+#include "DeadlineMonitor.h"
+
+Scheduler::Scheduler()
+    : jobCount(0), currentTick(0), dueMask(0), eventMask(0), loopTask(nullptr), wakeups(0), idleMs(0)
+#if SOAK_TEST_MODE
+    , soakMonitor(nullptr)
+#endif
+{
+    memset(wheel, SCHEDULER_NO_JOB, sizeof(wheel));
+}
+
+void Scheduler::begin() {
+    loopTask = xTaskGetCurrentTaskHandle();
+    currentTick = millis();
+}
+
+JobId Scheduler::addJob(const char* name, uint32_t periodMs, std::function<void()> function, uint32_t firstDelayMs) {
+    if (jobCount >= SCHEDULER_MAX_JOBS) {
+        Serial.printf("Scheduler: no room for job '%s'\n", name);
+        return SCHEDULER_NO_JOB;
+    }
+    JobId id = jobCount++;
+    SchedulerJob& job = jobs[id];
+    job = SchedulerJob();
+    job.name = name;
+    job.function = function;
+    job.periodMs = periodMs;
+    job.nextInSlot = SCHEDULER_NO_JOB;
+    if (periodMs > 0) {
+        job.deadline = currentTick + firstDelayMs;
+        insertTimer(id);
+    }
+    return id;
+}
+
+JobId Scheduler::addPeriodic(const char* name, uint32_t periodMs, std::function<void()> function, uint32_t firstDelayMs) {
+    return addJob(name, periodMs > 0 ? periodMs : 1, function, firstDelayMs);
+}
+
+JobId Scheduler::addEvent(const char* name, std::function<void()> function) {
+    return addJob(name, 0, function, 0);
+}
+
+void Scheduler::notify(JobId id) {
+    if (id >= jobCount) {
+        return;
+    }
+    eventMask.fetch_or(1u << id);
+    if (loopTask) {
+        xTaskNotifyGive(loopTask);
+    }
+}
+
+void IRAM_ATTR Scheduler::notifyFromISR(JobId id) {
+    if (id >= jobCount) {
+        return;
+    }
+    eventMask.fetch_or(1u << id);
+    if (loopTask) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTask, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+void Scheduler::insertTimer(JobId id) {
+    SchedulerJob& job = jobs[id];
+    int32_t delta = (int32_t)(job.deadline - currentTick);
+    if (delta <= 0) {
+        dueMask |= 1u << id;
+        return;
+    }
+
+    // Pick the lowest level whose span covers the delay; deadlines beyond the
+    // top level are parked in its last slot and re-inserted when they surface
+    uint32_t expires = job.deadline;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && (uint32_t)delta >= (1u << (WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    if (level == WHEEL_LEVELS - 1 && (uint64_t)delta >= (1ull << (WHEEL_BITS * WHEEL_LEVELS))) {
+        expires = currentTick + (uint32_t)((1ull << (WHEEL_BITS * WHEEL_LEVELS)) - 1);
+    }
+    uint8_t slot = (expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    job.nextInSlot = wheel[level][slot];
+    wheel[level][slot] = id;
+}
+
+void Scheduler::cascade(int level) {
+    uint8_t slot = (currentTick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    JobId id = wheel[level][slot];
+    wheel[level][slot] = SCHEDULER_NO_JOB;
+    while (id != SCHEDULER_NO_JOB) {
+        JobId next = jobs[id].nextInSlot;
+        insertTimer(id);
+        id = next;
+    }
+}
+
+void Scheduler::advanceTo(uint32_t now) {
+    while ((int32_t)(now - currentTick) > 0) {
+        currentTick++;
+
+        // Level 0 wrapped: pull the next slot of each higher level down
+        if ((currentTick & WHEEL_MASK) == 0) {
+            for (int level = 1; level < WHEEL_LEVELS; level++) {
+                cascade(level);
+                if (((currentTick >> (WHEEL_BITS * level)) & WHEEL_MASK) != 0) {
+                    break;
+                }
+            }
+        }
+
+        uint8_t slot = currentTick & WHEEL_MASK;
+        JobId id = wheel[0][slot];
+        wheel[0][slot] = SCHEDULER_NO_JOB;
+        while (id != SCHEDULER_NO_JOB) {
+            JobId next = jobs[id].nextInSlot;
+            insertTimer(id);   // marks due, or re-parks a clamped far deadline
+            id = next;
+        }
+    }
+}
+
+uint32_t Scheduler::msUntilNextTimer() const {
+    // Earliest non-empty level-0 slot, but never sleep past the next cascade
+    uint32_t untilCascade = WHEEL_SIZE - (currentTick & WHEEL_MASK);
+    for (uint32_t i = 1; i < untilCascade; i++) {
+        if (wheel[0][(currentTick + i) & WHEEL_MASK] != SCHEDULER_NO_JOB) {
+            return i;
+        }
+    }
+    return untilCascade;
+}
+
+void Scheduler::runJob(JobId id, uint32_t now) {
+    SchedulerJob& job = jobs[id];
+    bool timerRun = (job.periodMs > 0) && (int32_t)(now - job.deadline) >= 0;
+
+    if (timerRun) {
+        job.lastLatenessMs = now - job.deadline;
+        if (job.lastLatenessMs > job.maxLatenessMs) {
+            job.maxLatenessMs = job.lastLatenessMs;
+        }
+    }
+
+    unsigned long start = micros();
+    DeadlineMonitor::enterJob(job.name);
+    {
+#if SOAK_TEST_MODE
+        SoakMonitor::Scope soakScope(soakMonitor, job.name);
+#endif
+        job.function();
+    }
+    job.lastRuntimeUs = micros() - start;
+    DeadlineMonitor::exitJob(job.lastRuntimeUs);
+    if (job.lastRuntimeUs > job.maxRuntimeUs) {
+        job.maxRuntimeUs = job.lastRuntimeUs;
+    }
+    job.runs++;
+
+    if (timerRun) {
+        uint32_t finished = millis();
+        job.deadline += job.periodMs;
+        if ((int32_t)(finished - job.deadline) >= 0) {
+            // Missed at least one period - count it and skip ahead instead of bursting
+            job.overruns++;
+            job.deadline = finished + job.periodMs;
+        }
+        insertTimer(id);
+    }
+}
+
+void Scheduler::run() {
+    advanceTo(millis());
+
+    uint32_t events = eventMask.exchange(0);
+    uint32_t ready = dueMask | events;
+    dueMask = 0;
+
+    // Registration order is priority order
+    for (JobId id = 0; id < jobCount; id++) {
+        uint32_t bit = 1u << id;
+        if (!(ready & bit)) {
+            continue;
+        }
+        if (events & bit) {
+            jobs[id].notifications++;
+        }
+        runJob(id, currentTick);
+    }
+
+    // Sleep until the next timer or a notification
+    advanceTo(millis());
+    if (dueMask || eventMask.load()) {
+        return;
+    }
+    uint32_t wait = msUntilNextTimer();
+    uint32_t sleepStart = millis();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    idleMs += millis() - sleepStart;
+    wakeups++;
+}
+
+size_t Scheduler::formatStats(char* buffer, size_t size) const {
+    size_t used = snprintf(buffer, size, "wakeups: %lu\nidle_ms: %lu\nuptime_ms: %lu\n\n"
+                           "%-10s %8s %8s %8s %6s %8s %8s %10s %10s\n",
+                           (unsigned long)wakeups, (unsigned long)idleMs, (unsigned long)millis(),
+                           "job", "period", "next_in", "runs", "notif", "overrun",
+                           "late_max", "run_us", "run_max_us");
+    uint32_t now = millis();
+    for (JobId id = 0; id < jobCount && used < size; id++) {
+        const SchedulerJob& job = jobs[id];
+        long nextIn = job.periodMs > 0 ? (long)(int32_t)(job.deadline - now) : -1;
+        used += snprintf(buffer + used, size - used, "%-10s %8lu %8ld %8lu %6lu %8lu %8lu %10lu %10lu\n",
+                         job.name, (unsigned long)job.periodMs, nextIn,
+                         (unsigned long)job.runs, (unsigned long)job.notifications,
+                         (unsigned long)job.overruns, (unsigned long)job.maxLatenessMs,
+                         (unsigned long)job.lastRuntimeUs, (unsigned long)job.maxRuntimeUs);
+    }
+    return used < size ? used : size - 1;
+}
@@ -0,0 +1,93 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "Config.h"
+#if SOAK_TEST_MODE
+#include "SoakMonitor.h"
+#endif
+
+// Cooperative scheduler for the loop task.
+//
+// Periodic jobs sit in a hierarchical timer wheel (4 levels x 64 slots, 1 ms
+// ticks, ~4.6 h span). Event jobs run only when notify()/notifyFromISR() is
+// called from another task or an interrupt. Between jobs the loop task blocks
+// on its FreeRTOS task notification until the next timer is due or an event
+// arrives, instead of spinning with delay().
+
+#define SCHEDULER_MAX_JOBS   16
+#define SCHEDULER_NO_JOB     0xFF
+#define WHEEL_LEVELS         4
+#define WHEEL_BITS           6
+#define WHEEL_SIZE           (1 << WHEEL_BITS)
+#define WHEEL_MASK           (WHEEL_SIZE - 1)
+
+typedef uint8_t JobId;
+
+struct SchedulerJob {
+    const char* name;
+    std::function<void()> function;
+    uint32_t periodMs;         // 0 = event job
+    uint32_t deadline;         // millis() the job is next due (periodic jobs)
+    uint8_t nextInSlot;        // timer wheel list link
+
+    // Statistics
+    uint32_t runs;
+    uint32_t notifications;
+    uint32_t overruns;         // periodic run finished after its next deadline
+    uint32_t lastLatenessMs;
+    uint32_t maxLatenessMs;
+    uint32_t lastRuntimeUs;
+    uint32_t maxRuntimeUs;
+};
+
+class Scheduler {
+private:
+    SchedulerJob jobs[SCHEDULER_MAX_JOBS];
+    uint8_t jobCount;
+    uint8_t wheel[WHEEL_LEVELS][WHEEL_SIZE];
+    uint32_t currentTick;          // last millis() value the wheel has processed
+    uint32_t dueMask;              // periodic jobs whose timer expired
+    std::atomic<uint32_t> eventMask; // notified jobs (set from other tasks/ISRs)
+    TaskHandle_t loopTask;
+
+    uint32_t wakeups;
+    uint32_t idleMs;
+#if SOAK_TEST_MODE
+    SoakMonitor* soakMonitor;   // charges each job's heap delta to the job name
+#endif
+
+    void insertTimer(JobId id);
+    void advanceTo(uint32_t now);
+    void cascade(int level);
+    uint32_t msUntilNextTimer() const;
+    void runJob(JobId id, uint32_t now);
+    JobId addJob(const char* name, uint32_t periodMs, std::function<void()> function, uint32_t firstDelayMs);
+
+public:
+    Scheduler();
+    void begin();   // call from the task that will call run() (setup/loop)
+
+    JobId addPeriodic(const char* name, uint32_t periodMs, std::function<void()> function, uint32_t firstDelayMs = 0);
+    JobId addEvent(const char* name, std::function<void()> function);
+
+    void notify(JobId id);
+    void IRAM_ATTR notifyFromISR(JobId id);
+
+    void run();     // runs due/notified jobs, then sleeps until there is work
+
+    uint8_t getJobCount() const { return jobCount; }
+    const SchedulerJob& getJob(JobId id) const { return jobs[id]; }
+    uint32_t getWakeups() const { return wakeups; }
+    uint32_t getIdleMs() const { return idleMs; }
+    size_t formatStats(char* buffer, size_t size) const;
+#if SOAK_TEST_MODE
+    void attachSoakMonitor(SoakMonitor* monitor) { soakMonitor = monitor; }
+#endif
+};
+
+#endif // SCHEDULER_H
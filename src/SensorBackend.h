@@ -0,0 +1,56 @@
+#ifndef SENSORBACKEND_H
+#define SENSORBACKEND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+// Sensor backends are policies for BasicSensorManager<Backend> (SensorManager.h).
+// A backend delivers raw readings only; calibration, caching and logging live
+// in the manager, so every backend runs through the same conversion code.
+// The backend is held by value and called directly, so a production build
+// inlines to the same code as before. A backend provides:
+//
+//   void begin();
+//   void beginCycle();                  // start of a sensor cycle (I2C time budget)
+//   void endCycle();
+//   void measureClimate();              // once per cycle, before readTemperature/readHumidity
+//   float readTemperature();            // degrees C, SENSOR_NO_READING if unavailable
+//   float readHumidity();               // %RH, SENSOR_NO_READING if unavailable
+//   int readSoilRaw();                  // ADC counts 0-4095, dry = high
+//   int readWaterSections();            // 0-WATER_LEVEL_MAX_SECTIONS
+//   size_t formatDiagnostics(char* buffer, size_t size) const;
+//   static const char* name();
+//
+// Available backends: HardwareSensorBackend (ENS210 or SHT4x, Grove water level,
+// soil ADC), SimulatedSensorBackend (values set from /simulation), ReplaySensorBackend
+// (plays back recorded samples) and FaultInjectingBackend<Inner> (wraps any of
+// them). SensorManager is the backend selected for this build.
+
+#define SENSOR_NO_READING -999.0f
+
+// One cycle's worth of raw readings, as replayed by ReplaySensorBackend
+struct SensorSample {
+    float temperature;
+    float humidity;
+    uint16_t soilRaw;
+    uint8_t waterSections;
+};
+
+// Grove water level: consecutive sections above WATER_LEVEL_THRESHOLD from the
+// bottom, given the raw bytes of the lower (8) and upper (12) pads. Shared
+// with tools/trace_replay.cpp, which decodes recorded bytes the same way.
+inline uint8_t countWaterSections(const uint8_t* low8, const uint8_t* high12) {
+    uint8_t sections = 0;
+    while (sections < 8 && low8[sections] > WATER_LEVEL_THRESHOLD) {
+        sections++;
+    }
+    if (sections == 8) {
+        while (sections < WATER_LEVEL_MAX_SECTIONS && high12[sections - 8] > WATER_LEVEL_THRESHOLD) {
+            sections++;
+        }
+    }
+    return sections;
+}
+
+#endif // SENSORBACKEND_H
@@ -1,53 +1,116 @@
 #ifndef SENSORMANAGER_H
 #define SENSORMANAGER_H
 
-#include <Arduino.h>
-// --- Active sensor: ENS210 (on-PCB, address 0x43) ---
-// To switch back to SHT40 breakout: comment the ENS210 lines and uncomment the SHT40 lines
-#include <ens210.h>
-// #include <Adafruit_SHT4x.h>  // SHT40 breakout (has its own pull-ups - causes conflict with PCB pull-ups)
-#include <Wire.h>
+#include <stdint.h>
+#include <stddef.h>
 #include "Config.h"
+#include "Calibration.h"
+#include "BlobStore.h"
+#include "SensorBackend.h"
+#include "SensorStats.h"
+
+enum class CalibrationSensor : uint8_t {
+    Soil,
+    Water
+};
+
+// Receives one formatted log line (no newline); Serial in the firmware
+typedef void (*SensorLog)(const char* message);
+
+// Backend-independent part of the sensor manager: calibration curves and
+// their storage, raw -> percent conversion and the last results. Arduino-free:
+// the store and the log sink are injected, so host tools run it unchanged.
+class SensorManagerBase {
+protected:
+    // Raw -> percent curves, loaded from NVS in begin()
+    CalibrationCurve soilCurve;
+    CalibrationCurve waterCurve;
+    BlobStore* settings;
+    SensorLog logSink;
+    int lastSoilPercentage;     // -1 until the first reading
+    int lastSoilRaw;
+    int lastWaterPercentage;
+    SensorStats stats;
+
+    SensorManagerBase();
+    void loadCalibration();
+    int soilPercentage(int raw, float temperature);
+    int waterPercentage(int sections);
+    void log(const char* format, ...) const __attribute__((format(printf, 2, 3)));
 
-class SensorManager {
-private:
-    // --- Active: ENS210 ---
-    ENS210 ens210;
-    bool ens210Found = false;
-    int _last_t_data = 0, _last_t_status = 0;
-    int _last_h_data = 0, _last_h_status = 0;
-    // --- Future: SHT40 (uncomment when new PCB without on-board pull-ups is ready) ---
-    // Adafruit_SHT4x sht4;
-    // bool sht4Found = false;
-
-    // Simulation mode values
-    float simulatedTemperature;
-    float simulatedHumidity;
-    int simulatedSoilPercentage;
-    int simulatedWaterPercentage;
-    
-    // Grove Water Level Sensor I2C helper methods
-    void getHigh12SectionValue(unsigned char* high_data);
-    void getLow8SectionValue(unsigned char* low_data);
-    
 public:
-    SensorManager();
-    void begin();
-    void measureENS210();   // call once per cycle, then use readTemperature/readHumidity
-    
-    float readTemperature();
-    float readHumidity();
-    int readSoilMoisture();
-    int readWaterLevel();
+    // Calibration (stored under "cal_soil" / "cal_water" when a store is attached)
+    void setSettingsStore(BlobStore* store) { settings = store; }
+    void setLog(SensorLog sink) { logSink = sink; }     // silent without one
+    const CalibrationCurve& getCalibration(CalibrationSensor sensor) const;
+    bool setCalibration(CalibrationSensor sensor, const CalibrationData& data);
+    void resetCalibration(CalibrationSensor sensor);
+    static CalibrationData defaultCalibration(CalibrationSensor sensor);
+    static const char* sensorName(CalibrationSensor sensor);
+
+    // Results of the last getSoilPercentage()/getWaterPercentage(), -1 before the first
+    int getLastSoilPercentage() const { return lastSoilPercentage; }
+    int getLastWaterPercentage() const { return lastWaterPercentage; }
+    int getLastSoilRaw() const { return lastSoilRaw; }     // ADC value behind getLastSoilPercentage()
     
-    int getSoilPercentage();
-    int getWaterPercentage();
+    // Rolling statistics and dew point/VPD, fed by updateStats() once per cycle
+    SensorStats& getStats() { return stats; }
+};
+
+// Sensor manager over a backend policy (see SensorBackend.h). The backend is
+// a member and every call is direct, so the production instantiation
+// compiles to plain calls into HardwareSensorBackend.
+template <class Backend>
+class BasicSensorManager : public SensorManagerBase {
+private:
+    Backend sensorBackend;
+
+public:
+    void begin() {
+        loadCalibration();
+        sensorBackend.begin();
+    }
+
+    // A sensor cycle: beginCycle(), measureClimate(), readTemperature/readHumidity,
+    // getWaterPercentage(), endCycle(). I2C work past I2C_CYCLE_BUDGET_MS is skipped.
+    void beginCycle() { sensorBackend.beginCycle(); }
+    void endCycle() { sensorBackend.endCycle(); }
+    void measureClimate() { sensorBackend.measureClimate(); }   // call once per cycle
+
+    float readTemperature() { return sensorBackend.readTemperature(); }
+    float readHumidity() { return sensorBackend.readHumidity(); }
+    int readSoilMoisture() { return sensorBackend.readSoilRaw(); }
+    int readWaterLevel() { return sensorBackend.readWaterSections(); }
+    int readRaw(CalibrationSensor sensor) {
+        return sensor == CalibrationSensor::Soil ? readSoilMoisture() : readWaterLevel();
+    }
+
+    int getSoilPercentage() {
+        int raw = sensorBackend.readSoilRaw();
+        return soilPercentage(raw, sensorBackend.readTemperature());
+    }
+    int getWaterPercentage() { return waterPercentage(sensorBackend.readWaterSections()); }
     
-    // Simulation mode setters
-    void setSimulatedTemperature(float temp);
-    void setSimulatedHumidity(float hum);
-    void setSimulatedSoilPercentage(int soil);
-    void setSimulatedWaterPercentage(int water);
+    // End of a sensor cycle: adds this cycle's climate and last percentages to the stats
+    void updateStats(uint32_t nowMs) {
+        stats.update(nowMs, sensorBackend.readTemperature(), sensorBackend.readHumidity(),
+                     lastSoilPercentage, lastWaterPercentage);
+    }
+
+    size_t formatDiagnostics(char* buffer, size_t size) const { return sensorBackend.formatDiagnostics(buffer, size); }
+    static const char* backendName() { return Backend::name(); }
+    Backend& backend() { return sensorBackend; }
 };
 
+// The backend for this build; host tools instantiate their own
+#if defined(ARDUINO)
+#if SIMULATION_MODE
+#include "SimulatedSensorBackend.h"
+typedef BasicSensorManager<SimulatedSensorBackend> SensorManager;
+#else
+#include "HardwareSensorBackend.h"
+typedef BasicSensorManager<HardwareSensorBackend> SensorManager;
+#endif
+#endif
+
 #endif // SENSORMANAGER_H
@@ -0,0 +1,170 @@
+#include "SensorStats.h"
+#include "SensorBackend.h"
+#include <math.h>
+#include <string.h>
+
+namespace {
+const uint32_t WINDOW_MS[(int)StatsWindow::COUNT] = { 60000UL, 3600000UL, 86400000UL };
+
+// Fixed-point units per channel: 0.01 C, 0.01 %RH, 1 %, 1 %, 0.01 C, 1 Pa
+const int32_t SCALE[(int)StatsChannel::COUNT] = { 100, 100, 1, 1, 100, 1000 };
+
+int16_t toFixed(float value, int32_t scale) {
+    float scaled = value * scale;
+    scaled += scaled < 0 ? -0.5f : 0.5f;
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)scaled;
+}
+
+bool climateValid(float value) { return value > SENSOR_NO_READING + 1.0f; }
+}
+
+SensorStats::SensorStats() : lastDewPoint(SENSOR_NO_READING), lastVpd(SENSOR_NO_READING) {
+    memset(windows, 0, sizeof(windows));
+}
+
+uint32_t SensorStats::windowMs(StatsWindow window) {
+    return WINDOW_MS[(int)window];
+}
+
+const char* SensorStats::channelName(StatsChannel channel) {
+    switch (channel) {
+        case StatsChannel::Temperature: return "temperature";
+        case StatsChannel::Humidity:    return "humidity";
+        case StatsChannel::Soil:        return "soil";
+        case StatsChannel::Water:       return "water";
+        case StatsChannel::DewPoint:    return "dew_point";
+        case StatsChannel::Vpd:         return "vpd";
+        default:                        return "?";
+    }
+}
+
+const char* SensorStats::windowName(StatsWindow window) {
+    switch (window) {
+        case StatsWindow::Minute: return "1m";
+        case StatsWindow::Hour:   return "1h";
+        case StatsWindow::Day:    return "24h";
+        default:                  return "?";
+    }
+}
+
+float SensorStats::dewPoint(float temperature, float humidity) {
+    // Magnus coefficients over water (Sonntag 1990), good from -45 to 60 C
+    const float b = 17.62f;
+    const float c = 243.12f;
+    float rh = humidity < 1.0f ? 1.0f : (humidity > 100.0f ? 100.0f : humidity);
+    float gamma = logf(rh / 100.0f) + b * temperature / (c + temperature);
+    return c * gamma / (b - gamma);
+}
+
+float SensorStats::vpd(float temperature, float humidity) {
+    float saturation = 0.6108f * expf(17.27f * temperature / (temperature + 237.3f));   // kPa
+    float rh = humidity < 0.0f ? 0.0f : (humidity > 100.0f ? 100.0f : humidity);
+    return saturation * (1.0f - rh / 100.0f);
+}
+
+void SensorStats::rescan(Series& series) {
+    bool any = false;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        const Bucket& bucket = series.buckets[i];
+        if (bucket.count == 0) {
+            continue;
+        }
+        if (!any || bucket.min < series.min) series.min = bucket.min;
+        if (!any || bucket.max > series.max) series.max = bucket.max;
+        any = true;
+    }
+}
+
+void SensorStats::advance(Window& window, uint32_t bucketMs, uint32_t nowMs) {
+    uint32_t epoch = nowMs / bucketMs;
+    uint32_t steps = epoch - window.epoch;      // a millis() wrap clears the window
+    if (steps == 0) {
+        return;
+    }
+    if (steps > STATS_BUCKETS) {
+        steps = STATS_BUCKETS;
+    }
+    bool expired[(int)StatsChannel::COUNT] = {};
+    for (uint32_t s = 0; s < steps; s++) {
+        window.head = (window.head + 1) % STATS_BUCKETS;
+        for (int c = 0; c < (int)StatsChannel::COUNT; c++) {
+            Series& series = window.series[c];
+            Bucket& bucket = series.buckets[window.head];
+            if (bucket.count == 0) {
+                continue;
+            }
+            series.sum -= bucket.sum;
+            series.sumSq -= bucket.sumSq;
+            series.count -= bucket.count;
+            memset(&bucket, 0, sizeof(bucket));
+            expired[c] = true;
+        }
+    }
+    window.epoch = epoch;
+    for (int c = 0; c < (int)StatsChannel::COUNT; c++) {
+        if (expired[c]) {
+            rescan(window.series[c]);
+        }
+    }
+}
+
+void SensorStats::add(Window& window, Series& series, int16_t value) {
+    Bucket& bucket = series.buckets[window.head];
+    if (bucket.count == 0 || value < bucket.min) bucket.min = value;
+    if (bucket.count == 0 || value > bucket.max) bucket.max = value;
+    if (bucket.count < UINT16_MAX) {
+        bucket.count++;
+        bucket.sum += value;
+        bucket.sumSq += (int32_t)value * value;
+        series.count++;
+        series.sum += value;
+        series.sumSq += (int32_t)value * value;
+    }
+    if (series.count == 1 || value < series.min) series.min = value;
+    if (series.count == 1 || value > series.max) series.max = value;
+}
+
+void SensorStats::update(uint32_t nowMs, float temperature, float humidity, int soilPercentage, int waterPercentage) {
+    bool haveClimate = climateValid(temperature) && climateValid(humidity);
+    lastDewPoint = haveClimate ? dewPoint(temperature, humidity) : SENSOR_NO_READING;
+    lastVpd = haveClimate ? vpd(temperature, humidity) : SENSOR_NO_READING;
+
+    float values[(int)StatsChannel::COUNT] = {
+        temperature, humidity, (float)soilPercentage, (float)waterPercentage, lastDewPoint, lastVpd
+    };
+    bool valid[(int)StatsChannel::COUNT] = {
+        climateValid(temperature), climateValid(humidity), soilPercentage >= 0, waterPercentage >= 0,
+        haveClimate, haveClimate
+    };
+    for (int w = 0; w < (int)StatsWindow::COUNT; w++) {
+        Window& window = windows[w];
+        advance(window, WINDOW_MS[w] / STATS_BUCKETS, nowMs);
+        for (int c = 0; c < (int)StatsChannel::COUNT; c++) {
+            if (valid[c]) {
+                add(window, window.series[c], toFixed(values[c], SCALE[c]));
+            }
+        }
+    }
+}
+
+StatsSummary SensorStats::get(StatsChannel channel, StatsWindow window, uint32_t nowMs) {
+    Window& w = windows[(int)window];
+    advance(w, WINDOW_MS[(int)window] / STATS_BUCKETS, nowMs);
+    const Series& series = w.series[(int)channel];
+
+    StatsSummary summary = {};
+    summary.count = series.count;
+    if (series.count == 0) {
+        return summary;
+    }
+    float scale = (float)SCALE[(int)channel];
+    double mean = (double)series.sum / series.count;
+    double variance = (double)series.sumSq / series.count - mean * mean;
+    summary.min = series.min / scale;
+    summary.max = series.max / scale;
+    summary.mean = (float)(mean / scale);
+    summary.stddev = variance > 0 ? (float)(sqrt(variance) / scale) : 0.0f;
+    return summary;
+}
@@ -0,0 +1,94 @@
+#ifndef SENSORSTATS_H
+#define SENSORSTATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Config.h"
+
+// Rolling min/max/mean/standard deviation of every channel over 1 min, 1 h
+// and 24 h, updated once per sensor cycle. Arduino-free so it also builds on
+// the host.
+//
+// Each window is a ring of STATS_BUCKETS time buckets holding a count, sum,
+// sum of squares, min and max in fixed point (STATS_SCALE_* units). Running
+// window totals are adjusted as samples arrive and buckets expire, so an
+// update and a query cost the same whatever the window length; min/max are
+// rescanned over the buckets only when one expires. Memory is fixed; the
+// windows slide in steps of 1/STATS_BUCKETS of their length.
+enum class StatsChannel : uint8_t {
+    Temperature,    // degrees C
+    Humidity,       // %RH
+    Soil,           // %
+    Water,          // %
+    DewPoint,       // degrees C, from temperature and humidity
+    Vpd,            // kPa, vapour pressure deficit
+    COUNT
+};
+
+enum class StatsWindow : uint8_t {
+    Minute,
+    Hour,
+    Day,
+    COUNT
+};
+
+struct StatsSummary {
+    uint32_t count;     // samples in the window, the rest is 0 without any
+    float min;
+    float max;
+    float mean;
+    float stddev;       // population
+};
+
+class SensorStats {
+public:
+    SensorStats();
+
+    // Once per sensor cycle; SENSOR_NO_READING / negative percentages are skipped
+    void update(uint32_t nowMs, float temperature, float humidity, int soilPercentage, int waterPercentage);
+    StatsSummary get(StatsChannel channel, StatsWindow window, uint32_t nowMs);
+
+    // Derived values of the last update, SENSOR_NO_READING without a climate reading
+    float getDewPoint() const { return lastDewPoint; }
+    float getVpd() const { return lastVpd; }
+
+    static float dewPoint(float temperature, float humidity);  // Magnus formula
+    static float vpd(float temperature, float humidity);       // Tetens saturation pressure
+    static const char* channelName(StatsChannel channel);
+    static const char* windowName(StatsWindow window);
+    static uint32_t windowMs(StatsWindow window);
+
+private:
+    struct Bucket {
+        int64_t sumSq;
+        int32_t sum;
+        uint16_t count;
+        int16_t min;
+        int16_t max;
+    };
+
+    struct Series {
+        Bucket buckets[STATS_BUCKETS];
+        int64_t sumSq;      // over the live buckets
+        int64_t sum;
+        uint32_t count;
+        int16_t min;
+        int16_t max;
+    };
+
+    struct Window {
+        uint32_t epoch;     // bucket number of the head (time / bucket length)
+        uint8_t head;
+        Series series[(int)StatsChannel::COUNT];
+    };
+
+    Window windows[(int)StatsWindow::COUNT];
+    float lastDewPoint;
+    float lastVpd;
+
+    void advance(Window& window, uint32_t bucketMs, uint32_t nowMs);
+    static void add(Window& window, Series& series, int16_t value);
+    static void rescan(Series& series);
+};
+
+#endif // SENSORSTATS_H
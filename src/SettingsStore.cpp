@@ -0,0 +1,145 @@
+#include "SettingsStore.h"
+#include <cstring>
+
+SettingsStore::SettingsStore() : opened(false), networkCount(0), authenticated(false), writes(0) {
+    memset(networks, 0, sizeof(networks));
+    device = DeviceSettings{50, false, false, true};
+    savedDevice = device;
+}
+
+bool SettingsStore::begin() {
+    opened = prefs.begin(SETTINGS_NAMESPACE, false);
+    if (!opened) {
+        Serial.println("WARNING: NVS settings unavailable, using defaults");
+        return false;
+    }
+
+    if (prefs.getBytesLength("nets") == sizeof(networks)) {
+        prefs.getBytes("nets", networks, sizeof(networks));
+        while (networkCount < WIFI_MAX_NETWORKS && networks[networkCount].ssid[0] != '\0') {
+            networkCount++;
+        }
+    } else if (prefs.isKey("ssid")) {
+        // Single network from older firmware: location unknown until it is joined
+        prefs.getString("ssid", networks[0].ssid, sizeof(networks[0].ssid));
+        prefs.getString("pass", networks[0].password, sizeof(networks[0].password));
+        networkCount = networks[0].ssid[0] != '\0' ? 1 : 0;
+        prefs.putBytes("nets", networks, sizeof(networks));
+        prefs.remove("ssid");
+        prefs.remove("pass");
+        writes++;
+    }
+    authenticated = prefs.getBool("auth", false);
+
+    device.brightness = prefs.getUChar("bright", device.brightness);
+    device.growLed = prefs.getBool("growled", device.growLed);
+    device.growLedBoost = prefs.getBool("boost", device.growLedBoost);
+    device.rgbLeds = prefs.getBool("rgb", device.rgbLeds);
+    savedDevice = device;
+
+    Serial.printf("Settings loaded: %d WiFi network(s) stored, brightness %d%%\n",
+                  (int)networkCount, device.brightness);
+    return true;
+}
+
+const StoredNetwork* SettingsStore::findNetwork(const char* ssid) const {
+    for (uint8_t i = 0; i < networkCount; i++) {
+        if (strcmp(networks[i].ssid, ssid) == 0) {
+            return &networks[i];
+        }
+    }
+    return nullptr;
+}
+
+void SettingsStore::saveNetwork(const char* ssid, const char* password, const uint8_t* bssid, uint8_t channel) {
+    StoredNetwork entry = {};
+    strlcpy(entry.ssid, ssid, sizeof(entry.ssid));
+    strlcpy(entry.password, password, sizeof(entry.password));
+    if (bssid) {
+        memcpy(entry.bssid, bssid, sizeof(entry.bssid));
+        entry.channel = channel;
+    }
+    if (networkCount > 0 && memcmp(&networks[0], &entry, sizeof(entry)) == 0) {
+        return;
+    }
+
+    // Shift the entries in front of its old slot (or all of them) back by one
+    uint8_t slot = networkCount < WIFI_MAX_NETWORKS ? networkCount : WIFI_MAX_NETWORKS - 1;
+    for (uint8_t i = 0; i < networkCount; i++) {
+        if (strcmp(networks[i].ssid, entry.ssid) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == networkCount) {
+        networkCount++;
+    }
+    memmove(&networks[1], &networks[0], slot * sizeof(StoredNetwork));
+    networks[0] = entry;
+    if (!opened) {
+        return;
+    }
+    prefs.putBytes("nets", networks, sizeof(networks));
+    writes++;
+    Serial.printf("WiFi network %s saved (channel %d)\n", entry.ssid, (int)entry.channel);
+}
+
+void SettingsStore::setAuthenticated(bool loggedIn) {
+    if (authenticated == loggedIn) {
+        return;
+    }
+    authenticated = loggedIn;
+    if (!opened) {
+        return;
+    }
+    prefs.putBool("auth", authenticated);
+    writes++;
+}
+
+void SettingsStore::clearCredentials() {
+    memset(networks, 0, sizeof(networks));
+    networkCount = 0;
+    authenticated = false;
+    if (!opened) {
+        return;
+    }
+    prefs.remove("nets");
+    prefs.remove("auth");
+    writes++;
+}
+
+bool SettingsStore::getBlob(const char* key, void* data, size_t size) {
+    if (!opened || prefs.getBytesLength(key) != size) {
+        return false;
+    }
+    return prefs.getBytes(key, data, size) == size;
+}
+
+void SettingsStore::putBlob(const char* key, const void* data, size_t size) {
+    if (!opened) {
+        return;
+    }
+    prefs.putBytes(key, data, size);
+    writes++;
+}
+
+void SettingsStore::removeBlob(const char* key) {
+    if (!opened) {
+        return;
+    }
+    prefs.remove(key);
+    writes++;
+}
+
+bool SettingsStore::save() {
+    if (!opened || memcmp(&device, &savedDevice, sizeof(device)) == 0) {
+        return false;
+    }
+    if (device.brightness != savedDevice.brightness) prefs.putUChar("bright", device.brightness);
+    if (device.growLed != savedDevice.growLed) prefs.putBool("growled", device.growLed);
+    if (device.growLedBoost != savedDevice.growLedBoost) prefs.putBool("boost", device.growLedBoost);
+    if (device.rgbLeds != savedDevice.rgbLeds) prefs.putBool("rgb", device.rgbLeds);
+    savedDevice = device;
+    writes++;
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include "Config.h"
+#include "BlobStore.h"
+
+// Persistent settings in NVS (namespace SETTINGS_NAMESPACE).
+//
+// Up to WIFI_MAX_NETWORKS WiFi networks are kept, most recently used first,
+// each with the BSSID and channel it was last joined on so StationManager can
+// reconnect without a scan. They and the login flag are only written when they
+// change (a new network, a moved access point, a different network in use).
+// Device settings are held in RAM and only written by save() when they
+// changed, which keeps flash wear down while the brightness slider is dragged.
+struct StoredNetwork {
+    char ssid[33];
+    char password[65];
+    uint8_t bssid[6];
+    uint8_t channel;        // 0: location unknown, connect with a full scan
+};
+
+struct DeviceSettings {
+    uint8_t brightness;     // grow LED brightness 0-100
+    bool growLed;
+    bool growLedBoost;
+    bool rgbLeds;
+};
+
+class SettingsStore : public BlobStore {
+private:
+    Preferences prefs;
+    bool opened;
+
+    StoredNetwork networks[WIFI_MAX_NETWORKS];   // unused entries have an empty ssid
+    uint8_t networkCount;
+    bool authenticated;
+    DeviceSettings device;
+    DeviceSettings savedDevice;
+    uint32_t writes;
+
+public:
+    SettingsStore();
+    bool begin();
+
+    // WiFi networks (most recently used first) + login flag
+    bool hasCredentials() const { return networkCount > 0; }
+    uint8_t getNetworkCount() const { return networkCount; }
+    const StoredNetwork& getNetwork(uint8_t index) const { return networks[index]; }
+    const StoredNetwork* findNetwork(const char* ssid) const;
+    // Moves the network to the front (the oldest one drops out when full)
+    void saveNetwork(const char* ssid, const char* password, const uint8_t* bssid, uint8_t channel);
+    bool isAuthenticated() const { return authenticated; }
+    void setAuthenticated(bool loggedIn);
+    void clearCredentials();
+
+    // Device settings
+    const DeviceSettings& getDeviceSettings() const { return device; }
+    void setDeviceSettings(const DeviceSettings& settings) { device = settings; }
+    bool save();   // writes device settings if they changed; true when written
+
+    // Fixed-size records (calibration curves); getBlob fails unless the stored size matches
+    bool getBlob(const char* key, void* data, size_t size) override;
+    void putBlob(const char* key, const void* data, size_t size) override;
+    void removeBlob(const char* key) override;
+
+    uint32_t getWrites() const { return writes; }
+};
+
+#endif // SETTINGSSTORE_H
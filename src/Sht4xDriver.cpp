@@ -0,0 +1,108 @@
+#include "Sht4xDriver.h"
+#include <Wire.h>
+
+#define SHT4X_CMD_MEASURE_HIGH 0xFD     // high repeatability, max 8.3 ms
+#define SHT4X_CMD_READ_SERIAL  0x89
+#define SHT4X_CMD_SOFT_RESET   0x94
+
+namespace {
+// CRC-8, polynomial 0x31, init 0xFF, over each 16-bit word
+uint8_t crc8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// T = -45 + 175 * raw / 65535 C  ->  (T + 273.15) * 64
+uint16_t toEns210Temperature(uint16_t raw) {
+    return (uint16_t)(((uint64_t)1460160 * 65535 + (uint64_t)1120000 * raw + 65535UL * 50) / (65535UL * 100));
+}
+
+// RH = -6 + 125 * raw / 65535 %, clipped to 0..100  ->  RH * 512
+uint16_t toEns210Humidity(uint16_t raw) {
+    int32_t h = (int32_t)(((int64_t)64000 * raw + 32767) / 65535) - 3072;
+    return (uint16_t)(h < 0 ? 0 : (h > 51200 ? 51200 : h));
+}
+}
+
+bool Sht4xDriver::command(uint8_t cmd) {
+    Wire.beginTransmission(SHT4X_I2C_ADDR);
+    Wire.write(cmd);
+    return Wire.endTransmission() == 0;
+}
+
+bool Sht4xDriver::readWords(uint16_t* first, uint16_t* second, bool* crcOk) {
+    uint8_t data[6];
+    if (Wire.requestFrom((uint8_t)SHT4X_I2C_ADDR, (uint8_t)sizeof(data)) != sizeof(data)) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = Wire.read();
+    }
+    *first = (uint16_t)(data[0] << 8 | data[1]);
+    *second = (uint16_t)(data[3] << 8 | data[4]);
+    *crcOk = crc8(data, 2) == data[2] && crc8(data + 3, 2) == data[5];
+    return true;
+}
+
+bool Sht4xDriver::begin() {
+    pending = false;
+    if (!command(SHT4X_CMD_SOFT_RESET)) {
+        return false;
+    }
+    delay(1);
+    // The serial number read is the identification: only an SHT4x answers it
+    // with two CRC-valid words
+    uint16_t high = 0, low = 0;
+    bool crcOk = false;
+    if (!command(SHT4X_CMD_READ_SERIAL)) {
+        return false;
+    }
+    delay(1);
+    if (!readWords(&high, &low, &crcOk) || !crcOk) {
+        return false;
+    }
+    Serial.printf("SHT4x serial %04X%04X\n", high, low);
+    pending = command(SHT4X_CMD_MEASURE_HIGH);
+    triggeredAt = millis();
+    return pending;
+}
+
+ClimateSample Sht4xDriver::fetch() {
+    ClimateSample sample = {};
+    if (!pending) {
+        // The previous trigger failed: start one now, the next fetch reads it
+        pending = command(SHT4X_CMD_MEASURE_HIGH);
+        triggeredAt = millis();
+        sample.tStatus = sample.hStatus = pending ? CLIMATE_STATUS_INVALID : CLIMATE_STATUS_I2CERROR;
+        return sample;
+    }
+    // Only reached when fetched faster than the conversion time
+    unsigned long elapsed = millis() - triggeredAt;
+    if (elapsed < SHT4X_CONVERSION_MS) {
+        delay(SHT4X_CONVERSION_MS - elapsed);
+    }
+
+    uint16_t t = 0, h = 0;
+    bool crcOk = false;
+    bool ok = readWords(&t, &h, &crcOk);
+    pending = command(SHT4X_CMD_MEASURE_HIGH);
+    triggeredAt = millis();
+    if (!ok) {
+        sample.tStatus = sample.hStatus = CLIMATE_STATUS_I2CERROR;
+        return sample;
+    }
+    if (!crcOk) {
+        sample.tStatus = sample.hStatus = CLIMATE_STATUS_CRCERROR;
+        return sample;
+    }
+    sample.tData = toEns210Temperature(t);
+    sample.hData = toEns210Humidity(h);
+    sample.tStatus = sample.hStatus = CLIMATE_STATUS_OK;
+    return sample;
+}
@@ -0,0 +1,30 @@
+#ifndef SHT4XDRIVER_H
+#define SHT4XDRIVER_H
+
+#include "ClimateDriver.h"
+
+// Sensirion SHT4x (SHT40/41/45 breakout, SHT4X_I2C_ADDR), driven directly over
+// Wire. The sensor has no continuous mode, so every fetch() reads the
+// high-repeatability conversion started by the previous one (~9 ms, long done
+// a sensor cycle later) and starts the next: the bus time per fetch is one
+// 6-byte read plus a 1-byte command.
+//
+// Hardware note: the SHT40 breakout carries its own I2C pull-ups, which
+// conflict with the pull-ups on the current PCB. Fit it only on the new PCB
+// (or with the breakout's pull-ups removed); the probe binds it either way.
+class Sht4xDriver : public ClimateDriver {
+private:
+    unsigned long triggeredAt = 0;  // millis() of the pending conversion
+    bool pending = false;
+
+    bool command(uint8_t cmd);
+    bool readWords(uint16_t* first, uint16_t* second, bool* crcOk);
+
+public:
+    const char* name() const override { return "sht4x"; }
+    uint8_t address() const override { return SHT4X_I2C_ADDR; }
+    bool begin() override;
+    ClimateSample fetch() override;
+};
+
+#endif // SHT4XDRIVER_H
@@ -0,0 +1,47 @@
+#ifndef SIMULATEDSENSORBACKEND_H
+#define SIMULATEDSENSORBACKEND_H
+
+#include <stdio.h>
+#include "Config.h"
+#include "SensorBackend.h"
+
+// Values set by hand (the dashboard's simulation panel, POST /simulation).
+// Soil and water are set as percentages and delivered as the raw values the
+// default calibration maps back to them, so they pass through the same
+// conversion as real readings. Water resolves to whole sections (5% steps).
+class SimulatedSensorBackend {
+private:
+    float temperature = 25.0f;
+    float humidity = 50.0f;
+    int soilPercentage = 30;
+    int waterPercentage = 70;
+
+    static int clampInt(int value, int low, int high) { return value < low ? low : (value > high ? high : value); }
+    static float clampFloat(float value, float low, float high) { return value < low ? low : (value > high ? high : value); }
+
+public:
+    void begin() {}
+    void beginCycle() {}
+    void endCycle() {}
+    void measureClimate() {}
+    float readTemperature() { return temperature; }
+    float readHumidity() { return humidity; }
+    int readSoilRaw() {
+        // Inverse of the default soil curve, rounded to the nearest count
+        return SOIL_DRY_VALUE - ((SOIL_DRY_VALUE - SOIL_WET_VALUE) * soilPercentage + 50) / 100;
+    }
+    int readWaterSections() { return (waterPercentage * WATER_LEVEL_MAX_SECTIONS + 50) / 100; }
+    size_t formatDiagnostics(char* buffer, size_t size) const {
+        int n = snprintf(buffer, size, "backend: simulated\ntemperature: %.1f\nhumidity: %.1f\nsoil_pct: %d\nwater_pct: %d\n",
+                         temperature, humidity, soilPercentage, waterPercentage);
+        return n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+    }
+    static const char* name() { return "simulated"; }
+
+    void setTemperature(float value) { temperature = clampFloat(value, -40.0f, 80.0f); }
+    void setHumidity(float value) { humidity = clampFloat(value, 0.0f, 100.0f); }
+    void setSoilPercentage(int value) { soilPercentage = clampInt(value, 0, 100); }
+    void setWaterPercentage(int value) { waterPercentage = clampInt(value, 0, 100); }
+};
+
+#endif // SIMULATEDSENSORBACKEND_H
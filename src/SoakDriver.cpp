@@ -0,0 +1,156 @@
+#include "SoakDriver.h"
+#include "HttpAdmission.h"
+
+#define SOAK_MINUTES_PER_DAY     1440
+#define SOAK_REQUEST_TIMEOUT_MS  2000
+
+SoakDriver::SoakDriver(SoakMonitor* soakMonitor, Scheduler* jobScheduler,
+                       DeviceController* deviceController, AuthManager* authManager)
+    : monitor(soakMonitor), scheduler(jobScheduler), devices(deviceController), auth(authManager),
+      sensorJob(SCHEDULER_NO_JOB), buttonJob(SCHEDULER_NO_JOB),
+      requestActive(false), requestStart(0), responseLength(0),
+      simulatedMinute(0), finished(false), requestsSent(0), responsesOk(0), responsesFailed(0),
+      buttonPresses(0), reconnects(0) {
+    response[0] = '\0';
+}
+
+void SoakDriver::begin(JobId sensorCycleJob, JobId buttonEventJob) {
+    sensorJob = sensorCycleJob;
+    buttonJob = buttonEventJob;
+
+    // Protected routes are part of the traffic mix
+    auth->setAuthenticated(true);
+
+    Serial.printf("SOAK TEST: %d simulated days, 1 simulated minute every %d ms (~%lu min real time)\n",
+                  SOAK_DAYS, SOAK_MINUTE_MS,
+                  (unsigned long)((uint32_t)SOAK_DAYS * SOAK_MINUTES_PER_DAY * SOAK_MINUTE_MS / 60000UL));
+}
+
+const char* SoakDriver::pickRequest(char* path, size_t size) const {
+    uint32_t m = simulatedMinute;
+    if (m % 15 == 0) {
+        snprintf(path, size, "/toggle/%lu", (unsigned long)((m / 15) % 4 + 1));
+    } else if (m % 15 == 7) {
+        snprintf(path, size, "/brightness/%lu", (unsigned long)((m * 7) % 101));
+    } else if (m % 60 == 29) {
+        return "/debug/heap";
+    } else if (m % 30 == 11) {
+        return "/connect-status";
+    } else if (m % 5 == 2) {
+        return "/generate_204";
+    } else if (m % 5 == 3) {
+        return "/scan-networks";
+    } else {
+        return "/dashboard";
+    }
+    return path;
+}
+
+void SoakDriver::startRequest(const char* path) {
+    // Over loopback, not the softAP address: only loopback is exempt from
+    // admission, and the soak must not be shed by its own traffic
+    if (!client.connect(IPAddress((uint32_t)HTTP_LOOPBACK_IP), 80, 1000)) {
+        responsesFailed++;
+        return;
+    }
+    char request[96];
+    int length = snprintf(request, sizeof(request),
+                          "GET %s HTTP/1.1\r\nHost: 192.168.4.1\r\nConnection: close\r\n\r\n", path);
+    client.write((const uint8_t*)request, length);
+    requestActive = true;
+    requestStart = millis();
+    responseLength = 0;
+    requestsSent++;
+}
+
+void SoakDriver::pollRequest() {
+    if (!requestActive) {
+        return;
+    }
+
+    // Keep the status line, discard the body
+    uint8_t scratch[256];
+    while (client.available() > 0) {
+        int n = client.read(scratch, sizeof(scratch));
+        if (n <= 0) {
+            break;
+        }
+        for (int i = 0; i < n && responseLength < sizeof(response) - 1; i++) {
+            response[responseLength++] = scratch[i];
+        }
+    }
+    response[responseLength] = '\0';
+
+    if (!client.connected() && client.available() <= 0) {
+        // "HTTP/1.1 200" - any 2xx/3xx counts as served
+        finishRequest(responseLength >= 12 && (response[9] == '2' || response[9] == '3'));
+    } else if (millis() - requestStart > SOAK_REQUEST_TIMEOUT_MS) {
+        finishRequest(false);
+    }
+}
+
+void SoakDriver::finishRequest(bool ok) {
+    client.stop();
+    requestActive = false;
+    if (ok) {
+        responsesOk++;
+    } else {
+        responsesFailed++;
+    }
+}
+
+void SoakDriver::step() {
+    if (finished) {
+        return;
+    }
+    pollRequest();
+    simulatedMinute++;
+
+    scheduler->notify(sensorJob);
+
+    if (simulatedMinute % 60 == 0) {
+        // The pin cannot be pulled from software: toggle like checkButton() would
+        // and still wake the button job so its event path runs
+        devices->togglePump();
+        scheduler->notify(buttonJob);
+        buttonPresses++;
+    }
+
+    if (simulatedMinute % 360 == 0) {
+        // SOAK_WIFI_SSID normally does not exist: exercises the connect/fail/timeout path
+        auth->startProvisioning(SOAK_WIFI_SSID, SOAK_WIFI_PASSWORD);
+        auth->requestNetworkScan(true);
+        reconnects++;
+    }
+
+    if (!requestActive) {
+        char path[24];
+        startRequest(pickRequest(path, sizeof(path)));
+    }
+
+    if (simulatedMinute % SOAK_MINUTES_PER_DAY == 0) {
+        uint32_t day = simulatedMinute / SOAK_MINUTES_PER_DAY;
+        monitor->checkpoint(day);
+        if (day >= SOAK_DAYS || monitor->hasFailed()) {
+            finished = true;
+            Serial.printf("=== SOAK %s after %lu simulated days: %lu requests (%lu ok, %lu failed) ===\n",
+                          monitor->hasFailed() ? "FAILED" : "PASSED", (unsigned long)day,
+                          (unsigned long)requestsSent, (unsigned long)responsesOk,
+                          (unsigned long)responsesFailed);
+        }
+    }
+}
+
+size_t SoakDriver::formatStatus(char* buffer, size_t size) const {
+    int n = snprintf(buffer, size,
+                     "\nsimulated_minutes: %lu\nsimulated_days: %lu\nfinished: %s\n"
+                     "requests: %lu\nresponses_ok: %lu\nresponses_failed: %lu\n"
+                     "button_presses: %lu\nreconnects: %lu\n",
+                     (unsigned long)simulatedMinute, (unsigned long)(simulatedMinute / SOAK_MINUTES_PER_DAY),
+                     finished ? "yes" : "no", (unsigned long)requestsSent, (unsigned long)responsesOk,
+                     (unsigned long)responsesFailed, (unsigned long)buttonPresses, (unsigned long)reconnects);
+    if (n < 0) {
+        return 0;
+    }
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
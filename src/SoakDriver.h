@@ -0,0 +1,60 @@
+#ifndef SOAKDRIVER_H
+#define SOAKDRIVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include "Config.h"
+#include "Scheduler.h"
+#include "SoakMonitor.h"
+#include "DeviceController.h"
+#include "AuthManager.h"
+
+// Compressed-time traffic generator for SOAK_TEST_MODE builds.
+//
+// step() runs as a scheduler job every SOAK_MINUTE_MS and plays one simulated
+// minute: a sensor cycle, one HTTP request to the box's own web server over
+// loopback (dashboard, toggles, brightness, captive probes, status polls),
+// an hourly button press and a reconnect + rescan every six hours. After each
+// simulated day SoakMonitor::checkpoint() checks for heap growth; the run
+// stops after SOAK_DAYS days or on the first failure.
+class SoakDriver {
+private:
+    SoakMonitor* monitor;
+    Scheduler* scheduler;
+    DeviceController* devices;
+    AuthManager* auth;
+    JobId sensorJob;
+    JobId buttonJob;
+
+    WiFiClient client;
+    bool requestActive;
+    unsigned long requestStart;
+    char response[16];          // start of the status line
+    uint8_t responseLength;
+
+    uint32_t simulatedMinute;
+    bool finished;
+    uint32_t requestsSent;
+    uint32_t responsesOk;
+    uint32_t responsesFailed;
+    uint32_t buttonPresses;
+    uint32_t reconnects;
+
+    const char* pickRequest(char* path, size_t size) const;
+    void startRequest(const char* path);
+    void pollRequest();
+    void finishRequest(bool ok);
+
+public:
+    SoakDriver(SoakMonitor* soakMonitor, Scheduler* jobScheduler,
+               DeviceController* deviceController, AuthManager* authManager);
+    void begin(JobId sensorCycleJob, JobId buttonEventJob);
+    void step();
+
+    bool isFinished() const { return finished; }
+    uint32_t getSimulatedMinute() const { return simulatedMinute; }
+    size_t formatStatus(char* buffer, size_t size) const;
+};
+
+#endif // SOAKDRIVER_H
@@ -0,0 +1,123 @@
+#include "SoakMonitor.h"
+#include <esp_heap_caps.h>
+
+SoakMonitor::SoakMonitor()
+    : subsystemCount(0), baseline(), lastCheckpoint(), minLargestBlock(0), checkpoints(0),
+      heapGrowthStreak(0), failed(false) {
+    failReason[0] = '\0';
+}
+
+void SoakMonitor::begin() {
+    baseline = sample();
+    lastCheckpoint = baseline;
+    minLargestBlock = baseline.largestBlock;
+    Serial.printf("Soak monitor: baseline free %lu, largest block %lu, %lu blocks\n",
+                  (unsigned long)baseline.freeBytes, (unsigned long)baseline.largestBlock,
+                  (unsigned long)baseline.allocatedBlocks);
+}
+
+SoakHeapSample SoakMonitor::sample() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    SoakHeapSample s;
+    s.freeBytes = info.total_free_bytes;
+    s.largestBlock = info.largest_free_block;
+    s.allocatedBlocks = info.allocated_blocks;
+    return s;
+}
+
+SoakSubsystem* SoakMonitor::find(const char* name) {
+    // Names are string literals, so pointer identity is enough
+    for (uint8_t i = 0; i < subsystemCount; i++) {
+        if (subsystems[i].name == name) {
+            return &subsystems[i];
+        }
+    }
+    if (subsystemCount == SOAK_MAX_SUBSYSTEMS) {
+        return nullptr;
+    }
+    SoakSubsystem* s = &subsystems[subsystemCount++];
+    *s = SoakSubsystem();
+    s->name = name;
+    return s;
+}
+
+void SoakMonitor::record(const char* subsystem, const SoakHeapSample& before) {
+    SoakHeapSample after = sample();
+    SoakSubsystem* s = find(subsystem);
+    if (!s) {
+        return;
+    }
+    int32_t bytes = (int32_t)before.freeBytes - (int32_t)after.freeBytes;
+    s->calls++;
+    s->retainedBytes += bytes;
+    s->retainedBlocks += (int32_t)after.allocatedBlocks - (int32_t)before.allocatedBlocks;
+    if (s->retainedBytes > s->peakRetainedBytes) {
+        s->peakRetainedBytes = s->retainedBytes;
+    }
+    if (bytes > 0 && (uint32_t)bytes > s->maxCallBytes) {
+        s->maxCallBytes = bytes;
+    }
+    if (after.largestBlock < minLargestBlock) {
+        minLargestBlock = after.largestBlock;
+    }
+}
+
+void SoakMonitor::fail(const char* subsystem, int32_t growth) {
+    if (failed) {
+        return;
+    }
+    failed = true;
+    snprintf(failReason, sizeof(failReason), "%s grew %ld bytes over %d checkpoints",
+             subsystem, (long)growth, SOAK_GROWTH_CHECKPOINTS);
+    Serial.printf("!!! SOAK FAIL: %s !!!\n", failReason);
+}
+
+void SoakMonitor::checkpoint(uint32_t simulatedDay) {
+    checkpoints++;
+
+    for (uint8_t i = 0; i < subsystemCount; i++) {
+        SoakSubsystem& s = subsystems[i];
+        int32_t growth = s.retainedBytes - s.checkpointBytes;
+        s.growthStreak = growth > SOAK_GROWTH_MIN_BYTES ? s.growthStreak + 1 : 0;
+        s.checkpointBytes = s.retainedBytes;
+        if (s.growthStreak >= SOAK_GROWTH_CHECKPOINTS) {
+            fail(s.name, growth * SOAK_GROWTH_CHECKPOINTS);
+        }
+    }
+
+    // Whole-heap trend catches leaks in code that is not instrumented
+    SoakHeapSample now = sample();
+    int32_t heapGrowth = (int32_t)lastCheckpoint.freeBytes - (int32_t)now.freeBytes;
+    heapGrowthStreak = heapGrowth > SOAK_GROWTH_MIN_BYTES ? heapGrowthStreak + 1 : 0;
+    if (heapGrowthStreak >= SOAK_GROWTH_CHECKPOINTS) {
+        fail("heap", (int32_t)baseline.freeBytes - (int32_t)now.freeBytes);
+    }
+    lastCheckpoint = now;
+
+    Serial.printf("=== Soak day %lu: free %lu (%+ld vs start), largest %lu, blocks %lu, %s ===\n",
+                  (unsigned long)simulatedDay, (unsigned long)now.freeBytes,
+                  (long)now.freeBytes - (long)baseline.freeBytes, (unsigned long)now.largestBlock,
+                  (unsigned long)now.allocatedBlocks, failed ? "FAIL" : "ok");
+}
+
+size_t SoakMonitor::formatReport(char* buffer, size_t size) const {
+    SoakHeapSample now = sample();
+    size_t used = snprintf(buffer, size,
+                           "status: %s\nreason: %s\ncheckpoints: %lu\n"
+                           "free_heap: %lu\nfree_heap_start: %lu\nlargest_block: %lu\nlargest_block_min: %lu\n"
+                           "allocated_blocks: %lu\nallocated_blocks_start: %lu\n\n"
+                           "%-12s %10s %10s %8s %10s %10s %6s\n",
+                           failed ? "FAIL" : "ok", failReason, (unsigned long)checkpoints,
+                           (unsigned long)now.freeBytes, (unsigned long)baseline.freeBytes,
+                           (unsigned long)now.largestBlock, (unsigned long)minLargestBlock,
+                           (unsigned long)now.allocatedBlocks, (unsigned long)baseline.allocatedBlocks,
+                           "subsystem", "calls", "retained", "blocks", "peak", "max_call", "streak");
+    for (uint8_t i = 0; i < subsystemCount && used < size; i++) {
+        const SoakSubsystem& s = subsystems[i];
+        used += snprintf(buffer + used, size - used, "%-12s %10lu %10ld %8ld %10ld %10lu %6u\n",
+                         s.name, (unsigned long)s.calls, (long)s.retainedBytes, (long)s.retainedBlocks,
+                         (long)s.peakRetainedBytes, (unsigned long)s.maxCallBytes, (unsigned)s.growthStreak);
+    }
+    return used < size ? used : size - 1;
+}
@@ -0,0 +1,83 @@
+#ifndef SOAKMONITOR_H
+#define SOAKMONITOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Per-subsystem heap accounting for SOAK_TEST_MODE builds.
+//
+// Every instrumented call (a scheduler job, a soak traffic step) is bracketed
+// by a Scope that samples the 8-bit heap before and after. The difference is
+// charged to the subsystem as retained bytes/blocks. IDF 4.4 has no malloc
+// hook, so these are net counts, and allocations made concurrently by other
+// tasks (WiFi, lwIP, DNS) show up as noise; growth is therefore judged on
+// checkpoint trends, not single calls.
+//
+// checkpoint() is called once per simulated day. A subsystem (or the heap as
+// a whole) that grows by more than SOAK_GROWTH_MIN_BYTES on
+// SOAK_GROWTH_CHECKPOINTS consecutive checkpoints fails the soak.
+
+#define SOAK_MAX_SUBSYSTEMS     24
+#define SOAK_GROWTH_CHECKPOINTS 5
+#define SOAK_GROWTH_MIN_BYTES   64
+
+struct SoakSubsystem {
+    const char* name;
+    uint32_t calls;
+    int32_t retainedBytes;       // net heap taken since the soak started
+    int32_t retainedBlocks;
+    int32_t peakRetainedBytes;
+    uint32_t maxCallBytes;       // largest single-call heap delta
+    int32_t checkpointBytes;     // retainedBytes at the previous checkpoint
+    uint8_t growthStreak;        // consecutive checkpoints that grew
+};
+
+struct SoakHeapSample {
+    uint32_t freeBytes;
+    uint32_t largestBlock;
+    uint32_t allocatedBlocks;
+};
+
+class SoakMonitor {
+private:
+    SoakSubsystem subsystems[SOAK_MAX_SUBSYSTEMS];
+    uint8_t subsystemCount;
+
+    SoakHeapSample baseline;
+    SoakHeapSample lastCheckpoint;
+    uint32_t minLargestBlock;
+    uint32_t checkpoints;
+    uint8_t heapGrowthStreak;
+    bool failed;
+    char failReason[64];
+
+    SoakSubsystem* find(const char* name);
+    void fail(const char* subsystem, int32_t growth);
+
+public:
+    SoakMonitor();
+    void begin();
+
+    static SoakHeapSample sample();
+    void record(const char* subsystem, const SoakHeapSample& before);
+    void checkpoint(uint32_t simulatedDay);
+
+    bool hasFailed() const { return failed; }
+    const char* getFailReason() const { return failReason; }
+    uint32_t getCheckpoints() const { return checkpoints; }
+    size_t formatReport(char* buffer, size_t size) const;
+
+    // Charges the heap delta of its lifetime to one subsystem
+    class Scope {
+    public:
+        Scope(SoakMonitor* monitor, const char* subsystem)
+            : monitor(monitor), subsystem(subsystem), before(monitor ? sample() : SoakHeapSample()) {}
+        ~Scope() { if (monitor) monitor->record(subsystem, before); }
+    private:
+        SoakMonitor* monitor;
+        const char* subsystem;
+        SoakHeapSample before;
+    };
+};
+
+#endif // SOAKMONITOR_H
@@ -0,0 +1,318 @@
+#include "StationManager.h"
+#include <cstring>
+
+StationManager::StationManager()
+    : settings(nullptr), eventsRegistered(false), staGotIp(false), staDisconnected(false), lastDisconnectReason(0),
+      state(StationState::Idle), kind(JoinKind::Full), roundStep(0), attemptStart(0), retryAt(0),
+      backoffMs(WIFI_BACKOFF_MIN_MS), outage(false), outageStart(0), linkUpPending(false),
+      provisioningState(ProvisioningState::Idle), provisioning(false), provisioningStart(0), provisioningDuration(0),
+      stats() {
+    ssid[0] = '\0';
+    provisioningSsid[0] = '\0';
+    provisioningPassword[0] = '\0';
+}
+
+const char* StationManager::stateName(StationState state) {
+    switch (state) {
+        case StationState::Connecting: return "connecting";
+        case StationState::Connected:  return "connected";
+        case StationState::Backoff:    return "backoff";
+        default:                       return "idle";
+    }
+}
+
+const char* StationManager::kindName(JoinKind kind) {
+    return kind == JoinKind::Targeted ? "targeted" : "full";
+}
+
+void StationManager::registerEvents() {
+    if (eventsRegistered) {
+        return;
+    }
+    eventsRegistered = true;
+
+    // Runs on the WiFi event task - only set flags here
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+        switch (event) {
+            case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+                staGotIp = true;
+                break;
+            case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+                lastDisconnectReason = info.wifi_sta_disconnected.reason;
+                staDisconnected = true;
+                break;
+            case ARDUINO_EVENT_WIFI_SCAN_DONE:
+                break;
+            default:
+                return;
+        }
+        if (eventCallback) {
+            eventCallback();
+        }
+    });
+}
+
+void StationManager::setEventCallback(std::function<void()> callback) {
+    eventCallback = callback;
+    registerEvents();
+}
+
+bool StationManager::begin() {
+    registerEvents();
+    // Joins are driven from here: no driver retries behind our back and no
+    // flash write of the STA config on every begin()
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    if (!settings || !settings->hasCredentials()) {
+        return false;
+    }
+    Serial.printf("WiFi: %d stored network(s), joining\n", (int)settings->getNetworkCount());
+    outage = true;
+    outageStart = millis();
+    startRound();
+    return true;
+}
+
+void StationManager::join(const char* networkSsid, const char* password, const uint8_t* bssid, uint8_t channel,
+                          JoinKind joinKind) {
+    strlcpy(ssid, networkSsid, sizeof(ssid));
+    kind = joinKind;
+    stats.attempts[(int)kind]++;
+    staGotIp = false;
+    staDisconnected = false;
+    attemptStart = millis();
+    state = StationState::Connecting;
+
+    // Keep the setup AP up while the STA side associates
+    WiFi.mode(WIFI_AP_STA);
+    WiFi.begin(ssid, password, channel, bssid);
+    if (bssid) {
+        Serial.printf("WiFi: targeted join of %s (%02X:%02X:%02X:%02X:%02X:%02X, channel %d)\n", ssid,
+                      bssid[0], bssid[1], bssid[2], bssid[3], bssid[4], bssid[5], (int)channel);
+    } else {
+        Serial.printf("WiFi: full join of %s\n", ssid);
+    }
+}
+
+void StationManager::startRound() {
+    if (!settings || !settings->hasCredentials()) {
+        state = StationState::Idle;
+        return;
+    }
+    stats.rounds++;
+    roundStep = 0;
+    nextAttempt();
+}
+
+void StationManager::nextAttempt() {
+    uint8_t count = settings ? settings->getNetworkCount() : 0;
+    while (roundStep < 2 * count) {
+        uint8_t step = roundStep++;
+        const StoredNetwork& network = settings->getNetwork(step % count);
+        if (step >= count) {
+            join(network.ssid, network.password, nullptr, 0, JoinKind::Full);
+            return;
+        }
+        if (network.channel != 0) {
+            join(network.ssid, network.password, network.bssid, network.channel, JoinKind::Targeted);
+            return;
+        }
+    }
+
+    // Nothing answered: wait, then start over
+    stats.failedRounds++;
+    state = StationState::Backoff;
+    retryAt = millis() + backoffMs;
+    Serial.printf("WiFi: no stored network joined, next round in %lu s\n", (unsigned long)(backoffMs / 1000));
+    backoffMs = backoffMs >= WIFI_BACKOFF_MAX_MS / 2 ? WIFI_BACKOFF_MAX_MS : backoffMs * 2;
+}
+
+void StationManager::connect(const char* networkSsid, const char* password) {
+    registerEvents();
+    strlcpy(provisioningSsid, networkSsid, sizeof(provisioningSsid));
+    strlcpy(provisioningPassword, password, sizeof(provisioningPassword));
+    provisioningStart = millis();
+    provisioningDuration = 0;
+    provisioningState = ProvisioningState::Connecting;
+    lastDisconnectReason = 0;
+
+    if (state == StationState::Connected && strcmp(ssid, networkSsid) == 0) {
+        Serial.println("Already connected to the requested network!");
+        if (settings) {
+            settings->saveNetwork(provisioningSsid, provisioningPassword, WiFi.BSSID(), (uint8_t)WiFi.channel());
+        }
+        finishProvisioning(ProvisioningState::Connected);
+        linkUpPending = true;
+        return;
+    }
+    // Leaving a working network on request is not an outage
+    if (state == StationState::Connected) {
+        WiFi.disconnect();
+    }
+    outage = false;
+    provisioning = true;
+    join(provisioningSsid, provisioningPassword, nullptr, 0, JoinKind::Full);
+}
+
+bool StationManager::update() {
+    if (staGotIp) {
+        staGotIp = false;
+        if (state == StationState::Connecting) {
+            onConnected();
+        }
+    }
+
+    if (staDisconnected) {
+        staDisconnected = false;
+        uint8_t reason = lastDisconnectReason;
+        if (state == StationState::Connected) {
+            stats.linkLosses++;
+            outage = true;
+            outageStart = millis();
+            Serial.printf("WiFi: lost %s (reason %d), reconnecting\n", ssid, reason);
+            startRound();   // the network just lost is first in the list: targeted join
+        } else if (state == StationState::Connecting && reason != WIFI_REASON_ASSOC_LEAVE) {
+            // ASSOC_LEAVE is our own disconnect() of the previous link or attempt
+            onAttemptFailed(reason);
+        }
+    }
+
+    if (state == StationState::Connecting) {
+        unsigned long timeout = kind == JoinKind::Targeted ? WIFI_TARGETED_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS;
+        if (millis() - attemptStart >= timeout) {
+            WiFi.disconnect();
+            onAttemptFailed(0);
+        }
+    } else if (state == StationState::Backoff && (long)(millis() - retryAt) >= 0) {
+        startRound();
+    }
+
+    bool linkUp = linkUpPending;
+    linkUpPending = false;
+    return linkUp;
+}
+
+void StationManager::onConnected() {
+    state = StationState::Connected;
+    backoffMs = WIFI_BACKOFF_MIN_MS;
+    stats.joins[(int)kind]++;
+    linkUpPending = true;
+
+    // Remember where the network was found; only written when it moved
+    uint8_t* bssid = WiFi.BSSID();
+    uint8_t channel = (uint8_t)WiFi.channel();
+    if (provisioning) {
+        provisioning = false;
+        if (settings) {
+            settings->saveNetwork(provisioningSsid, provisioningPassword, bssid, channel);
+        }
+        finishProvisioning(ProvisioningState::Connected);
+    } else if (settings && settings->findNetwork(ssid)) {
+        StoredNetwork known = *settings->findNetwork(ssid);
+        settings->saveNetwork(known.ssid, known.password, bssid, channel);
+    }
+
+    unsigned long elapsed = millis() - attemptStart;
+    if (outage) {
+        outage = false;
+        uint32_t recoveryMs = millis() - outageStart;
+        stats.recoveries++;
+        stats.lastRecoveryMs = recoveryMs;
+        if (recoveryMs > stats.maxRecoveryMs) {
+            stats.maxRecoveryMs = recoveryMs;
+        }
+        uint8_t bucket = 0;
+        for (uint32_t limit = 250; bucket < WIFI_LATENCY_BUCKETS - 1 && recoveryMs >= limit; limit *= 2) {
+            bucket++;
+        }
+        stats.latency[(int)kind][bucket]++;
+    }
+    Serial.printf("WiFi: joined %s (%s, channel %d) in %lu ms\n", ssid, kindName(kind), (int)channel, elapsed);
+    Serial.print("IP Address: ");
+    Serial.println(WiFi.localIP());
+}
+
+void StationManager::onAttemptFailed(uint8_t reason) {
+    if (reason) {
+        Serial.printf("WiFi: %s join of %s failed (reason %d)\n", kindName(kind), ssid, reason);
+    } else {
+        Serial.printf("WiFi: %s join of %s timed out\n", kindName(kind), ssid);
+    }
+    if (provisioning) {
+        // A new network is tried once; then back to the stored ones
+        provisioning = false;
+        finishProvisioning(ProvisioningState::Failed);
+        startRound();
+        return;
+    }
+    nextAttempt();
+}
+
+void StationManager::finishProvisioning(ProvisioningState result) {
+    provisioningState = result;
+    provisioningDuration = millis() - provisioningStart;
+    if (result == ProvisioningState::Connected) {
+        Serial.printf("Connected successfully to %s in %lu ms\n", provisioningSsid, provisioningDuration);
+    } else {
+        Serial.printf("Connection to %s failed after %lu ms (reason %d)\n",
+                      provisioningSsid, provisioningDuration, lastDisconnectReason);
+    }
+    memset(provisioningPassword, 0, sizeof(provisioningPassword));
+}
+
+unsigned long StationManager::getProvisioningElapsed() const {
+    if (provisioningState == ProvisioningState::Connecting) {
+        return millis() - provisioningStart;
+    }
+    return provisioningDuration;
+}
+
+size_t StationManager::formatReport(char* buffer, size_t size) const {
+    unsigned long now = millis();
+    unsigned long retryIn = state == StationState::Backoff && (long)(retryAt - now) > 0 ? retryAt - now : 0;
+    int n = snprintf(buffer, size,
+                     "state: %s\nssid: %s\njoin: %s\nlast_disconnect_reason: %u\nretry_in_ms: %lu\nbackoff_ms: %lu\n\n"
+                     "rounds: %lu\nfailed_rounds: %lu\nlink_losses: %lu\nrecoveries: %lu\n"
+                     "last_recovery_ms: %lu\nmax_recovery_ms: %lu\n\n%-9s %8s %6s",
+                     stateName(state), ssid, kindName(kind), (unsigned)lastDisconnectReason, retryIn,
+                     (unsigned long)backoffMs, (unsigned long)stats.rounds, (unsigned long)stats.failedRounds,
+                     (unsigned long)stats.linkLosses, (unsigned long)stats.recoveries,
+                     (unsigned long)stats.lastRecoveryMs, (unsigned long)stats.maxRecoveryMs,
+                     "join", "attempts", "joins");
+    size_t used = n < 0 ? 0 : (size_t)n;
+
+    // Recovery latency histogram: bucket i holds outages under 250 ms << i
+    for (int b = 0; b < WIFI_LATENCY_BUCKETS && used < size; b++) {
+        char label[12];
+        bool last = b == WIFI_LATENCY_BUCKETS - 1;
+        snprintf(label, sizeof(label), "%s%lu", last ? ">=" : "<", 250UL << (last ? b - 1 : b));
+        n = snprintf(buffer + used, size - used, " %7s", label);
+        used += n < 0 ? 0 : (size_t)n;
+    }
+    for (int k = 0; k < (int)JoinKind::COUNT && used < size; k++) {
+        n = snprintf(buffer + used, size - used, "\n%-9s %8lu %6lu", kindName((JoinKind)k),
+                     (unsigned long)stats.attempts[k], (unsigned long)stats.joins[k]);
+        used += n < 0 ? 0 : (size_t)n;
+        for (int b = 0; b < WIFI_LATENCY_BUCKETS && used < size; b++) {
+            n = snprintf(buffer + used, size - used, " %7lu", (unsigned long)stats.latency[k][b]);
+            used += n < 0 ? 0 : (size_t)n;
+        }
+    }
+
+    if (used < size) {
+        n = snprintf(buffer + used, size - used, "\n\nstored networks (most recent first):\n");
+        used += n < 0 ? 0 : (size_t)n;
+    }
+    for (uint8_t i = 0; settings && i < settings->getNetworkCount() && used < size; i++) {
+        const StoredNetwork& network = settings->getNetwork(i);
+        if (network.channel) {
+            n = snprintf(buffer + used, size - used, "%-32s %02X:%02X:%02X:%02X:%02X:%02X ch %d\n", network.ssid,
+                         network.bssid[0], network.bssid[1], network.bssid[2], network.bssid[3], network.bssid[4],
+                         network.bssid[5], (int)network.channel);
+        } else {
+            n = snprintf(buffer + used, size - used, "%-32s (not joined yet)\n", network.ssid);
+        }
+        used += n < 0 ? 0 : (size_t)n;
+    }
+    return used < size ? used : size - 1;
+}
@@ -0,0 +1,126 @@
+#ifndef STATIONMANAGER_H
+#define STATIONMANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <functional>
+#include "Config.h"
+#include "SettingsStore.h"
+
+// WiFi STA link: joins the stored networks and keeps the link up.
+//
+// A recovery round starts at boot and whenever the link drops. It first tries
+// a targeted join of every stored network whose BSSID and channel are known
+// (no channel scan, well under a second when the access point is there), then
+// a full scan-and-join of each. A round that finds nothing waits
+// WIFI_BACKOFF_MIN_MS, doubling up to WIFI_BACKOFF_MAX_MS, before the next.
+// A network entered on /connect is tried on its own and stored, with its
+// location, once it works.
+//
+// Driven by WiFi events (the callback wakes the network job) and update() on
+// the loop task; update() only polls for attempt timeouts and the backoff.
+// The driver's own auto-reconnect is off so the two never race.
+//
+// The time from losing the link (or boot) to having an IP again goes into a
+// histogram per join kind (WIFI_LATENCY_BUCKETS buckets, 250 ms doubling).
+
+// WiFi provisioning progress of the network entered on /connect
+enum class ProvisioningState : uint8_t {
+    Idle,
+    Connecting,
+    Connected,
+    Failed
+};
+
+enum class StationState : uint8_t {
+    Idle,           // no stored network
+    Connecting,
+    Connected,
+    Backoff         // round failed, waiting for the next
+};
+
+enum class JoinKind : uint8_t {
+    Targeted,       // cached BSSID + channel
+    Full,           // all-channel scan for the SSID
+    COUNT
+};
+
+struct StationStats {
+    uint32_t attempts[(int)JoinKind::COUNT];
+    uint32_t joins[(int)JoinKind::COUNT];
+    uint32_t rounds;
+    uint32_t failedRounds;
+    uint32_t linkLosses;
+    uint32_t recoveries;            // outages ended (including the boot one)
+    uint32_t lastRecoveryMs;
+    uint32_t maxRecoveryMs;
+    uint32_t latency[(int)JoinKind::COUNT][WIFI_LATENCY_BUCKETS];
+};
+
+class StationManager {
+private:
+    SettingsStore* settings;
+    std::function<void()> eventCallback;    // invoked on the WiFi event task
+    bool eventsRegistered;
+
+    // Written by the WiFi event task, consumed in update()
+    volatile bool staGotIp;
+    volatile bool staDisconnected;
+    volatile uint8_t lastDisconnectReason;
+
+    StationState state;
+    JoinKind kind;                  // of the attempt in progress / the current link
+    uint8_t roundStep;              // next plan position: targeted 0..n-1, then full n..2n-1
+    char ssid[33];                  // network of the attempt in progress / the current link
+    unsigned long attemptStart;
+    unsigned long retryAt;          // Backoff: next round
+    uint32_t backoffMs;
+    bool outage;                    // outageStart is set: link lost (or boot), not back yet
+    unsigned long outageStart;
+    bool linkUpPending;             // reported by the next update()
+
+    // Network entered on /connect; the password is kept until the result is known
+    ProvisioningState provisioningState;
+    bool provisioning;              // the attempt in progress is the /connect network
+    char provisioningSsid[33];
+    char provisioningPassword[65];
+    unsigned long provisioningStart;
+    unsigned long provisioningDuration;
+
+    StationStats stats;
+
+    void registerEvents();
+    void join(const char* networkSsid, const char* password, const uint8_t* bssid, uint8_t channel, JoinKind joinKind);
+    void startRound();
+    void nextAttempt();
+    void onConnected();
+    void onAttemptFailed(uint8_t reason);
+    void finishProvisioning(ProvisioningState result);
+
+public:
+    StationManager();
+
+    void setSettingsStore(SettingsStore* store) { settings = store; }
+    void setEventCallback(std::function<void()> callback);
+
+    // Boot: start joining the stored networks; false if there are none
+    bool begin();
+    void connect(const char* networkSsid, const char* password);   // network from /connect
+    bool update();                  // true each time the link comes up
+
+    StationState getState() const { return state; }
+    bool isConnecting() const { return state == StationState::Connecting; }
+    const char* getSsid() const { return ssid; }
+    uint8_t getLastDisconnectReason() const { return lastDisconnectReason; }
+
+    ProvisioningState getProvisioningState() const { return provisioningState; }
+    const char* getProvisioningSsid() const { return provisioningSsid; }
+    unsigned long getProvisioningElapsed() const;
+
+    const StationStats& getStats() const { return stats; }
+    size_t formatReport(char* buffer, size_t size) const;
+    static const char* stateName(StationState state);
+    static const char* kindName(JoinKind kind);
+};
+
+#endif // STATIONMANAGER_H
@@ -0,0 +1,73 @@
+#ifndef TELEMETRYFRAME_H
+#define TELEMETRYFRAME_H
+
+// Binary telemetry wire format shared by the firmware (TelemetryManager) and the
+// host-side collector (tools/telemetry_collector.cpp). Keep this header free of
+// Arduino dependencies so it compiles on the host unchanged.
+//
+// One UDP datagram = TelemetryBatchHeader followed by frameCount TelemetryFrames.
+// All fields are little-endian (native on both ESP32 and x86/ARM hosts).
+
+#include <stdint.h>
+
+#define TELEMETRY_MAGIC   0x4247   // "GB" on the wire
+#define TELEMETRY_VERSION 1
+
+// Actuator bitfield (TelemetryFrame::actuators)
+#define TELEMETRY_ACT_PUMP    0x01
+#define TELEMETRY_ACT_GROWLED 0x02
+#define TELEMETRY_ACT_BOOST   0x04
+#define TELEMETRY_ACT_RGB     0x08
+
+// Frame flags (TelemetryFrame::flags)
+#define TELEMETRY_FLAG_UPTIME   0x01   // timestamp is seconds since boot (no NTP time yet)
+#define TELEMETRY_FLAG_NO_CLIMATE 0x02 // temperature/humidity not available
+
+// Sentinel values for missing climate readings
+#define TELEMETRY_TEMP_INVALID  ((int16_t)-32768)
+#define TELEMETRY_HUM_INVALID   ((uint16_t)0xFFFF)
+
+struct __attribute__((packed)) TelemetryBatchHeader {
+    uint16_t magic;          // TELEMETRY_MAGIC
+    uint8_t  version;        // TELEMETRY_VERSION
+    uint8_t  frameCount;     // number of frames following the header
+    uint16_t frameSize;      // sizeof(TelemetryFrame), lets old collectors skip newer fields
+    uint16_t droppedFrames;  // frames discarded on the device since the previous batch
+};
+
+struct __attribute__((packed)) TelemetryFrame {
+    uint16_t boxId;
+    uint32_t sequence;       // per-box, increments by one per frame
+    uint32_t timestamp;      // Unix seconds, or uptime seconds if TELEMETRY_FLAG_UPTIME
+    int16_t  temperature;    // 0.01 C
+    uint16_t humidity;       // 0.01 %RH
+    uint8_t  soilPercentage;
+    uint8_t  waterPercentage;
+    uint8_t  actuators;      // TELEMETRY_ACT_* bits
+    uint8_t  brightness;     // grow LED brightness 0-100
+    uint8_t  flags;          // TELEMETRY_FLAG_* bits
+    uint8_t  reserved;
+    uint16_t sensorErrors;   // cumulative failed climate reads (wraps)
+    uint16_t sendErrors;     // cumulative failed UDP sends (wraps)
+};
+
+static_assert(sizeof(TelemetryBatchHeader) == 8, "TelemetryBatchHeader layout changed");
+static_assert(sizeof(TelemetryFrame) == 24, "TelemetryFrame layout changed - bump TELEMETRY_VERSION");
+
+// Fixed-point helpers (0.01 resolution, rounded to nearest)
+inline int16_t telemetryEncodeTemperature(float celsius) {
+    if (celsius <= -998.0f || celsius != celsius) return TELEMETRY_TEMP_INVALID;
+    float scaled = celsius * 100.0f;
+    if (scaled > 32767.0f) scaled = 32767.0f;
+    if (scaled < -32767.0f) scaled = -32767.0f;
+    return (int16_t)(scaled + (scaled >= 0 ? 0.5f : -0.5f));
+}
+
+inline uint16_t telemetryEncodeHumidity(float percent) {
+    if (percent <= -998.0f || percent != percent) return TELEMETRY_HUM_INVALID;
+    if (percent < 0.0f) percent = 0.0f;
+    if (percent > 100.0f) percent = 100.0f;
+    return (uint16_t)(percent * 100.0f + 0.5f);
+}
+
+#endif // TELEMETRYFRAME_H
@@ -0,0 +1,83 @@
+#include "TelemetryManager.h"
+#include <time.h>
+
+TelemetryManager::TelemetryManager()
+    : batchCount(0), nextSequence(0), droppedFrames(0),
+      sensorErrors(0), sendErrors(0), batchesSent(0) {
+}
+
+void TelemetryManager::recordSample(float temperature, float humidity, int soilPercentage, int waterPercentage,
+                                    const DeviceController& devices) {
+    if (batchCount >= TELEMETRY_BATCH_SIZE) {
+        // Previous batch could not be sent (no STA link) - keep the newest samples,
+        // the collector sees the hole as a sequence gap.
+        memmove(&batch[0], &batch[1], sizeof(TelemetryFrame) * (TELEMETRY_BATCH_SIZE - 1));
+        batchCount = TELEMETRY_BATCH_SIZE - 1;
+        droppedFrames++;
+    }
+    
+    TelemetryFrame& frame = batch[batchCount++];
+    memset(&frame, 0, sizeof(frame));
+    frame.boxId = TELEMETRY_BOX_ID;
+    frame.sequence = nextSequence++;
+    
+    // Use wall-clock time once NTP has synced, otherwise uptime
+    time_t now = time(nullptr);
+    if (now > 1600000000) {
+        frame.timestamp = (uint32_t)now;
+    } else {
+        frame.timestamp = millis() / 1000;
+        frame.flags |= TELEMETRY_FLAG_UPTIME;
+    }
+    
+    frame.temperature = telemetryEncodeTemperature(temperature);
+    frame.humidity = telemetryEncodeHumidity(humidity);
+    if (frame.temperature == TELEMETRY_TEMP_INVALID || frame.humidity == TELEMETRY_HUM_INVALID) {
+        frame.flags |= TELEMETRY_FLAG_NO_CLIMATE;
+        sensorErrors++;
+    }
+    frame.soilPercentage = (uint8_t)constrain(soilPercentage, 0, 100);
+    frame.waterPercentage = (uint8_t)constrain(waterPercentage, 0, 100);
+    
+    if (devices.getPumpState())          frame.actuators |= TELEMETRY_ACT_PUMP;
+    if (devices.getGrowLedState())       frame.actuators |= TELEMETRY_ACT_GROWLED;
+    if (devices.getGrowLedBoostState())  frame.actuators |= TELEMETRY_ACT_BOOST;
+    if (devices.getRGBLedsEnabled())     frame.actuators |= TELEMETRY_ACT_RGB;
+    frame.brightness = (uint8_t)constrain(devices.getBrightness(), 0, 100);
+    frame.sensorErrors = sensorErrors;
+    frame.sendErrors = sendErrors;
+    
+    if (batchCount >= TELEMETRY_BATCH_SIZE) {
+        sendBatch();
+    }
+}
+
+bool TelemetryManager::sendBatch() {
+    // Telemetry only goes out over the STA link - never flood the setup AP
+    if (WiFi.status() != WL_CONNECTED) {
+        return false;
+    }
+    
+    TelemetryBatchHeader header;
+    header.magic = TELEMETRY_MAGIC;
+    header.version = TELEMETRY_VERSION;
+    header.frameCount = batchCount;
+    header.frameSize = sizeof(TelemetryFrame);
+    header.droppedFrames = droppedFrames;
+    
+    if (!udp.beginPacket(TELEMETRY_HOST, TELEMETRY_PORT)) {
+        sendErrors++;
+        return false;
+    }
+    udp.write((const uint8_t*)&header, sizeof(header));
+    udp.write((const uint8_t*)batch, sizeof(TelemetryFrame) * batchCount);
+    if (!udp.endPacket()) {
+        sendErrors++;
+        return false;
+    }
+    
+    batchesSent++;
+    batchCount = 0;
+    droppedFrames = 0;
+    return true;
+}
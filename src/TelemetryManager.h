@@ -0,0 +1,37 @@
+#ifndef TELEMETRYMANAGER_H
+#define TELEMETRYMANAGER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "Config.h"
+#include "TelemetryFrame.h"
+#include "DeviceController.h"
+
+// Collects one TelemetryFrame per sensor cycle and sends them to the fleet
+// collector as a single UDP datagram once TELEMETRY_BATCH_SIZE frames are queued.
+class TelemetryManager {
+private:
+    WiFiUDP udp;
+    TelemetryFrame batch[TELEMETRY_BATCH_SIZE];
+    uint8_t batchCount;
+    uint32_t nextSequence;
+    uint16_t droppedFrames;   // frames overwritten while the batch could not be sent
+    uint16_t sensorErrors;
+    uint16_t sendErrors;
+    uint32_t batchesSent;
+    
+    bool sendBatch();
+    
+public:
+    TelemetryManager();
+    
+    void recordSample(float temperature, float humidity, int soilPercentage, int waterPercentage,
+                      const DeviceController& devices);
+    
+    uint32_t getFramesRecorded() const { return nextSequence; }
+    uint32_t getBatchesSent() const { return batchesSent; }
+    uint16_t getSendErrors() const { return sendErrors; }
+};
+
+#endif // TELEMETRYMANAGER_H
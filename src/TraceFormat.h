@@ -0,0 +1,92 @@
+#ifndef TRACEFORMAT_H
+#define TRACEFORMAT_H
+
+// Binary sensor trace format shared by the firmware (TraceRecorder) and the
+// host replayer (tools/trace_replay.cpp). Keep this header free of Arduino
+// dependencies so it compiles on the host unchanged. Little-endian.
+//
+// A trace is a TraceHeader followed by recordBytes of records:
+//   tag      low nibble TraceRecordType, high nibble type flags
+//   delta    ms since the previous record (or baseMillis), LEB128 varint
+//   payload  fixed size per type, see traceRecordPayload()
+//
+// A sensor cycle records Climate, Water (or WaterSame), Soil, then Decision
+// and Pump if the firmware switched the pump, then Cycle. Pump records
+// outside a cycle are external changes (button, web). Pump records flagged
+// TRACE_PUMP_GUARD are PumpGuard cuts and refused starts. Button records carry
+// the pin level at each edge and whether the press was accepted.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Calibration.h"
+
+#define TRACE_MAGIC 0x52544247UL        // "GBTR"
+#define TRACE_VERSION 1
+#define TRACE_WATER_BYTES 20            // 8 low + 12 high section bytes
+#define TRACE_MAX_RECORD 26             // tag + 5 varint bytes + largest payload
+
+enum TraceRecordType : uint8_t {
+    TRACE_SOIL = 1,         // u16 analogRead value
+    TRACE_WATER = 2,        // TRACE_WATER_BYTES as read from 0x77 and 0x78
+    TRACE_WATER_SAME = 3,   // same bytes as the previous TRACE_WATER
+    TRACE_CLIMATE = 4,      // u16 t_data, u16 h_data, u8 status (t low nibble, h high nibble)
+    TRACE_BUTTON = 5,       // u8 TRACE_BUTTON_* bits
+    TRACE_DECISION = 6,     // u8 PumpAction taken by the firmware
+    TRACE_PUMP = 7,         // u8 relay state after a change (or a refused start)
+    TRACE_CYCLE = 8         // end of a sensor cycle, no payload
+};
+
+// TRACE_CLIMATE tag flags
+#define TRACE_CLIMATE_T_VALID 0x10
+#define TRACE_CLIMATE_H_VALID 0x20
+
+// TRACE_PUMP tag flag: set by PumpGuard, not by the pump rules
+#define TRACE_PUMP_GUARD 0x10
+
+// TRACE_BUTTON payload bits
+#define TRACE_BUTTON_LEVEL    0x01      // pin level after the edge (LOW = pressed)
+#define TRACE_BUTTON_ACCEPTED 0x02      // debounced press, toggled the pump
+
+// Payload size of a record type, -1 if unknown
+inline int traceRecordPayload(uint8_t type) {
+    switch (type) {
+        case TRACE_SOIL:       return 2;
+        case TRACE_WATER:      return TRACE_WATER_BYTES;
+        case TRACE_CLIMATE:    return 5;
+        case TRACE_BUTTON:
+        case TRACE_DECISION:
+        case TRACE_PUMP:       return 1;
+        case TRACE_WATER_SAME:
+        case TRACE_CYCLE:      return 0;
+        default:               return -1;
+    }
+}
+
+// ENS210 raw words -> hundredths, as ENS210::toCelsius/toPercentageH(x, 100)
+// compute them (no solder correction). Every climate driver reports in these
+// units, so the firmware converts with the same functions.
+inline int32_t traceCentiCelsius(uint16_t tData) { return ((int32_t)tData * 100 + 32) / 64 - 27315; }
+inline int32_t traceCentiHumidity(uint16_t hData) { return ((int32_t)hData * 100 + 256) / 512; }
+
+static_assert(sizeof(CalibrationData) == 40, "CalibrationData layout is part of the trace format");
+
+// TraceHeader::flags, state at baseMillis
+#define TRACE_HEADER_PUMP_ON 0x01       // relay was on
+#define TRACE_HEADER_WATER   0x02       // waterBytes holds the last water reading
+
+struct __attribute__((packed)) TraceHeader {
+    uint32_t magic;                     // TRACE_MAGIC
+    uint8_t  version;                   // TRACE_VERSION
+    uint8_t  flags;                     // TRACE_HEADER_*
+    uint16_t headerSize;                // sizeof(TraceHeader), records start here
+    uint32_t baseMillis;                // device millis() the first delta is relative to
+    uint32_t recordBytes;
+    uint32_t recordCount;
+    uint32_t droppedRecords;            // overwritten by the ring before download
+    char     build[24];                 // firmware build (compile date and time)
+    uint8_t  waterBytes[TRACE_WATER_BYTES];
+    CalibrationData soilCalibration;    // curves in effect at download
+    CalibrationData waterCalibration;
+};
+
+#endif // TRACEFORMAT_H
@@ -0,0 +1,179 @@
+#include "TraceRecorder.h"
+
+namespace {
+const size_t RING_SIZE = TRACE_RECORDER_ENABLED ? TRACE_BUFFER_SIZE : 1;
+
+uint8_t ring[RING_SIZE];
+size_t head = 0;                    // oldest record
+size_t used = 0;
+uint32_t records = 0;
+uint32_t dropped = 0;
+uint32_t baseMillis = 0;            // time the oldest record's delta is relative to
+uint32_t lastMillis = 0;            // time of the newest record
+
+// State at baseMillis, updated as old records are dropped
+bool basePump = false;
+bool baseWaterValid = false;
+uint8_t baseWater[TRACE_WATER_BYTES];
+
+// Newest state: pump relay, water bytes (for TRACE_WATER_SAME)
+bool lastPump = false;
+bool lastWaterValid = false;
+uint8_t lastWater[TRACE_WATER_BYTES];
+
+uint8_t byteAt(size_t offset) { return ring[(head + offset) % RING_SIZE]; }
+}
+
+void TraceRecorder::begin() {
+    lastPump = false;
+    clear();
+    Serial.printf("Trace recorder: %u byte ring\n", (unsigned)RING_SIZE);
+}
+
+void TraceRecorder::clear() {
+    // The state at the newest record becomes the new base
+    if (lastWaterValid) {
+        memcpy(baseWater, lastWater, TRACE_WATER_BYTES);
+    }
+    baseWaterValid = lastWaterValid;
+    basePump = lastPump;
+    head = 0;
+    used = 0;
+    records = 0;
+    dropped = 0;
+    baseMillis = lastMillis = millis();
+}
+
+void TraceRecorder::dropOldest() {
+    uint8_t type = byteAt(0) & 0x0F;
+    size_t pos = 1;
+    uint32_t delta = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    do {
+        b = byteAt(pos++);
+        delta |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    
+    if (type == TRACE_WATER) {
+        for (size_t i = 0; i < TRACE_WATER_BYTES; i++) {
+            baseWater[i] = byteAt(pos + i);
+        }
+        baseWaterValid = true;
+    } else if (type == TRACE_PUMP) {
+        basePump = byteAt(pos) != 0;
+    }
+    
+    size_t length = pos + traceRecordPayload(type);
+    baseMillis += delta;
+    head = (head + length) % RING_SIZE;
+    used -= length;
+    records--;
+    dropped++;
+}
+
+void TraceRecorder::append(uint8_t tag, const uint8_t* payload, size_t length) {
+    if (!TRACE_RECORDER_ENABLED) {
+        return;
+    }
+    uint32_t now = millis();
+    uint32_t delta = now - lastMillis;
+    uint8_t record[TRACE_MAX_RECORD];
+    size_t n = 0;
+    record[n++] = tag;
+    do {
+        uint8_t b = delta & 0x7F;
+        delta >>= 7;
+        record[n++] = delta ? (b | 0x80) : b;
+    } while (delta);
+    memcpy(record + n, payload, length);
+    n += length;
+    
+    while (used + n > RING_SIZE) {
+        dropOldest();
+    }
+    size_t tail = (head + used) % RING_SIZE;
+    for (size_t i = 0; i < n; i++) {
+        ring[(tail + i) % RING_SIZE] = record[i];
+    }
+    used += n;
+    records++;
+    lastMillis = now;
+}
+
+void TraceRecorder::recordSoil(uint16_t raw) {
+    uint8_t payload[2] = { (uint8_t)raw, (uint8_t)(raw >> 8) };
+    append(TRACE_SOIL, payload, sizeof(payload));
+}
+
+void TraceRecorder::recordWater(const uint8_t* low8, const uint8_t* high12) {
+    uint8_t bytes[TRACE_WATER_BYTES];
+    memcpy(bytes, low8, 8);
+    memcpy(bytes + 8, high12, 12);
+    if (lastWaterValid && memcmp(bytes, lastWater, TRACE_WATER_BYTES) == 0) {
+        append(TRACE_WATER_SAME, nullptr, 0);
+        return;
+    }
+    memcpy(lastWater, bytes, TRACE_WATER_BYTES);
+    lastWaterValid = true;
+    append(TRACE_WATER, bytes, TRACE_WATER_BYTES);
+}
+
+void TraceRecorder::recordClimate(uint16_t tData, uint16_t hData, uint8_t tStatus, uint8_t hStatus,
+                                  bool tValid, bool hValid) {
+    uint8_t payload[5] = { (uint8_t)tData, (uint8_t)(tData >> 8), (uint8_t)hData, (uint8_t)(hData >> 8),
+                           (uint8_t)((tStatus & 0x0F) | (hStatus << 4)) };
+    uint8_t tag = TRACE_CLIMATE | (tValid ? TRACE_CLIMATE_T_VALID : 0) | (hValid ? TRACE_CLIMATE_H_VALID : 0);
+    append(tag, payload, sizeof(payload));
+}
+
+void TraceRecorder::recordButton(bool level, bool accepted) {
+    uint8_t payload = (level ? TRACE_BUTTON_LEVEL : 0) | (accepted ? TRACE_BUTTON_ACCEPTED : 0);
+    append(TRACE_BUTTON, &payload, 1);
+}
+
+void TraceRecorder::recordDecision(PumpAction action) {
+    uint8_t payload = (uint8_t)action;
+    append(TRACE_DECISION, &payload, 1);
+}
+
+void TraceRecorder::recordPump(bool on, bool guard) {
+    uint8_t payload = on ? 1 : 0;
+    lastPump = on;
+    append(TRACE_PUMP | (guard ? TRACE_PUMP_GUARD : 0), &payload, 1);
+}
+
+void TraceRecorder::recordCycle() {
+    append(TRACE_CYCLE, nullptr, 0);
+}
+
+void TraceRecorder::fillHeader(TraceHeader& header, const CalibrationData& soil, const CalibrationData& water) {
+    memset(&header, 0, sizeof(header));
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    header.flags = (basePump ? TRACE_HEADER_PUMP_ON : 0) | (baseWaterValid ? TRACE_HEADER_WATER : 0);
+    header.headerSize = sizeof(TraceHeader);
+    header.baseMillis = baseMillis;
+    header.recordBytes = used;
+    header.recordCount = records;
+    header.droppedRecords = dropped;
+    strncpy(header.build, __DATE__ " " __TIME__, sizeof(header.build) - 1);
+    if (baseWaterValid) {
+        memcpy(header.waterBytes, baseWater, TRACE_WATER_BYTES);
+    }
+    header.soilCalibration = soil;
+    header.waterCalibration = water;
+}
+
+void TraceRecorder::getChunks(const uint8_t* chunks[2], size_t lengths[2]) {
+    size_t first = used < RING_SIZE - head ? used : RING_SIZE - head;
+    chunks[0] = ring + head;
+    lengths[0] = first;
+    chunks[1] = ring;
+    lengths[1] = used - first;
+}
+
+uint32_t TraceRecorder::getRecordCount() {
+    return records;
+}
@@ -0,0 +1,40 @@
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "TraceFormat.h"
+#include "PumpPolicy.h"
+
+// Records every raw sensor acquisition, button edge and pump decision into a
+// TRACE_BUFFER_SIZE RAM ring in the TraceFormat.h encoding. When the ring is
+// full the oldest records are dropped and folded into the header state, so a
+// download always replays from a consistent starting point. With
+// TRACE_RECORDER_ENABLED false every call is a no-op.
+//
+// Called from the loop task only (sensor, button and http jobs).
+class TraceRecorder {
+public:
+    static void begin();                    // start recording at millis(), pump off
+    static void clear();
+
+    static void recordSoil(uint16_t raw);
+    static void recordWater(const uint8_t* low8, const uint8_t* high12);
+    static void recordClimate(uint16_t tData, uint16_t hData, uint8_t tStatus, uint8_t hStatus,
+                              bool tValid, bool hValid);
+    static void recordButton(bool level, bool accepted);
+    static void recordDecision(PumpAction action);
+    static void recordPump(bool on, bool guard = false);   // guard: PumpGuard cut/refusal
+    static void recordCycle();
+
+    // Download: the header, then the ring as up to two contiguous chunks
+    static void fillHeader(TraceHeader& header, const CalibrationData& soil, const CalibrationData& water);
+    static void getChunks(const uint8_t* chunks[2], size_t lengths[2]);
+    static uint32_t getRecordCount();
+
+private:
+    static void append(uint8_t tag, const uint8_t* payload, size_t length);
+    static void dropOldest();
+};
+
+#endif // TRACERECORDER_H
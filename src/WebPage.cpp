@@ -1,8 +1,10 @@
 #include "WebPage.h"
 #include "Config.h"
+#include <cstring>
 
-String WebPage::getHTML() {
-    return R"delimiter(
+// Dashboard template. Upper-case tokens (TEMP, SOIL_R_VAL, ...) are placeholders;
+// they are located once by WebPage::begin() and never searched per request.
+static const char DASHBOARD_TEMPLATE[] PROGMEM = R"delimiter(
   <!DOCTYPE html>
     <html>
       <head>
@@ -313,13 +315,13 @@ R"delimiter(
         <!-- Buttons -->
         <div class="container">
           <h2>Pump</h2>
-          <a href="/toggle/1" class="PUMP_CLASS">PUMP_TEXT</a>
+          <a href="/toggle/1" class="PUMP_CLASS" data-cmd="pump">PUMP_TEXT</a>
           <h2>Grow LED</h2>
-          <a href="/toggle/2" class="LED_CLASS">GrowLED</a>
+          <a href="/toggle/2" class="LED_CLASS" data-cmd="grow_led">GrowLED</a>
           <h2>LED Boost</h2>
-          <a href="/toggle/4" class="BOOST_CLASS">BOOST_TEXT</a>
+          <a href="/toggle/4" class="BOOST_CLASS" data-cmd="boost">BOOST_TEXT</a>
           <h2>Status LEDs</h2>
-          <a href="/toggle/3" class="RGB_CLASS">RGB_LED</a>
+          <a href="/toggle/3" class="RGB_CLASS" data-cmd="rgb">RGB_LED</a>
         </div>
 
         <!-- Bars -->
@@ -335,6 +337,7 @@ R"delimiter(
             <div class="bar hum" style="width: HUM%"></div>
             <div class="bar-text">HUM %</div>
           </div>
+          <p class="label">Dew point: DEW_POINT &deg;C &middot; VPD: VPD_KPA kPa &middot; 24 h: TEMP_MIN_24H to TEMP_MAX_24H &deg;C</p>
         </div>
 
         <div class="container">
@@ -358,6 +361,7 @@ R"delimiter(
           </p>
           <input
             type="range"
+            id="brightness"
             min="0"
             max="100"
             value="BRIGHTNESS"
@@ -384,6 +388,30 @@ R"delimiter(
             fetch("/brightness/" + value);
           }
 
+          // Buttons switch through /api/commands and update in place instead of
+          // reloading the page; the /toggle/ links stay as the fallback
+          document.querySelectorAll("a[data-cmd]").forEach(function (button) {
+            button.addEventListener("click", function (event) {
+              event.preventDefault();
+              fetch("/api/commands", {
+                method: "POST",
+                headers: { "Content-Type": "application/x-www-form-urlencoded" },
+                body: button.dataset.cmd + "=toggle"
+              })
+              .then(response => response.json())
+              .then(state => {
+                document.querySelectorAll("a[data-cmd]").forEach(function (b) {
+                  const on = state[b.dataset.cmd] === 1;
+                  b.className = on ? "btn" : "btn-off";
+                  b.innerText = on ? "ON" : "OFF";
+                });
+                document.getElementById("brightness").value = state.brightness;
+                document.getElementById("brightnessValue").innerText = state.brightness + "%";
+              })
+              .catch(() => { window.location.href = button.href; });
+            });
+          });
+
 )delimiter"
 #if SIMULATION_MODE
 R"delimiter(
@@ -433,4 +461,70 @@ R"delimiter(
       </body>
     </html>
   )delimiter";
+
+// Placeholder tokens, indexed by WebPage::Field. Longer tokens that start with
+// a shorter one (SOIL_R_VAL vs SOIL) win because matching is longest-first.
+static const char* const FIELD_TOKENS[WebPage::FIELD_COUNT] = {
+    "TEMP", "HUM", "SOIL", "WATER",
+    "SOIL_R_VAL", "SOIL_G_VAL", "SOIL_B_VAL",
+    "WATER_R_VAL", "WATER_G_VAL", "WATER_B_VAL",
+    "PUMP_TEXT", "PUMP_CLASS", "GrowLED", "LED_CLASS",
+    "RGB_LED", "RGB_CLASS", "BOOST_TEXT", "BOOST_CLASS",
+    "BRIGHTNESS",
+    "DEW_POINT", "VPD_KPA", "TEMP_MIN_24H", "TEMP_MAX_24H"
+};
+
+WebPage::Segment WebPage::segments[WEBPAGE_MAX_SEGMENTS];
+uint8_t WebPage::segmentCount = 0;
+size_t WebPage::staticLength = 0;
+uint8_t WebPage::fieldUses[WebPage::FIELD_COUNT];
+
+// Returns the longest placeholder starting at text, or FIELD_COUNT
+static uint8_t matchField(const char* text) {
+    uint8_t best = WebPage::FIELD_COUNT;
+    size_t bestLength = 0;
+    for (uint8_t f = 0; f < WebPage::FIELD_COUNT; f++) {
+        size_t length = strlen(FIELD_TOKENS[f]);
+        if (length > bestLength && strncmp(text, FIELD_TOKENS[f], length) == 0) {
+            best = f;
+            bestLength = length;
+        }
+    }
+    return best;
+}
+
+void WebPage::begin() {
+    if (segmentCount > 0) {
+        return;
+    }
+    memset(fieldUses, 0, sizeof(fieldUses));
+    
+    const char* text = DASHBOARD_TEMPLATE;
+    size_t length = sizeof(DASHBOARD_TEMPLATE) - 1;
+    size_t literalStart = 0;
+    for (size_t i = 0; i < length; ) {
+        uint8_t field = matchField(text + i);
+        if (field == FIELD_COUNT) {
+            i++;
+            continue;
+        }
+        if (segmentCount == WEBPAGE_MAX_SEGMENTS) {
+            Serial.println("!!! Dashboard template has too many placeholders !!!");
+            break;
+        }
+        segments[segmentCount++] = Segment{(uint16_t)literalStart, (uint16_t)(i - literalStart), field};
+        fieldUses[field]++;
+        staticLength += i - literalStart;
+        i += strlen(FIELD_TOKENS[field]);
+        literalStart = i;
+    }
+    if (segmentCount < WEBPAGE_MAX_SEGMENTS) {
+        segments[segmentCount++] = Segment{(uint16_t)literalStart, (uint16_t)(length - literalStart), FIELD_COUNT};
+        staticLength += length - literalStart;
+    }
+    Serial.printf("Dashboard template: %d bytes, %d segments\n", (int)length, (int)segmentCount);
+}
+
+const char* WebPage::getTemplate() {
+    return DASHBOARD_TEMPLATE;
 }
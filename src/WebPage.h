@@ -3,9 +3,42 @@
 
 #include <Arduino.h>
 
+#define WEBPAGE_MAX_SEGMENTS 48
+
+// GrowBox dashboard. The HTML template lives in flash and is split once at
+// boot into literal segments, each followed by a placeholder field, so a
+// request only formats the field values and streams the pieces.
 class WebPage {
 public:
-    static String getHTML();
+    enum Field : uint8_t {
+        TEMP, HUM, SOIL, WATER,
+        SOIL_R, SOIL_G, SOIL_B,
+        WATER_R, WATER_G, WATER_B,
+        PUMP_TEXT, PUMP_CLASS, LED_TEXT, LED_CLASS,
+        RGB_TEXT, RGB_CLASS, BOOST_TEXT, BOOST_CLASS,
+        BRIGHTNESS,
+        DEW_POINT, VPD, TEMP_MIN_24H, TEMP_MAX_24H,
+        FIELD_COUNT    // also marks the final segment (no placeholder after it)
+    };
+
+    struct Segment {
+        uint16_t offset;   // literal text in the template
+        uint16_t length;
+        uint8_t field;     // placeholder following the literal, FIELD_COUNT for none
+    };
+
+    static void begin();
+    static const char* getTemplate();
+    static const Segment* getSegments() { return segments; }
+    static uint8_t getSegmentCount() { return segmentCount; }
+    static size_t getStaticLength() { return staticLength; }   // template bytes minus placeholders
+    static uint8_t getFieldUses(uint8_t field) { return fieldUses[field]; }
+
+private:
+    static Segment segments[WEBPAGE_MAX_SEGMENTS];
+    static uint8_t segmentCount;
+    static size_t staticLength;
+    static uint8_t fieldUses[FIELD_COUNT];
 };
 
 #endif // WEBPAGE_H
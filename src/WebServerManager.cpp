@@ -1,9 +1,229 @@
 #include "WebServerManager.h"
 #include "WebPage.h"
+#include "BootProfiler.h"
+#include "TraceRecorder.h"
+#include "DeadlineMonitor.h"
+#include "PumpGuard.h"
 #include <time.h>
+#include <esp_heap_caps.h>
+#include <lwip/sockets.h>
 
-WebServerManager::WebServerManager(SensorManager* sensorManager, DeviceController* deviceController, AuthManager* authManager)
-    : server(80), sensors(sensorManager), devices(deviceController), auth(authManager) {
+static const char INVALID_CREDENTIALS_PAGE[] PROGMEM =
+    "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
+    "<h1>Invalid Credentials</h1>"
+    "<p>The provided username or password is incorrect</p>"
+    "<p><a href='/'>Back to Login</a></p>"
+    "</body></html>";
+
+static const char INVALID_PARAMETERS_PAGE[] PROGMEM =
+    "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
+    "<h1>Invalid Parameters</h1>"
+    "<p>Network name and password are required</p>"
+    "<p><a href='/'>Back to Setup</a></p>"
+    "</body></html>";
+
+// Connecting page: CONNECTING_PAGE_HEAD + escaped SSID + CONNECTING_PAGE_TAIL
+static const char CONNECTING_PAGE_HEAD[] PROGMEM =
+    "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
+    "<h1 id='title'>Connecting...</h1>"
+    "<p id='status'>Joining ";
+
+static const char CONNECTING_PAGE_TAIL[] PROGMEM =
+    "</p>"
+    "<p id='link'></p>"
+    "<script>"
+    "function poll(){fetch('/connect-status').then(r=>r.json()).then(s=>{"
+    "if(s.state=='connected'){"
+    "document.getElementById('title').innerText='Connected Successfully!';"
+    "document.getElementById('status').innerText='Network: '+s.ssid+' - IP Address: '+s.ip;"
+    "document.getElementById('link').innerHTML=\"<a href='/dashboard' style='display: inline-block; margin-top: 20px; padding: 15px 30px; background-color: #4CAF50; color: white; text-decoration: none; border-radius: 5px;'>Go to GrowBox Dashboard</a>\";"
+    "}else if(s.state=='failed'){"
+    "document.getElementById('title').innerText='Connection Failed';"
+    "document.getElementById('status').innerText='Could not connect to '+s.ssid;"
+    "document.getElementById('link').innerHTML=\"<a href='/'>Back to Setup</a>\";"
+    "}else{setTimeout(poll,1000);}"
+    "}).catch(()=>setTimeout(poll,1000));}"
+    "setTimeout(poll,1000);"
+    "</script>"
+    "</body></html>";
+
+WebServerManager::WebServerManager(SensorManager* sensorManager, DeviceController* deviceController,
+                                   AuthManager* authManager, Scheduler* jobScheduler,
+                                   ActuatorCommandQueue* actuatorQueue)
+    : server(80), sensors(sensorManager), devices(deviceController), auth(authManager),
+      scheduler(jobScheduler), commandQueue(actuatorQueue), routeStats(), httpJob(SCHEDULER_NO_JOB),
+      readinessTask(nullptr), listenFd(-1), clientFd(-1), anomalies(nullptr),
+      calibrationDraft(), calibrationSensor(CalibrationSensor::Soil), calibrationActive(false)
+#if HTTPS_ENABLED
+      , settings(nullptr)
+#endif
+#if SOAK_TEST_MODE
+      , soakMonitor(nullptr), soakDriver(nullptr)
+#endif
+{
+}
+
+StrView WebServerManager::Server::argView(const char* name) const {
+    // Same lookup order as WebServer::arg(): POST body first, then query string
+    for (int i = 0; i < _postArgsLen; i++) {
+        if (strcmp(_postArgs[i].key.c_str(), name) == 0) {
+            return StrView(_postArgs[i].value.c_str(), _postArgs[i].value.length());
+        }
+    }
+    for (int i = 0; i < _currentArgCount; i++) {
+        if (strcmp(_currentArgs[i].key.c_str(), name) == 0) {
+            return StrView(_currentArgs[i].value.c_str(), _currentArgs[i].value.length());
+        }
+    }
+    return StrView();
+}
+
+bool WebServerManager::Server::hasArgView(const char* name) const {
+    for (int i = 0; i < _postArgsLen; i++) {
+        if (strcmp(_postArgs[i].key.c_str(), name) == 0) {
+            return true;
+        }
+    }
+    for (int i = 0; i < _currentArgCount; i++) {
+        if (strcmp(_currentArgs[i].key.c_str(), name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+StrView WebServerManager::Server::argNameView(int index) const {
+    const RequestArgument& arg = index < _postArgsLen ? _postArgs[index] : _currentArgs[index - _postArgsLen];
+    return StrView(arg.key.c_str(), arg.key.length());
+}
+
+StrView WebServerManager::Server::argValueView(int index) const {
+    const RequestArgument& arg = index < _postArgsLen ? _postArgs[index] : _currentArgs[index - _postArgsLen];
+    return StrView(arg.value.c_str(), arg.value.length());
+}
+
+bool WebServerManager::RouteDispatcher::canHandle(HTTPMethod method, String uri) {
+    // Called once per request before headers/body are parsed
+    uint32_t start = ESP.getCycleCount();
+    match = Routes::resolve(method, uri.c_str());
+    uint32_t cycles = ESP.getCycleCount() - start;
+    
+    RouteStats& stats = owner->routeStats;
+    stats.requests++;
+    stats.lastResolveCycles = cycles;
+    stats.totalResolveCycles += cycles;
+    if (cycles > stats.maxResolveCycles) {
+        stats.maxResolveCycles = cycles;
+    }
+    return true;   // unknown URLs are handled too (captive portal)
+}
+
+// Admission tokens per route: rendering the dashboard or taking a
+// calibration reading costs more than a toggle or a static answer
+static uint8_t admissionCost(RouteId route) {
+    return route == RouteId::Dashboard || route == RouteId::Calibration ? HTTP_HEAVY_COST : 1;
+}
+
+#if HTTPS_ENABLED
+// Plain HTTP that reached the box over the STA link (the home network) is
+// redirected to HTTPS_PORT, except the captive-portal probes. The setup AP
+// stays on plain HTTP: captive-portal mini-browsers (iOS CNA, Android's
+// portal login) refuse the self-signed certificate, so redirecting there
+// would break first-time WiFi setup.
+static bool servedOverHttp(RouteId route) {
+    return route == RouteId::CaptiveRedirect || route == RouteId::CaptiveNoContent || route == RouteId::CaptiveOk;
+}
+#endif
+
+bool WebServerManager::RouteDispatcher::handle(WebServer& server, HTTPMethod requestMethod, String requestUri) {
+    // Admission before any handler work: a shed request costs one short 503.
+    // Requests relayed by the HTTPS proxy arrive from loopback and are charged
+    // to the client it names.
+    IPAddress client = server.client().remoteIP();
+#if HTTPS_ENABLED
+    // Loopback is the HTTPS proxy or the soak driver; the AP side is the setup portal
+    bool plainHttpOnSta = client[0] != 127 && server.client().localIP() != WiFi.softAPIP();
+    IPAddress forwarded;
+    if (client[0] == 127 && server.hasHeader("X-Forwarded-For") &&
+        forwarded.fromString(server.header("X-Forwarded-For"))) {
+        client = forwarded;
+    }
+#endif
+    uint32_t retryAfterSec;
+    AdmissionResult admitted = owner->admission.admit(client, admissionCost(match.id), millis(), retryAfterSec);
+    if (admitted != AdmissionResult::Accepted) {
+        char retryAfter[12];
+        snprintf(retryAfter, sizeof(retryAfter), "%lu", (unsigned long)retryAfterSec);
+        server.sendHeader("Retry-After", retryAfter);
+        server.send(503, "text/plain", admitted == AdmissionResult::ShedClient ? "rate limited\n" : "busy\n");
+        return true;
+    }
+    
+    unsigned long start = micros();
+    owner->arena.reset();
+#if HTTPS_ENABLED
+    if (plainHttpOnSta && !servedOverHttp(match.id)) {
+        owner->redirectToHttps(requestMethod);
+        return true;
+    }
+#endif
+    owner->dispatch(match.id, match.param);
+    unsigned long elapsed = micros() - start;
+    if (elapsed > owner->routeStats.maxHandlerMicros) {
+        owner->routeStats.maxHandlerMicros = elapsed;
+    }
+    return true;
+}
+
+void WebServerManager::dispatch(RouteId route, int param) {
+    switch (route) {
+        case RouteId::Root:             handleRoot(); break;
+        case RouteId::Connect:          handleConnect(); break;
+        case RouteId::ConnectStatus:    handleConnectStatus(); break;
+        case RouteId::ScanNetworks:     handleScanNetworks(); break;
+        case RouteId::Dashboard:        handleDashboard(); break;
+        case RouteId::Toggle:           handleToggle(param); break;
+        case RouteId::Brightness:       handleBrightness(param); break;
+        case RouteId::Commands:         handleCommands(); break;
+        case RouteId::Stats:            handleStats(); break;
+#if SIMULATION_MODE
+        case RouteId::Simulation:       handleSimulation(); break;
+#endif
+        case RouteId::Favicon:          handleFavicon(); break;
+        case RouteId::Calibration:      handleCalibration(); break;
+        case RouteId::CaptiveRedirect:  handleCaptiveRedirect(); break;
+        case RouteId::CaptiveNoContent: server.send(204, "text/plain", ""); break;
+        case RouteId::CaptiveOk:        server.send(200, "text/plain", ""); break;
+        case RouteId::DebugRoutes:      handleDebugRoutes(); break;
+        case RouteId::DebugDns:         handleDebugDns(); break;
+        case RouteId::DebugScheduler:   handleDebugScheduler(); break;
+        case RouteId::DebugHeap:        handleDebugHeap(); break;
+        case RouteId::DebugBoot:        handleDebugBoot(); break;
+        case RouteId::DebugI2c:         handleDebugI2c(); break;
+        case RouteId::DebugWifi:        handleDebugWifi(); break;
+        case RouteId::DebugHttp:        handleDebugHttp(); break;
+        case RouteId::DebugDeadline:    handleDebugDeadline(); break;
+        case RouteId::DebugPump:        handleDebugPump(); break;
+        case RouteId::DebugAnomaly:     handleDebugAnomaly(); break;
+#if TRACE_RECORDER_ENABLED
+        case RouteId::DebugTrace:       handleDebugTrace(); break;
+#endif
+#if HTTPS_ENABLED
+        case RouteId::DebugTls:         handleDebugTls(); break;
+#endif
+#if SOAK_TEST_MODE
+        case RouteId::DebugSoak:        handleDebugSoak(); break;
+#endif
+        default:
+            routeStats.notFound++;
+            handleNotFound();
+            break;
+    }
+}
+
+void WebServerManager::sendBody(int code, const char* contentType, const ArenaWriter& body) {
+    // Explicit length: the buffer is written as-is instead of being copied into a String
+    server.send_P(code, contentType, body.c_str(), body.length());
 }
 
 bool WebServerManager::checkAuthentication() {
@@ -16,54 +236,59 @@ bool WebServerManager::checkAuthentication() {
 }
 
 void WebServerManager::begin() {
-    // Set up server routes
-    server.on("/", [this]() { handleRoot(); });
-    server.on("/connect", HTTP_POST, [this]() { handleConnect(); });
-    server.on("/scan-networks", HTTP_GET, [this]() { handleScanNetworks(); });
-    server.on("/dashboard", HTTP_GET, [this]() { handleDashboard(); });
-    server.on(UriBraces("/toggle/{}"), [this]() { handleToggle(); });
-    server.on(UriBraces("/brightness/{}"), [this]() { handleBrightness(); });
-#if SIMULATION_MODE
-    server.on("/simulation", HTTP_POST, [this]() { handleSimulation(); });
-#endif
-    server.on("/favicon.ico", [this]() { handleFavicon(); });
-    
-    // Captive portal detection routes (for various devices/OS)
-    // Android
-    server.on("/generate_204", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/gen_204", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/204", [this]() { server.send(204, "text/plain", ""); });
-    // Apple/iOS
-    server.on("/hotspot-detect.html", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/library/test/success.html", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    // Windows
-    server.on("/ncsi.txt", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/connecttest.txt", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/redirect", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    // Other
-    server.on("/canonical.html", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/success.txt", [this]() { server.sendHeader("Location", "http://192.168.4.1/", true); server.send(302, "text/plain", ""); });
-    server.on("/ipv6check", [this]() { server.send(200, "text/plain", ""); });
-    
-    server.onNotFound([this]() { handleNotFound(); });
+    // All routes are resolved by one dispatcher against the table in Routes.h
+    server.addHandler(new RouteDispatcher(this));
+    WebPage::begin();
     
+#if HTTPS_ENABLED
+    const char* forwardedHeaders[] = { "X-Forwarded-For" };
+    server.collectHeaders(forwardedHeaders, 1);
+#endif
     server.begin();
     
-    // Start DNS server for captive portal (redirect all DNS requests to ESP32)
-    dnsServer.start(53, "*", WiFi.softAPIP());
+    // WebServer has no readiness callback and WiFiServer keeps its socket
+    // private, so the port 80 listener is looked up among lwIP's sockets
+    listenFd = findListener(80);
+    if (listenFd < 0) {
+        Serial.printf("HTTP: listener not found, polling every %d ms\n", WEB_CLIENT_TICK_MS);
+    }
+    if (xTaskCreatePinnedToCore(readinessEntry, "http-ready", WEB_READY_TASK_STACK, this, 1,
+                                &readinessTask, tskNO_AFFINITY) != pdPASS) {
+        Serial.println("!!! HTTP readiness task failed to start !!!");
+        readinessTask = nullptr;
+    }
+    
+    // Start DNS server for captive portal (redirect all DNS requests to ESP32).
+    // It runs in its own task, independent of handleClient().
+    if (!dnsServer.start(WiFi.softAPIP())) {
+        Serial.println("!!! Captive portal DNS failed to start !!!");
+    }
     
-    Serial.println("HTTP server started");
+    Serial.printf("HTTP server started (%d routes, %d-slot table, %d bytes)\n",
+                  (int)Routes::COUNT, ROUTE_SLOT_COUNT,
+                  (int)(sizeof(Routes::TABLE) + sizeof(Routes::SLOTS) + sizeof(RouteDispatcher)));
     Serial.println("DNS server started (Captive Portal)");
+#if HTTPS_ENABLED
+    // Own task; loads or generates the TLS identity off the boot path
+    if (!https.begin(settings)) {
+        Serial.println("!!! HTTPS front end failed to start !!!");
+    }
+#endif
     Serial.println("Access Point: GrowBox_Setup (Open Network)");
+#if HTTPS_ENABLED
+    Serial.print("URL: https://");
+#else
     Serial.print("URL: http://");
+#endif
     Serial.println(WiFi.softAPIP());
 }
 
 void WebServerManager::handleRoot() {
     // Show login page if not authenticated
     if (!auth->isUserAuthenticated()) {
-        String loginPage = auth->getLoginPageHTML();
-        server.send(200, "text/html", loginPage);
+        // Render from the cache right away; refresh it in the background if stale
+        auth->requestNetworkScan();
+        sendLoginPage();
         return;
     }
     
@@ -72,65 +297,78 @@ void WebServerManager::handleRoot() {
     server.send(303);
 }
 
+void WebServerManager::sendLoginPage() {
+    // Stream the static prefix/suffix straight from flash around the cached option block
+    server.setContentLength(auth->getLoginPageLength());
+    server.send(200, "text/html", "");
+    server.sendContent_P(AuthManager::getLoginPagePrefix(), AuthManager::getLoginPagePrefixLength());
+    if (auth->getNetworkOptionsLength() > 0) {
+        server.sendContent(auth->getNetworkOptions(), auth->getNetworkOptionsLength());
+    }
+    server.sendContent_P(AuthManager::getLoginPageSuffix(), AuthManager::getLoginPageSuffixLength());
+}
+
 void WebServerManager::handleConnect() {
-    String network = server.arg("network");
-    String wifi_password = server.arg("wifi_password");
-    String username = server.arg("username");
-    String password = server.arg("password");
+    StrView network = server.argView("network");
+    StrView wifiPassword = server.argView("wifi_password");
+    StrView username = server.argView("username");
+    StrView password = server.argView("password");
 
     // First validate the credentials
-    if (!auth->validateCredentials(username.c_str(), password.c_str())) {
-        server.send(401, "text/html", 
-            "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
-            "<h1>Invalid Credentials</h1>"
-            "<p>The provided username or password is incorrect</p>"
-            "<p><a href='/'>Back to Login</a></p>"
-            "</body></html>");
+    if (!auth->validateCredentials(username.data, password.data)) {
+        server.send_P(401, "text/html", INVALID_CREDENTIALS_PAGE);
         return;
     }
 
-    if (network.length() > 0 && wifi_password.length() > 0) {
-        bool connected = AuthManager::connectToWiFi(network, wifi_password);
+    if (!network.empty() && !wifiPassword.empty()) {
+        // Connection runs in the background; the page polls /connect-status
+        auth->startProvisioning(network.data, wifiPassword.data);
         
-        if (connected) {
-            auth->setAuthenticated(true);
-            
-            // Restart server to listen on new IP
-            server.close();
-            delay(1000);
-            server.begin();
-            
-            // Initialize time after WiFi connection
-            initTime();
-            
-            server.send(200, "text/html", 
-                "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
-                "<h1>Connected Successfully!</h1>"
-                "<p>Network: " + network + "</p>"
-                "<p>IP Address: " + WiFi.localIP().toString() + "</p>"
-                "<p><a href='/dashboard' style='display: inline-block; margin-top: 20px; padding: 15px 30px; background-color: #4CAF50; color: white; text-decoration: none; border-radius: 5px;'>Go to GrowBox Dashboard</a></p>"
-                "</body></html>");
-        } else {
-            server.send(400, "text/html", 
-                "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
-                "<h1>Connection Failed</h1>"
-                "<p>Could not connect to " + network + "</p>"
-                "<p><a href='/'>Back to Setup</a></p>"
-                "</body></html>");
-        }
+        ArenaWriter body = arena.writer();
+        body.append(CONNECTING_PAGE_HEAD, sizeof(CONNECTING_PAGE_HEAD) - 1);
+        body.appendHtmlEscaped(network.data, network.length);
+        body.append(CONNECTING_PAGE_TAIL, sizeof(CONNECTING_PAGE_TAIL) - 1);
+        
+        server.sendHeader("Location", "/connect-status");
+        sendBody(202, "text/html", body);
     } else {
-        server.send(400, "text/html", 
-            "<html><body style='font-family: Arial; text-align: center; margin-top: 50px;'>"
-            "<h1>Invalid Parameters</h1>"
-            "<p>Network name and password are required</p>"
-            "<p><a href='/'>Back to Setup</a></p>"
-            "</body></html>");
+        server.send_P(400, "text/html", INVALID_PARAMETERS_PAGE);
     }
 }
 
+void WebServerManager::handleConnectStatus() {
+    const char* ssid = auth->getProvisioningSsid();
+    
+    ArenaWriter json = arena.writer(256);
+    json.append("{\"state\":\"");
+    json.append(auth->getProvisioningStateName());
+    json.append("\",\"ssid\":\"");
+    json.appendJsonEscaped(ssid, strlen(ssid));
+    json.append("\",\"ip\":\"");
+    if (auth->getProvisioningState() == ProvisioningState::Connected) {
+        IPAddress ip = WiFi.localIP();
+        json.appendf("%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    }
+    json.appendf("\",\"elapsed_ms\":%lu,\"reason\":%u}",
+                 (unsigned long)auth->getProvisioningElapsed(), (unsigned)auth->getLastDisconnectReason());
+    
+    server.sendHeader("Cache-Control", "no-store");
+    sendBody(200, "application/json", json);
+}
+
 void WebServerManager::handleScanNetworks() {
-    auth->scanNetworks();
-    server.send(200, "text/plain", "Networks scanned");
+    // ?refresh=1 starts a background scan (coalesced); plain GET just reports progress
+    if (server.hasArgView("refresh")) {
+        auth->requestNetworkScan(true);
+    }
+    
+    ArenaWriter json = arena.writer(96);
+    json.appendf("{\"scanning\":%s,\"generation\":%lu,\"count\":%d}",
+                 auth->isScanInProgress() ? "true" : "false",
+                 (unsigned long)auth->getScanGeneration(), (int)auth->getNetworkCount());
+    
+    server.sendHeader("Cache-Control", "no-store");
+    sendBody(200, "application/json", json);
 }
 
 void WebServerManager::handleDashboard() {
@@ -138,109 +376,134 @@ void WebServerManager::handleDashboard() {
         return;
     }
     
-    String response = WebPage::getHTML();
-    
+    // Render only: the sensor job owns the readings, the pump decision
+    // (decidePump) and the status LEDs. It keeps these fresh; only touch the
+    // bus/ADC before its first cycle.
     float temperature = sensors->readTemperature();
     float humidity = sensors->readHumidity();
-    // Read water first to avoid interference from soil sensor
-    int waterPercentage = sensors->getWaterPercentage();
-    int soilPercentage = sensors->getSoilPercentage();
-
-    // Auto-stop pump if water runs out (safety first!)
-    if (waterPercentage <= 10 && devices->getPumpState()) {
-        devices->setPumpState(false);
+    int waterPercentage = sensors->getLastWaterPercentage();
+    int soilPercentage = sensors->getLastSoilPercentage();
+    if (waterPercentage < 0 || soilPercentage < 0) {
+        // Read water first to avoid interference from soil sensor
+        waterPercentage = sensors->getWaterPercentage();
+        soilPercentage = sensors->getSoilPercentage();
     }
-    
-    // Auto-start pump if soil is too dry (< 20%) and there's water available
-    if (soilPercentage < 20 && waterPercentage > 10) {
-        devices->setPumpState(true);
-    }
-    
-    // Auto-stop pump if soil is too wet (> 80%)
-    if (soilPercentage > 80) {
-        devices->setPumpState(false);
-    }
-
-    // Update RGB colors based on sensor values (always do this)
-    devices->updateSoilMoistureColor(soilPercentage);
-    devices->updateWaterLevelColor(waterPercentage);
-    
-    Serial.println("=== Dashboard RGB Values ===");
-    Serial.printf("Soil RGB: R=%d, G=%d, B=%d\n", 
-                  devices->getSoilRedValue(), devices->getSoilGreenValue(), devices->getSoilBlueValue());
-    Serial.printf("Water RGB: R=%d, G=%d, B=%d\n", 
-                  devices->getWaterRedValue(), devices->getWaterGreenValue(), devices->getWaterBlueValue());
 
-    // Replace Soil Moisture RGB values FIRST (before replacing SOIL with percentage)
-    String soilR = String(devices->getSoilRedValue());
-    String soilG = String(devices->getSoilGreenValue());
-    String soilB = String(devices->getSoilBlueValue());
-    response.replace("SOIL_R_VAL", soilR);
-    response.replace("SOIL_G_VAL", soilG);
-    response.replace("SOIL_B_VAL", soilB);
-    Serial.printf("Replacing SOIL RGB: %s, %s, %s\n", soilR.c_str(), soilG.c_str(), soilB.c_str());
+    // Format every placeholder value once; the literal template text comes from flash
+    StrView values[WebPage::FIELD_COUNT];
+    ArenaWriter fields = arena.writer(256);
+    auto setNumber = [&](uint8_t field, long value) {
+        size_t start = fields.length();
+        fields.appendInt(value);
+        values[field] = StrView(fields.c_str() + start, fields.length() - start);
+    };
+    auto setText = [&](uint8_t field, const char* text) {
+        values[field] = StrView(text, strlen(text));
+    };
+    auto setDecimal = [&](uint8_t field, float value, int decimals, bool valid) {
+        if (!valid) {
+            setText(field, "--");
+            return;
+        }
+        size_t start = fields.length();
+        fields.appendf("%.*f", decimals, value);
+        values[field] = StrView(fields.c_str() + start, fields.length() - start);
+    };
     
-    // Replace Water Level RGB values FIRST (before replacing WATER with percentage)
-    String waterR = String(devices->getWaterRedValue());
-    String waterG = String(devices->getWaterGreenValue());
-    String waterB = String(devices->getWaterBlueValue());
-    response.replace("WATER_R_VAL", waterR);
-    response.replace("WATER_G_VAL", waterG);
-    response.replace("WATER_B_VAL", waterB);
-    Serial.printf("Replacing WATER RGB: %s, %s, %s\n", waterR.c_str(), waterG.c_str(), waterB.c_str());
-
     if (isnan(temperature) || isnan(humidity)) {
-        response.replace("TEMP", "0");
-        response.replace("HUM", "0");
+        setNumber(WebPage::TEMP, 0);
+        setNumber(WebPage::HUM, 0);
     } else {
-        int tempPercentage = constrain(temperature, 0, 100);
-        int humPercentage = constrain(humidity, 0, 100);
-        response.replace("TEMP", String(tempPercentage));
-        response.replace("HUM", String(humPercentage));
+        setNumber(WebPage::TEMP, constrain(temperature, 0, 100));
+        setNumber(WebPage::HUM, constrain(humidity, 0, 100));
     }
+    setNumber(WebPage::SOIL, soilPercentage);
+    setNumber(WebPage::WATER, waterPercentage);
+    setNumber(WebPage::SOIL_R, devices->getSoilRedValue());
+    setNumber(WebPage::SOIL_G, devices->getSoilGreenValue());
+    setNumber(WebPage::SOIL_B, devices->getSoilBlueValue());
+    setNumber(WebPage::WATER_R, devices->getWaterRedValue());
+    setNumber(WebPage::WATER_G, devices->getWaterGreenValue());
+    setNumber(WebPage::WATER_B, devices->getWaterBlueValue());
+    setText(WebPage::PUMP_TEXT, devices->getPumpState() ? "ON" : "OFF");
+    setText(WebPage::PUMP_CLASS, devices->getPumpState() ? "btn" : "btn-off");
+    setText(WebPage::LED_TEXT, devices->getGrowLedState() ? "ON" : "OFF");
+    setText(WebPage::LED_CLASS, devices->getGrowLedState() ? "btn" : "btn-off");
+    setText(WebPage::RGB_TEXT, devices->getRGBLedsEnabled() ? "ON" : "OFF");
+    setText(WebPage::RGB_CLASS, devices->getRGBLedsEnabled() ? "btn" : "btn-off");
+    setText(WebPage::BOOST_TEXT, devices->getGrowLedBoostState() ? "ON" : "OFF");
+    setText(WebPage::BOOST_CLASS, devices->getGrowLedBoostState() ? "btn" : "btn-off");
+    setNumber(WebPage::BRIGHTNESS, devices->getBrightness());
     
-    // Replace sensor percentages (do this AFTER RGB replacements)
-    response.replace("SOIL", String(soilPercentage));
-    response.replace("WATER", String(waterPercentage));
-
-    // Update device states in the HTML response
-    response.replace("PUMP_TEXT", devices->getPumpState() ? "ON" : "OFF");
-    response.replace("PUMP_CLASS", devices->getPumpState() ? "btn" : "btn-off");
-    response.replace("GrowLED", devices->getGrowLedState() ? "ON" : "OFF");
-    response.replace("LED_CLASS", devices->getGrowLedState() ? "btn" : "btn-off");
-    response.replace("RGB_LED", devices->getRGBLedsEnabled() ? "ON" : "OFF");
-    response.replace("RGB_CLASS", devices->getRGBLedsEnabled() ? "btn" : "btn-off");
-    response.replace("BOOST_TEXT", devices->getGrowLedBoostState() ? "ON" : "OFF");
-    response.replace("BOOST_CLASS", devices->getGrowLedBoostState() ? "btn" : "btn-off");
-
-    // Replace BRIGHTNESS with the actual brightness value
-    response.replace("BRIGHTNESS", String(devices->getBrightness()));
-
-    server.send(200, "text/html", response);
+    // Derived climate and the 24 h range come from the running stats, no rescan
+    SensorStats& stats = sensors->getStats();
+    StatsSummary day = stats.get(StatsChannel::Temperature, StatsWindow::Day, millis());
+    setDecimal(WebPage::DEW_POINT, stats.getDewPoint(), 1, stats.getDewPoint() > SENSOR_NO_READING);
+    setDecimal(WebPage::VPD, stats.getVpd(), 2, stats.getVpd() > SENSOR_NO_READING);
+    setDecimal(WebPage::TEMP_MIN_24H, day.min, 1, day.count > 0);
+    setDecimal(WebPage::TEMP_MAX_24H, day.max, 1, day.count > 0);
+    
+    size_t contentLength = WebPage::getStaticLength();
+    for (uint8_t f = 0; f < WebPage::FIELD_COUNT; f++) {
+        contentLength += values[f].length * WebPage::getFieldUses(f);
+    }
+    server.setContentLength(contentLength);
+    server.send(200, "text/html", "");
+    
+    // Coalesce small segments and values into arena-sized writes; large
+    // literals (the stylesheet) go out directly from flash
+    const char* page = WebPage::getTemplate();
+    const WebPage::Segment* segments = WebPage::getSegments();
+    ArenaWriter out = arena.writer();
+    auto flush = [&]() {
+        if (out.length() > 0) {
+            server.sendContent(out.c_str(), out.length());
+            out.clear();
+        }
+    };
+    for (uint8_t i = 0; i < WebPage::getSegmentCount(); i++) {
+        const WebPage::Segment& segment = segments[i];
+        if (segment.length > out.remaining()) {
+            flush();
+        }
+        if (segment.length > out.remaining()) {
+            server.sendContent_P(page + segment.offset, segment.length);
+        } else {
+            out.append(page + segment.offset, segment.length);
+        }
+        if (segment.field != WebPage::FIELD_COUNT) {
+            const StrView& value = values[segment.field];
+            if (value.length > out.remaining()) {
+                flush();
+            }
+            out.append(value);
+        }
+    }
+    flush();
 }
 
-void WebServerManager::handleToggle() {
+void WebServerManager::handleToggle(int button) {
     if (!checkAuthentication()) {
         return;
     }
     
-    String button = server.pathArg(0);
     Serial.print("Toggle Button: ");
     Serial.println(button);
 
-    int buttonNumber = button.toInt();
-    switch (buttonNumber) {
+    // Queued like /api/commands: the control loop applies it (and asks the
+    // pump guard) within ACTUATOR_APPLY_INTERVAL_MS
+    switch (button) {
         case 1:
-            devices->togglePump();
+            commandQueue->postSwitch(ActuatorCommandQueue::Pump, SwitchCommand::Toggle);
             break;
         case 2:
-            devices->toggleGrowLed();
+            commandQueue->postSwitch(ActuatorCommandQueue::GrowLed, SwitchCommand::Toggle);
             break;
         case 3:
-            devices->toggleRGBLeds();
+            commandQueue->postSwitch(ActuatorCommandQueue::RgbLeds, SwitchCommand::Toggle);
             break;
         case 4:
-            devices->toggleGrowLedBoost();
+            commandQueue->postSwitch(ActuatorCommandQueue::Boost, SwitchCommand::Toggle);
             break;
     }
 
@@ -248,30 +511,511 @@ void WebServerManager::handleToggle() {
     server.send(303);
 }
 
-void WebServerManager::handleBrightness() {
+void WebServerManager::handleBrightness(int brightness) {
     if (!checkAuthentication()) {
         return;
     }
     
-    String brightnessValue = server.pathArg(0);
-    int brightness = brightnessValue.toInt();
-    brightness = constrain(brightness, 0, 100);
-    // If brightness > 0 and LED is off, turn it on first
-    if (brightness > 0 && !devices->getGrowLedState()) {
-        devices->setGrowLedState(true);
-    }
-    devices->updateGrowLEDBrightness(brightness);
+    // Queued: a slider drag posts many values, the control loop applies the
+    // latest every ACTUATOR_APPLY_INTERVAL_MS (a value > 0 also turns the LED on)
+    commandQueue->postBrightness(brightness);
     server.send(204);
 }
 
+static bool parseSwitchCommand(const StrView& value, SwitchCommand& command) {
+    if (value.equals("on") || value.equals("1")) {
+        command = SwitchCommand::On;
+    } else if (value.equals("off") || value.equals("0")) {
+        command = SwitchCommand::Off;
+    } else if (value.equals("toggle")) {
+        command = SwitchCommand::Toggle;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void WebServerManager::handleCommands() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    // Parse the whole batch first: one bad operation rejects all of them
+    ActuatorCommands commands;
+    for (int i = 0; i < server.argViewCount(); i++) {
+        StrView name = server.argNameView(i);
+        StrView value = server.argValueView(i);
+        bool ok;
+        if (name.equals("pump")) {
+            ok = parseSwitchCommand(value, commands.pump);
+        } else if (name.equals("grow_led")) {
+            ok = parseSwitchCommand(value, commands.growLed);
+        } else if (name.equals("boost")) {
+            ok = parseSwitchCommand(value, commands.boost);
+        } else if (name.equals("rgb")) {
+            ok = parseSwitchCommand(value, commands.rgbLeds);
+        } else if (name.equals("brightness")) {
+            int brightness;
+            ok = value.toInt(brightness) && brightness >= 0 && brightness <= 100;
+            commands.brightness = ok ? (int8_t)brightness : -1;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            ArenaWriter error = arena.writer(96);
+            error.append("bad command: ");
+            error.append(name);
+            error.append('=');
+            error.append(value);
+            error.append('\n');
+            sendBody(400, "text/plain", error);
+            return;
+        }
+    }
+    // Through the queue so the batch merges with pending slider values, then
+    // applied right away: the reply carries the resulting state
+    commandQueue->post(commands);
+    commandQueue->applyTo(*devices);
+    
+    // New state, no redirect
+    ArenaWriter json = arena.writer(96);
+    json.appendf("{\"pump\":%d,\"grow_led\":%d,\"brightness\":%d,\"boost\":%d,\"rgb\":%d}",
+                 devices->getPumpState(), devices->getGrowLedState(), devices->getBrightness(),
+                 devices->getGrowLedBoostState(), devices->getRGBLedsEnabled());
+    server.sendHeader("Cache-Control", "no-store");
+    sendBody(200, "application/json", json);
+}
+
+void WebServerManager::handleStats() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    // {"dew_point":..,"vpd":..,"temperature":{"1m":{"n":..,"min":..,"max":..,"mean":..,"sd":..},"1h":..},..}
+    SensorStats& stats = sensors->getStats();
+    uint32_t now = millis();
+    ArenaWriter json = arena.writer(2048);
+    json.append('{');
+    float dewPoint = stats.getDewPoint();
+    float vpd = stats.getVpd();
+    if (dewPoint > SENSOR_NO_READING && vpd > SENSOR_NO_READING) {
+        json.appendf("\"dew_point\":%.2f,\"vpd\":%.3f", dewPoint, vpd);
+    } else {
+        json.append("\"dew_point\":null,\"vpd\":null");
+    }
+    for (int c = 0; c < (int)StatsChannel::COUNT; c++) {
+        StatsChannel channel = (StatsChannel)c;
+        int decimals = channel == StatsChannel::Vpd ? 3 : 2;
+        json.appendf(",\"%s\":{", SensorStats::channelName(channel));
+        for (int w = 0; w < (int)StatsWindow::COUNT; w++) {
+            StatsSummary s = stats.get(channel, (StatsWindow)w, now);
+            json.appendf("%s\"%s\":{\"n\":%lu", w ? "," : "", SensorStats::windowName((StatsWindow)w),
+                         (unsigned long)s.count);
+            if (s.count > 0) {
+                json.appendf(",\"min\":%.*f,\"max\":%.*f,\"mean\":%.*f,\"sd\":%.*f", decimals, s.min,
+                             decimals, s.max, decimals, s.mean, decimals, s.stddev);
+            }
+            json.append('}');
+        }
+        json.append('}');
+    }
+    json.append('}');
+    server.sendHeader("Cache-Control", "no-store");
+    sendBody(200, "application/json", json);
+}
+
+void WebServerManager::handleDebugDns() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    CaptiveDnsStats dns = dnsServer.getStats();
+    ArenaWriter body = arena.writer(256);
+    body.appendf("queries: %lu\nanswered: %lu\nempty_answers: %lu\ndropped: %lu\nsend_errors: %lu\n"
+             "queries_per_sec: %lu\npeak_queries_per_sec: %lu\nmax_batch: %lu\n",
+             (unsigned long)dns.queries, (unsigned long)dns.answered, (unsigned long)dns.emptyAnswers,
+             (unsigned long)dns.dropped, (unsigned long)dns.sendErrors,
+             (unsigned long)dns.queriesPerSecond, (unsigned long)dns.peakQueriesPerSecond,
+             (unsigned long)dns.maxBatch);
+    sendBody(200, "text/plain", body);
+}
+
+void WebServerManager::handleDebugScheduler() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 1664;
+    char* body = arena.alloc(size);
+    size_t length = 0;
+    if (body) {
+        length = scheduler->formatStats(body, size);
+        length += commandQueue->formatStats(body + length, size - length);
+    }
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugHeap() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    // Fragmentation = share of free memory not usable as one block
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    uint32_t fragmentation = freeHeap ? 100 - (uint32_t)((uint64_t)largestBlock * 100 / freeHeap) : 0;
+    
+    ArenaWriter body = arena.writer(384);
+    body.appendf("free_heap: %lu\nmin_free_heap: %lu\nlargest_free_block: %lu\nfragmentation_pct: %lu\n"
+                 "requests: %lu\narena_bytes: %u\narena_high_water: %u\narena_exhausted: %lu\n",
+                 (unsigned long)freeHeap, (unsigned long)ESP.getMinFreeHeap(),
+                 (unsigned long)largestBlock, (unsigned long)fragmentation,
+                 (unsigned long)arena.getResets(), (unsigned)arena.getCapacity(),
+                 (unsigned)arena.getHighWater(), (unsigned long)arena.getExhausted());
+    sendBody(200, "text/plain", body);
+}
+
+void WebServerManager::handleDebugBoot() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 2560;
+    char* body = arena.alloc(size);
+    size_t length = body ? BootProfiler::formatReport(body, size) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugI2c() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 1024;
+    char* body = arena.alloc(size);
+    size_t length = body ? sensors->formatDiagnostics(body, size) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugWifi() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 1536;
+    char* body = arena.alloc(size);
+    size_t length = body ? auth->getStation().formatReport(body, size) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugHttp() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 1024;
+    char* body = arena.alloc(size);
+    size_t length = body ? admission.formatStats(body, size, millis()) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugDeadline() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 1024;
+    char* body = arena.alloc(size);
+    size_t length = body ? DeadlineMonitor::formatReport(body, size) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugPump() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 768;
+    char* body = arena.alloc(size);
+    size_t length = body ? PumpGuard::formatReport(body, size) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+void WebServerManager::handleDebugAnomaly() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    if (!anomalies) {
+        server.send(404, "text/plain", "anomaly detection not running\n");
+        return;
+    }
+    
+    // POST clear=1 after fixing the cause: latched pump/leak alarms no longer
+    // block the pump. Not on GET, where a prefetch or a crawler could send it
+    if (server.method() == HTTP_POST && server.hasArg("clear")) {
+        anomalies->clearLatched();
+    }
+    const size_t size = 1024;
+    char* body = arena.alloc(size);
+    size_t length = body ? anomalies->formatReport(body, size, millis()) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+
+#if HTTPS_ENABLED
+void WebServerManager::handleDebugTls() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    const size_t size = 1024;
+    char* body = arena.alloc(size);
+    size_t length = body ? https.formatReport(body, size) : 0;
+    server.send_P(200, "text/plain", body ? body : "", length);
+}
+#endif
+
+#if TRACE_RECORDER_ENABLED
+void WebServerManager::handleDebugTrace() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    // Only a POST empties the ring; a GET always downloads it
+    if (server.method() == HTTP_POST && server.hasArg("clear")) {
+        uint32_t records = TraceRecorder::getRecordCount();
+        TraceRecorder::clear();
+        char body[48];
+        int length = snprintf(body, sizeof(body), "cleared %lu records\n", (unsigned long)records);
+        server.send_P(200, "text/plain", body, length);
+        return;
+    }
+    
+    // Binary download: header, then the ring in order (see TraceFormat.h)
+    TraceHeader header;
+    TraceRecorder::fillHeader(header, sensors->getCalibration(CalibrationSensor::Soil).get(),
+                              sensors->getCalibration(CalibrationSensor::Water).get());
+    const uint8_t* chunks[2];
+    size_t lengths[2];
+    TraceRecorder::getChunks(chunks, lengths);
+    server.setContentLength(sizeof(header) + lengths[0] + lengths[1]);
+    server.sendHeader("Content-Disposition", "attachment; filename=\"growbox.trace\"");
+    server.send(200, "application/octet-stream", "");
+    server.sendContent((const char*)&header, sizeof(header));
+    for (int i = 0; i < 2; i++) {
+        if (lengths[i] > 0) {
+            server.sendContent((const char*)chunks[i], lengths[i]);
+        }
+    }
+}
+#endif
+
+#if SOAK_TEST_MODE
+void WebServerManager::handleDebugSoak() {
+    if (!checkAuthentication() || !soakMonitor || !soakDriver) {
+        return;
+    }
+    
+    const size_t size = 2560;
+    char* body = arena.alloc(size);
+    if (!body) {
+        server.send(500);
+        return;
+    }
+    size_t length = soakMonitor->formatReport(body, size);
+    length += soakDriver->formatStatus(body + length, size - length);
+    server.send_P(200, "text/plain", body, length);
+}
+#endif
+
+void WebServerManager::handleCalibration() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    if (server.method() == HTTP_POST) {
+        const char* error = applyCalibrationAction();
+        if (error) {
+            ArenaWriter json = arena.writer(160);
+            json.append("{\"error\":\"");
+            json.append(error);
+            json.append("\"}");
+            sendBody(400, "application/json", json);
+            return;
+        }
+    }
+    
+    // Live raw readings make the guided flow self-explanatory; the soil read takes ~250ms
+    float temperature = sensors->readTemperature();
+    ArenaWriter json = arena.writer(1536);
+    json.append('{');
+    const CalibrationSensor channels[] = { CalibrationSensor::Soil, CalibrationSensor::Water };
+    for (CalibrationSensor channel : channels) {
+        const CalibrationCurve& curve = sensors->getCalibration(channel);
+        int raw = sensors->readRaw(channel);
+        int percent = curve.evaluate(raw, channel == CalibrationSensor::Soil ? temperature : -999.0f);
+        json.appendf("\"%s\":{\"raw\":%d,\"percent\":%d,", SensorManager::sensorName(channel), raw, percent);
+        appendCalibrationJson(json, curve.get());
+        json.append("},");
+    }
+    json.appendf("\"temperature\":%.1f,\"draft\":", temperature);
+    if (calibrationActive) {
+        json.appendf("{\"sensor\":\"%s\",", SensorManager::sensorName(calibrationSensor));
+        appendCalibrationJson(json, calibrationDraft);
+        json.append('}');
+    } else {
+        json.append("null");
+    }
+    json.append(",\"next\":\"");
+    json.append(calibrationHint());
+    json.append("\"}");
+    
+    server.sendHeader("Cache-Control", "no-store");
+    sendBody(200, "application/json", json);
+}
+
+void WebServerManager::appendCalibrationJson(ArenaWriter& json, const CalibrationData& data) {
+    json.appendf("\"mode\":\"%s\",\"temp_coeff_q8\":%d,\"temp_ref_c\":%d,\"points\":[",
+                 CalibrationCurve::modeName(data.mode), (int)data.tempCoeffQ8, (int)data.tempRefC);
+    for (uint8_t i = 0; i < data.pointCount; i++) {
+        json.appendf(i ? ",[%u,%u]" : "[%u,%u]", (unsigned)data.points[i].raw, (unsigned)data.points[i].percent);
+    }
+    json.append(']');
+}
+
+const char* WebServerManager::calibrationHint() const {
+    if (!calibrationActive) {
+        return "POST action=start&sensor=soil|water to begin";
+    }
+    bool soil = calibrationSensor == CalibrationSensor::Soil;
+    switch (calibrationDraft.pointCount) {
+        case 0:
+            return soil ? "Hold the probe in dry air, then POST action=capture&percent=0"
+                        : "Empty the tank, then POST action=capture&percent=0";
+        case 1:
+            return soil ? "Put the probe in water up to the line, then POST action=capture&percent=100"
+                        : "Fill the tank, then POST action=capture&percent=100";
+        default:
+            return "Capture more points (action=capture&percent=N), choose action=mode&value=spline, or POST action=save";
+    }
+}
+
+const char* WebServerManager::addCalibrationPoint(int raw, int percent) {
+    const CalibrationCurve& curve = sensors->getCalibration(calibrationSensor);
+    if (raw < 0 || raw > curve.getInputMax() || percent < 0 || percent > 100) {
+        return "raw or percent out of range";
+    }
+    // A second capture at the same raw value replaces the first
+    CalibrationData& d = calibrationDraft;
+    uint8_t i = 0;
+    while (i < d.pointCount && d.points[i].raw != raw) {
+        i++;
+    }
+    if (i == CAL_MAX_POINTS) {
+        return "too many points";
+    }
+    d.points[i].raw = (uint16_t)raw;
+    d.points[i].percent = (uint8_t)percent;
+    if (i == d.pointCount) {
+        d.pointCount++;
+    }
+    return nullptr;
+}
+
+const char* WebServerManager::applyCalibrationAction() {
+    StrView action = server.argView("action");
+    StrView sensorArg = server.argView("sensor");
+    CalibrationSensor sensor = calibrationSensor;
+    if (sensorArg.equals("soil")) {
+        sensor = CalibrationSensor::Soil;
+    } else if (sensorArg.equals("water")) {
+        sensor = CalibrationSensor::Water;
+    } else if (!sensorArg.empty() || (!calibrationActive && !action.equals("cancel"))) {
+        return "sensor must be soil or water";
+    }
+    
+    if (action.equals("start")) {
+        // Keep mode and temperature settings, collect fresh points
+        calibrationDraft = sensors->getCalibration(sensor).get();
+        calibrationDraft.pointCount = 0;
+        calibrationSensor = sensor;
+        calibrationActive = true;
+        return nullptr;
+    }
+    if (action.equals("reset")) {
+        sensors->resetCalibration(sensor);
+        if (calibrationActive && calibrationSensor == sensor) {
+            calibrationActive = false;
+        }
+        return nullptr;
+    }
+    if (action.equals("cancel")) {
+        calibrationActive = false;
+        return nullptr;
+    }
+    if (!calibrationActive || sensor != calibrationSensor) {
+        return "no calibration in progress for this sensor (action=start)";
+    }
+    
+    int percent;
+    int raw;
+    if (action.equals("capture")) {
+        if (!server.argView("percent").toInt(percent)) {
+            return "percent required";
+        }
+        // Points are kept at the reference temperature
+        raw = sensors->readRaw(sensor);
+        if (sensor == CalibrationSensor::Soil) {
+            raw = CalibrationCurve::compensate(calibrationDraft, raw, sensors->readTemperature());
+        }
+        Serial.printf("Calibration: %s raw %d captured as %d%%\n", SensorManager::sensorName(sensor), raw, percent);
+        return addCalibrationPoint(raw, percent);
+    }
+    if (action.equals("point")) {
+        if (!server.argView("raw").toInt(raw) || !server.argView("percent").toInt(percent)) {
+            return "raw and percent required";
+        }
+        return addCalibrationPoint(raw, percent);
+    }
+    if (action.equals("mode")) {
+        StrView value = server.argView("value");
+        if (value.equals("linear")) {
+            calibrationDraft.mode = CalibrationMode::Linear;
+        } else if (value.equals("spline")) {
+            calibrationDraft.mode = CalibrationMode::Spline;
+        } else {
+            return "value must be linear or spline";
+        }
+        return nullptr;
+    }
+    if (action.equals("temp")) {
+        int coeff;
+        int ref;
+        if (!server.argView("coeff_q8").toInt(coeff) || coeff < INT16_MIN || coeff > INT16_MAX) {
+            return "coeff_q8 required";
+        }
+        calibrationDraft.tempCoeffQ8 = (int16_t)coeff;
+        if (server.argView("ref_c").toInt(ref) && ref >= -40 && ref <= 80) {
+            calibrationDraft.tempRefC = (int8_t)ref;
+        }
+        return nullptr;
+    }
+    if (action.equals("save")) {
+        if (!sensors->setCalibration(sensor, calibrationDraft)) {
+            return "invalid curve: need 2 or more points with distinct raw values";
+        }
+        calibrationActive = false;
+        return nullptr;
+    }
+    return "unknown action";
+}
+
 void WebServerManager::handleNotFound() {
     // Serve login page for any unknown URL - triggers captive portal popup on devices
     if (auth->isUserAuthenticated()) {
         server.sendHeader("Location", "/dashboard", true);
         server.send(302, "text/plain", "");
     } else {
-        String loginPage = auth->getLoginPageHTML();
-        server.send(200, "text/html", loginPage);
+        sendLoginPage();
     }
 }
 
@@ -281,39 +1025,36 @@ void WebServerManager::handleSimulation() {
         return;
     }
     
-    if (server.hasArg("temperature")) {
-        float temp = server.arg("temperature").toFloat();
-        sensors->setSimulatedTemperature(temp);
+    float temp;
+    if (server.argView("temperature").toFloat(temp)) {
+        sensors->backend().setTemperature(temp);
         Serial.print("Simulated Temperature set to: ");
         Serial.println(temp);
     }
     
-    if (server.hasArg("humidity")) {
-        float hum = server.arg("humidity").toFloat();
-        sensors->setSimulatedHumidity(hum);
+    float hum;
+    if (server.argView("humidity").toFloat(hum)) {
+        sensors->backend().setHumidity(hum);
         Serial.print("Simulated Humidity set to: ");
         Serial.println(hum);
     }
     
-    if (server.hasArg("soil")) {
-        int soil = server.arg("soil").toInt();
-        sensors->setSimulatedSoilPercentage(soil);
+    int soil;
+    if (server.argView("soil").toInt(soil)) {
+        sensors->backend().setSoilPercentage(soil);
         Serial.print("Simulated Soil Moisture set to: ");
         Serial.println(soil);
-        // Update RGB LED color immediately
-        devices->updateSoilMoistureColor(soil);
     }
     
-    if (server.hasArg("water")) {
-        int water = server.arg("water").toInt();
-        sensors->setSimulatedWaterPercentage(water);
+    int water;
+    if (server.argView("water").toInt(water)) {
+        sensors->backend().setWaterPercentage(water);
         Serial.print("Simulated Water Level set to: ");
         Serial.println(water);
-        // Update RGB LED color immediately
-        devices->updateWaterLevelColor(water);
     }
     
-    server.send(200, "text/plain", "Simulation values updated");
+    // The LEDs follow on the next sensor cycle; handlers leave the pins to the loop
+    server.send_P(200, "text/plain", "Simulation values updated");
 }
 #endif
 
@@ -321,9 +1062,157 @@ void WebServerManager::handleFavicon() {
     server.send(204);
 }
 
+void WebServerManager::handleCaptiveRedirect() {
+    server.sendHeader("Location", "http://192.168.4.1/", true);
+    server.send(302, "text/plain", "");
+}
+
+#if HTTPS_ENABLED
+static bool isHostChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '-';
+}
+
+static void appendUrlEncoded(ArenaWriter& out, const StrView& text) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (size_t i = 0; i < text.length; i++) {
+        char c = text.data[i];
+        if (isHostChar(c) || c == '_' || c == '~') {
+            out.append(c);
+        } else {
+            out.append('%');
+            out.append(hex[(uint8_t)c >> 4]);
+            out.append(hex[(uint8_t)c & 0x0F]);
+        }
+    }
+}
+
+void WebServerManager::redirectToHttps(HTTPMethod method) {
+    // The name the client used when it is a plain host name or address, else
+    // the address it connected to
+    ArenaWriter location = arena.writer(384);
+    location.append("https://");
+    String host = server.hostHeader();
+    int colon = host.indexOf(':');
+    size_t length = colon >= 0 ? (size_t)colon : host.length();
+    bool usable = length > 0 && length <= 64;
+    for (size_t i = 0; usable && i < length; i++) {
+        usable = isHostChar(host[i]);
+    }
+    if (usable) {
+        location.append(host.c_str(), length);
+    } else {
+        IPAddress ip = server.client().localIP();
+        location.appendf("%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    }
+    location.appendf(":%d", HTTPS_PORT);
+    location.append(server.uri().c_str());
+    // GET arguments are the query string; other methods keep their body
+    // across a 307, so only the path is needed
+    if (method == HTTP_GET) {
+        for (int i = 0; i < server.argViewCount(); i++) {
+            location.append(i == 0 ? '?' : '&');
+            appendUrlEncoded(location, server.argNameView(i));
+            location.append('=');
+            appendUrlEncoded(location, server.argValueView(i));
+        }
+    }
+    if (location.overflowed()) {
+        server.send(414, "text/plain", "URI too long\n");
+        return;
+    }
+    server.sendHeader("Location", location.c_str(), true);
+    server.send(method == HTTP_GET ? 302 : 307, "text/plain", "");
+}
+#endif
+
+void WebServerManager::handleDebugRoutes() {
+    if (!checkAuthentication()) {
+        return;
+    }
+    
+    uint32_t resolved = routeStats.requests ? routeStats.requests : 1;
+    ArenaWriter body = arena.writer(320);
+    body.appendf("routes: %d\nslots: %d\ndispatch_ram_bytes: %d\n"
+             "requests: %lu\nnot_found: %lu\n"
+             "resolve_cycles_last: %lu\nresolve_cycles_avg: %lu\nresolve_cycles_max: %lu\n"
+             "handler_us_max: %lu\n",
+             (int)Routes::COUNT, ROUTE_SLOT_COUNT,
+             (int)(sizeof(Routes::TABLE) + sizeof(Routes::SLOTS) + sizeof(RouteDispatcher)),
+             (unsigned long)routeStats.requests, (unsigned long)routeStats.notFound,
+             (unsigned long)routeStats.lastResolveCycles,
+             (unsigned long)(routeStats.totalResolveCycles / resolved),
+             (unsigned long)routeStats.maxResolveCycles,
+             (unsigned long)routeStats.maxHandlerMicros);
+    sendBody(200, "text/plain", body);
+}
+
+int WebServerManager::findListener(uint16_t port) {
+    for (int fd = LWIP_SOCKET_OFFSET; fd < LWIP_SOCKET_OFFSET + CONFIG_LWIP_MAX_SOCKETS; fd++) {
+        int listening = 0;
+        socklen_t length = sizeof(listening);
+        struct sockaddr_in addr;
+        socklen_t addrLength = sizeof(addr);
+        if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &length) == 0 && listening &&
+            getsockname(fd, (struct sockaddr*)&addr, &addrLength) == 0 && ntohs(addr.sin_port) == port) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+void WebServerManager::readinessEntry(void* arg) {
+    static_cast<WebServerManager*>(arg)->watchSockets();
+}
+
+void WebServerManager::watchSockets() {
+    for (;;) {
+        // The loop task only touches the sockets inside handleClient(), and this
+        // task waits for that to finish before selecting again
+        int client = clientFd;
+        fd_set readable;
+        FD_ZERO(&readable);
+        int maxFd = -1;
+        if (listenFd >= 0) {
+            FD_SET(listenFd, &readable);
+            maxFd = listenFd;
+        }
+        if (client >= 0) {
+            FD_SET(client, &readable);
+            maxFd = client > maxFd ? client : maxFd;
+        }
+        // While a client is open WebServer's own timeouts (request data, close
+        // wait) only advance in handleClient(), so it also runs on a tick;
+        // with no client the task sleeps until a connection arrives
+        bool ticking = client >= 0 || listenFd < 0;
+        uint32_t waitMs = ticking ? WEB_CLIENT_TICK_MS : 1000;
+        struct timeval timeout = { (time_t)(waitMs / 1000), (suseconds_t)((waitMs % 1000) * 1000) };
+        int ready = maxFd >= 0 ? select(maxFd + 1, &readable, nullptr, nullptr, &timeout) : 0;
+        if (ready < 0) {
+            vTaskDelay(pdMS_TO_TICKS(WEB_CLIENT_TICK_MS));   // a socket closed under us; reread clientFd
+        } else if (ready == 0 && maxFd >= 0 && !ticking) {
+            continue;
+        } else if (ready == 0 && maxFd < 0) {
+            vTaskDelay(pdMS_TO_TICKS(WEB_CLIENT_TICK_MS));
+        }
+        scheduler->notify(httpJob);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));   // until handleClient() has run
+    }
+}
+
 void WebServerManager::handleClient() {
-    dnsServer.processNextRequest();
     server.handleClient();
+    clientFd = server.clientFd();
+    if (readinessTask) {
+        xTaskNotifyGive(readinessTask);
+    }
+}
+
+void WebServerManager::updateNetwork() {
+    // Advance WiFi provisioning and background scans; sync time once the STA link comes up
+    if (auth->updateProvisioning()) {
+        initTime();
+    }
+    auth->updateNetworkScan();
 }
 
 void WebServerManager::initTime() {
@@ -333,11 +1222,12 @@ void WebServerManager::initTime() {
     if (WiFi.status() == WL_CONNECTED) {
         configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
         Serial.println("NTP sync started (STA mode)");
+        // Don't wait for the SNTP reply - it arrives in the background
         struct tm timeinfo;
-        if (getLocalTime(&timeinfo)) {
+        if (getLocalTime(&timeinfo, 0)) {
             Serial.println(&timeinfo, "Current time: %Y-%m-%d %H:%M:%S");
         } else {
-            Serial.println("Failed to obtain time from NTP");
+            Serial.println("NTP time not available yet");
         }
     } else {
         Serial.println("Skipping NTP sync (AP-only mode, no internet)");
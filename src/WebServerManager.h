@@ -3,41 +3,164 @@
 
 #include <WiFi.h>
 #include <WebServer.h>
-#include <DNSServer.h>
-#include <uri/UriBraces.h>
 #include "Config.h"
+#include "Routes.h"
+#include "CaptiveDns.h"
 #include "SensorManager.h"
 #include "DeviceController.h"
 #include "AuthManager.h"
+#include "Scheduler.h"
+#include "ActuatorCommandQueue.h"
+#include "RequestArena.h"
+#include "HttpAdmission.h"
+#include "AnomalyDetector.h"
+#if HTTPS_ENABLED
+#include "HttpsProxy.h"
+#endif
+#if SOAK_TEST_MODE
+#include "SoakMonitor.h"
+#include "SoakDriver.h"
+#endif
+
+// Dispatch cost counters for /debug/routes
+struct RouteStats {
+    uint32_t requests;
+    uint32_t notFound;
+    uint32_t lastResolveCycles;
+    uint32_t maxResolveCycles;
+    uint64_t totalResolveCycles;
+    uint32_t maxHandlerMicros;
+};
 
 class WebServerManager {
 private:
-    WebServer server;
-    DNSServer dnsServer;
+    // WebServer with in-place access to the parsed arguments: server.arg()
+    // returns a fresh String copy per call, argView() points into the request.
+    class Server : public WebServer {
+    public:
+        using WebServer::WebServer;
+        StrView argView(const char* name) const;
+        bool hasArgView(const char* name) const;
+        // All arguments by position, POST body first
+        int argViewCount() const { return _postArgsLen + _currentArgCount; }
+        StrView argNameView(int index) const;
+        StrView argValueView(int index) const;
+        // Socket of the connection handleClient() is serving, -1 between requests
+        int clientFd() const { return _currentClient.fd(); }
+    };
+    
+    // The only RequestHandler registered with WebServer: resolves the URI once
+    // against the compile-time route table (see Routes.h) and dispatches.
+    class RouteDispatcher : public RequestHandler {
+    public:
+        explicit RouteDispatcher(WebServerManager* owner) : owner(owner), match{RouteId::NotFound, 0} {}
+        bool canHandle(HTTPMethod method, String uri) override;
+        bool handle(WebServer& server, HTTPMethod requestMethod, String requestUri) override;
+    private:
+        WebServerManager* owner;
+        RouteMatch match;
+    };
+    
+    Server server;
+    RequestArena arena;    // reset before every request
+    CaptiveDnsServer dnsServer;
+#if HTTPS_ENABLED
+    HttpsProxy https;           // TLS on HTTPS_PORT, forwarded to this server over loopback
+#endif
     SensorManager* sensors;
     DeviceController* devices;
     AuthManager* auth;
+    Scheduler* scheduler;
+    ActuatorCommandQueue* commandQueue;    // web commands, applied by the control loop
+    RouteStats routeStats;
+    
+    // Readiness: a task select()s on the listener and the open client and
+    // notifies httpJob, so the loop runs handleClient() only when there is work
+    JobId httpJob;
+    TaskHandle_t readinessTask;
+    int listenFd;
+    volatile int clientFd;      // set by the loop task after each handleClient()
+    HttpAdmission admission;    // per-client and global request budgets
+    AnomalyDetector* anomalies; // owned by the control loop, for /debug/anomaly
     
+    // Guided calibration in progress (/calibration); applied on action=save
+    CalibrationData calibrationDraft;
+    CalibrationSensor calibrationSensor;
+    bool calibrationActive;
+#if HTTPS_ENABLED
+    SettingsStore* settings;    // keeps the TLS identity
+#endif
+#if SOAK_TEST_MODE
+    SoakMonitor* soakMonitor;
+    SoakDriver* soakDriver;
+#endif
+    
+    static int findListener(uint16_t port);
+    static void readinessEntry(void* arg);
+    void watchSockets();
+    void dispatch(RouteId route, int param);
+    void sendBody(int code, const char* contentType, const ArenaWriter& body);
     bool checkAuthentication();
     void handleRoot();
+    void sendLoginPage();
     void handleLogin();
     void handleConnect();
+    void handleConnectStatus();
     void handleScanNetworks();
     void handleDashboard();
-    void handleToggle();
-    void handleBrightness();
+    void handleToggle(int button);
+    void handleBrightness(int brightness);
+    void handleCommands();
+    void handleStats();
 #if SIMULATION_MODE
     void handleSimulation();
 #endif
     void handleNotFound();
     void handleFavicon();
+    void handleCaptiveRedirect();
+    void handleCalibration();
+    const char* applyCalibrationAction();
+    const char* addCalibrationPoint(int raw, int percent);
+    void appendCalibrationJson(ArenaWriter& json, const CalibrationData& data);
+    const char* calibrationHint() const;
+    void handleDebugRoutes();
+    void handleDebugDns();
+    void handleDebugScheduler();
+    void handleDebugHeap();
+    void handleDebugBoot();
+    void handleDebugI2c();
+    void handleDebugWifi();
+    void handleDebugHttp();
+    void handleDebugDeadline();
+    void handleDebugPump();
+    void handleDebugAnomaly();
+#if TRACE_RECORDER_ENABLED
+    void handleDebugTrace();
+#endif
+#if HTTPS_ENABLED
+    void handleDebugTls();
+    void redirectToHttps(HTTPMethod method);
+#endif
+#if SOAK_TEST_MODE
+    void handleDebugSoak();
+#endif
     
 public:
-    WebServerManager(SensorManager* sensorManager, DeviceController* deviceController, AuthManager* authManager);
+    WebServerManager(SensorManager* sensorManager, DeviceController* deviceController,
+                     AuthManager* authManager, Scheduler* jobScheduler, ActuatorCommandQueue* actuatorQueue);
+    void setHttpJob(JobId job) { httpJob = job; }   // before begin()
     void begin();
-    void handleClient();
+    void handleClient();     // HTTP only; run by httpJob
+    void updateNetwork();    // provisioning + background scans
     
     static void initTime();
+    void setAnomalyDetector(AnomalyDetector* detector) { anomalies = detector; }
+#if HTTPS_ENABLED
+    void setSettingsStore(SettingsStore* store) { settings = store; }
+#endif
+#if SOAK_TEST_MODE
+    void setSoak(SoakMonitor* monitor, SoakDriver* driver) { soakMonitor = monitor; soakDriver = driver; }
+#endif
 };
 
 #endif // WEBSERVERMANAGER_H
@@ -5,109 +5,347 @@
 #include "DeviceController.h"
 #include "AuthManager.h"
 #include "WebServerManager.h"
+#include "Scheduler.h"
+#include "ActuatorCommandQueue.h"
+#include "SettingsStore.h"
+#include "BootProfiler.h"
+#include "DeadlineMonitor.h"
+#include "PumpGuard.h"
+#include "AnomalyDetector.h"
+#include "TraceRecorder.h"
+#include "PumpPolicy.h"
+#if TELEMETRY_ENABLED
+#include "TelemetryManager.h"
+#endif
+#if SOAK_TEST_MODE
+#include "SoakMonitor.h"
+#include "SoakDriver.h"
+#endif
 
 // Create instances of our managers
+Scheduler scheduler;
+SettingsStore settings;
 SensorManager sensors;
 DeviceController devices;
 AuthManager auth("admin", "password123");  // Default credentials
-WebServerManager webServer(&sensors, &devices, &auth);
+ActuatorCommandQueue commandQueue;
+AnomalyDetector anomalies;
+WebServerManager webServer(&sensors, &devices, &auth, &scheduler, &commandQueue);
+#if TELEMETRY_ENABLED
+TelemetryManager telemetry;
+#endif
+#if SOAK_TEST_MODE
+SoakMonitor soakMonitor;
+SoakDriver soakDriver(&soakMonitor, &scheduler, &devices, &auth);
+#endif
+
+// Latest readings from the sensor job, shared with the LED and log jobs
+struct SensorSnapshot {
+    bool valid;
+    float temperature;
+    float humidity;
+    int soilPercentage;
+    int waterPercentage;
+};
+SensorSnapshot latest = { false, -999.0f, -999.0f, 0, 0 };
+
+JobId buttonJob = SCHEDULER_NO_JOB;
+JobId networkJob = SCHEDULER_NO_JOB;
+JobId sensorJob = SCHEDULER_NO_JOB;
+JobId pumpGuardJob = SCHEDULER_NO_JOB;
+
+// Set by the network init task once the AP and web server are up
+volatile bool networkReady = false;
+bool staConnectLogged = false;
+
+// Boot is complete once the web server answers and the first reading is in
+void checkBootComplete() {
+    if (networkReady && latest.valid) {
+        BootProfiler::finish();
+    }
+}
+
+// Button edges only wake the loop; debouncing stays in checkButton()
+void IRAM_ATTR onButtonEdge() {
+    scheduler.notifyFromISR(buttonJob);
+}
+
+// The relay is already off; the job brings DeviceController up to date
+void IRAM_ATTR onPumpCutoff() {
+    scheduler.notifyFromISR(pumpGuardJob);
+}
+
+void handleButton() {
+    bool pressed = devices.checkButton();
+    TraceRecorder::recordButton(digitalRead(BUTTON_PIN), pressed);
+    if (pressed) {
+        devices.togglePump();
+        Serial.print("Pump State: ");
+        Serial.println(devices.getPumpState() ? "ON" : "OFF");
+    }
+}
+
+void runSensorCycle() {
+    bool firstReading = !latest.valid;
+    if (firstReading) {
+        BootProfiler::start("first-reading");
+    }
+    
+    // Read all sensors (the climate sensor converts on its own, this fetches
+    // its latest sample); the I2C part of the cycle is time-boxed by I2C_CYCLE_BUDGET_MS.
+    // Each phase has a deadline (DeadlineMonitor.h).
+    DeadlineMonitor::startCycle();
+    sensors.beginCycle();
+    DeadlineMonitor::phase(ControlPhase::Climate);
+    sensors.measureClimate();
+    latest.temperature = sensors.readTemperature();
+    latest.humidity = sensors.readHumidity();
+    // Read water first to avoid interference from soil sensor
+    DeadlineMonitor::phase(ControlPhase::Water);
+    latest.waterPercentage = sensors.getWaterPercentage();
+    sensors.endCycle();
+    DeadlineMonitor::phase(ControlPhase::Soil);
+    latest.soilPercentage = sensors.getSoilPercentage();
+    sensors.updateStats(millis());
+    latest.valid = true;
+    if (firstReading) {
+        BootProfiler::end("first-reading");
+        checkBootComplete();
+    }
+    
+    int waterPercentage = latest.waterPercentage;
+    int soilPercentage = latest.soilPercentage;
+    
+    // Plausibility checks first, so an alarm stops the pump in this cycle
+    DeadlineMonitor::phase(ControlPhase::Pump);
+    AnomalySample sample = { (uint32_t)millis(), devices.getPumpState(), soilPercentage, sensors.getLastSoilRaw(),
+                             waterPercentage, latest.temperature, latest.humidity };
+    uint32_t raised = anomalies.update(sample);
+    for (int k = 0; k < (int)AnomalyKind::COUNT; k++) {
+        if (raised & (1u << k)) {
+            Serial.printf(">>> ANOMALY: %s%s\n", AnomalyDetector::kindName((AnomalyKind)k),
+                          ANOMALY_BLOCKS_PUMP && (ANOMALY_BLOCKING & (1u << k)) ? " - pump blocked" : "");
+        }
+    }
+    
+    // Pump control logic (priority order, see PumpPolicy.h)
+    PumpAction action = decidePump(soilPercentage, waterPercentage, devices.getPumpState(),
+                                   ANOMALY_BLOCKS_PUMP && anomalies.blocksPump());
+    if (action != PumpAction::None) {
+        TraceRecorder::recordDecision(action);
+        devices.setPumpState(pumpActionState(action, devices.getPumpState()));
+    }
+    switch (action) {
+        case PumpAction::StopWaterLow:
+            Serial.printf(">>> AUTO-STOP: Water level too low (<= %d%%) - PUMP PROTECTION\n", PUMP_WATER_MIN_PCT);
+            break;
+        case PumpAction::StopSoilWet:
+            Serial.printf(">>> AUTO-STOP: Soil moisture >= %d%% (WET - GREEN LED)\n", PUMP_SOIL_WET_PCT);
+            break;
+        case PumpAction::StartSoilDry:
+            Serial.printf(">>> AUTO-START: Soil moisture < %d%% (DRY - RED LED)\n", PUMP_SOIL_DRY_PCT);
+            break;
+        case PumpAction::StopAnomaly:
+            Serial.println(">>> AUTO-STOP: Sensor or pump anomaly (see /debug/anomaly)");
+            break;
+        default:
+            break;
+    }
+    TraceRecorder::recordCycle();
+
+#if TELEMETRY_ENABLED
+    // Queue a frame with the post-decision actuator state
+    telemetry.recordSample(latest.temperature, latest.humidity, soilPercentage, waterPercentage, devices);
+#endif
+    // Only a completed cycle feeds the control watchdog
+    DeadlineMonitor::completeCycle();
+}
+
+void refreshLeds() {
+    if (!latest.valid) {
+        return;
+    }
+    devices.updateSoilMoistureColor(latest.soilPercentage);
+    devices.updateWaterLevelColor(latest.waterPercentage);
+}
+
+void logReadings() {
+    if (!latest.valid) {
+        return;
+    }
+    Serial.println("=== Sensor Reading ===");
+    if (latest.temperature <= -998.0f)
+        Serial.println("Temperature: N/A (no climate sensor)");
+    else
+        Serial.printf("Temperature: %.1f C, Humidity: %.1f%%, Dew point: %.1f C, VPD: %.2f kPa\n",
+                      latest.temperature, latest.humidity, sensors.getStats().getDewPoint(), sensors.getStats().getVpd());
+    Serial.printf("Soil: %d%%, Water: %d%%\n", latest.soilPercentage, latest.waterPercentage);
+    Serial.printf("Pump: %s\n", devices.getPumpState() ? "ON" : "OFF");
+}
+
+void resyncTime() {
+    if (WiFi.status() == WL_CONNECTED) {
+        WebServerManager::initTime();
+    }
+}
 
-// Automatic sensor reading timing
-unsigned long lastSensorReadTime = 0;
+void updateNetwork() {
+    if (!networkReady) {
+        return;
+    }
+    checkBootComplete();
+    webServer.updateNetwork();
+    if (!staConnectLogged && auth.getStation().getState() == StationState::Connected) {
+        staConnectLogged = true;
+        BootProfiler::mark("sta-connected");
+    }
+}
+
+void applyStoredSettings() {
+    // The pump is never restored - it always boots OFF
+    const DeviceSettings& stored = settings.getDeviceSettings();
+    if (stored.growLed) {
+        devices.setGrowLedState(true);
+        devices.updateGrowLEDBrightness(stored.brightness);
+        if (stored.growLedBoost) {
+            devices.setGrowLedBoostState(true);
+        }
+    }
+    if (!stored.rgbLeds) {
+        devices.setRGBLedsEnabled(false);
+    }
+}
+
+void persistSettings() {
+    // Keep the last "on" brightness while the grow LED is off
+    DeviceSettings current = settings.getDeviceSettings();
+    current.growLed = devices.getGrowLedState();
+    current.growLedBoost = devices.getGrowLedBoostState();
+    current.rgbLeds = devices.getRGBLedsEnabled();
+    if (current.growLed) {
+        current.brightness = devices.getBrightness();
+    }
+    settings.setDeviceSettings(current);
+    if (settings.save()) {
+        Serial.println("Device settings saved");
+    }
+}
+
+// AP bring-up, stored-network reconnect and web server start run here, in
+// parallel with sensor init on the loop task
+void networkInitTask(void* arg) {
+    {
+        BootProfiler::Scope phase("access-point");
+        AuthManager::initAccessPoint();
+    }
+    
+    // STA join of the stored networks (cached BSSID/channel first); the scan is
+    // deferred until the join settles. "wifi-scan" ends when AuthManager collects the results.
+    auth.reconnectStored();
+    BootProfiler::start("wifi-scan");
+    auth.requestNetworkScan();
+    
+    {
+        BootProfiler::Scope phase("web-begin");
+        webServer.begin();
+    }
+    
+    networkReady = true;
+    scheduler.notify(networkJob);
+    vTaskDelete(nullptr);
+}
 
 void setup() {
+    BootProfiler::begin();
+    BootProfiler::start("serial");
     Serial.begin(115200);
-    delay(2000);  // 2s - gives time for serial monitor to connect
+#if SERIAL_WAIT_MS > 0
+    // Optional wait for a USB serial monitor; boot no longer stalls by default
+    unsigned long serialWaitStart = millis();
+    while (!Serial && millis() - serialWaitStart < SERIAL_WAIT_MS) {
+        delay(10);
+    }
+#endif
     
     Serial.println("\n=================================");
     Serial.println("GrowBox System Starting...");
     Serial.println("=================================\n");
+    BootProfiler::end("serial");
+    DeadlineMonitor::begin();   // reports what hung if the watchdog reset us
+    
+    // Actuators first so relays are in a known state, then restore saved settings
+    TraceRecorder::begin();
+    {
+        BootProfiler::Scope phase("devices");
+        devices.begin();
+    }
+    {
+        BootProfiler::Scope phase("settings");
+        settings.begin();
+        applyStoredSettings();
+        auth.setSettingsStore(&settings);
+        sensors.setSettingsStore(&settings);   // calibration curves load in sensors.begin()
+        sensors.setLog([](const char* message) { Serial.println(message); });
+#if HTTPS_ENABLED
+        webServer.setSettingsStore(&settings); // TLS identity
+#endif
+    }
     
-    // Initialize all components
-    sensors.begin();
-    devices.begin();
+    // Register jobs; registration order is run order when several are due together.
+    // The control loop starts with the first reading; network jobs idle until
+    // networkInitTask has brought the AP up.
+    scheduler.begin();
+    buttonJob = scheduler.addEvent("button", handleButton);
+    pumpGuardJob = scheduler.addEvent("pump-guard", []() { devices.syncPumpGuard(); });
+    networkJob = scheduler.addPeriodic("network", NETWORK_POLL_INTERVAL_MS, updateNetwork);
+    // Woken by the web server's readiness task when a socket is ready
+    webServer.setHttpJob(scheduler.addEvent("http", []() { webServer.handleClient(); }));
+    scheduler.addPeriodic("actuators", ACTUATOR_APPLY_INTERVAL_MS, []() { commandQueue.applyTo(devices); });
+#if AUTO_SENSOR_INTERVAL > 0
+    sensorJob = scheduler.addPeriodic("sensors", AUTO_SENSOR_INTERVAL, runSensorCycle);
+    scheduler.addPeriodic("leds", LED_REFRESH_INTERVAL_MS, refreshLeds);
+    scheduler.addPeriodic("log", LOG_INTERVAL_MS, logReadings);
+#endif
+    scheduler.addPeriodic("ntp", NTP_RESYNC_INTERVAL_MS, resyncTime, NTP_RESYNC_INTERVAL_MS);
+    scheduler.addPeriodic("settings", SETTINGS_SAVE_INTERVAL_MS, persistSettings, SETTINGS_SAVE_INTERVAL_MS);
     
-    // Initialize RGB LED colors based on initial sensor readings
-    // Read water first to avoid interference from soil sensor
-    int initialWater = sensors.getWaterPercentage();
-    int initialSoil = sensors.getSoilPercentage();
-    devices.updateSoilMoistureColor(initialSoil);
-    devices.updateWaterLevelColor(initialWater);
-    Serial.printf("Initial RGB colors set - Soil: %d%%, Water: %d%%\n", initialSoil, initialWater);
+    // WiFi connect/disconnect/scan-done and button edges wake the loop immediately
+    auth.setWiFiEventCallback([]() { scheduler.notify(networkJob); });
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButtonEdge, CHANGE);
     
-    // Initialize Access Point for initial setup
-    AuthManager::initAccessPoint();
+    webServer.setAnomalyDetector(&anomalies);
     
-    // Scan for available networks
-    auth.scanNetworks();
+    // Pump runtime limits run on a timer interrupt, whatever the loop is doing
+    PumpGuard::begin(onPumpCutoff);
     
-    // Start web server
-    webServer.begin();
+    // WiFi runs on core 0; sensor init (I2C) proceeds here at the same time
+    xTaskCreatePinnedToCore(networkInitTask, "netinit", 4096, nullptr, 1, nullptr, 0);
+    {
+        BootProfiler::Scope phase("sensors");
+        sensors.begin();
+    }
+    
+#if SOAK_TEST_MODE
+    // Baseline after everything above has allocated its long-lived state
+    soakMonitor.begin();
+    scheduler.attachSoakMonitor(&soakMonitor);
+    webServer.setSoak(&soakMonitor, &soakDriver);
+    soakDriver.begin(sensorJob, buttonJob);
+    scheduler.addPeriodic("soak", SOAK_MINUTE_MS, []() { soakDriver.step(); });
+#endif
     
     Serial.println("\n=================================");
-    Serial.println("System Ready!");
+    Serial.println(settings.hasCredentials() ? "System Ready! (reconnecting to stored WiFi)" : "System Ready!");
     Serial.println("1. Connect to WiFi: GrowBox_Setup (Open Network)");
     Serial.println("2. Open browser: http://192.168.4.1");
     Serial.println("3. Configure WiFi and set password");
     Serial.println("=================================\n");
+    
+    // setup() runs on the loop task: from here a hung loop resets the chip
+    DeadlineMonitor::armWatchdog();
 }
 
 void loop() {
-    // Check and handle button press
-    if (devices.checkButton()) {
-        devices.togglePump();
-        Serial.print("Pump State: ");
-        Serial.println(devices.getPumpState() ? "ON" : "OFF");
-    }
-
-#if AUTO_SENSOR_INTERVAL > 0
-    // Periodic automatic sensor reading
-    unsigned long currentTime = millis();
-    if (currentTime - lastSensorReadTime >= AUTO_SENSOR_INTERVAL) {
-        lastSensorReadTime = currentTime;
-        
-        // Read all sensors (measure ENS210 once to avoid double 130ms blocking)
-        sensors.measureENS210();
-        float temperature = sensors.readTemperature();
-        float humidity = sensors.readHumidity();
-        // Read water first to avoid interference from soil sensor
-        int waterPercentage = sensors.getWaterPercentage();
-        int soilPercentage = sensors.getSoilPercentage();
-        
-        // Update RGB LED colors
-        devices.updateSoilMoistureColor(soilPercentage);
-        devices.updateWaterLevelColor(waterPercentage);
-        
-        // Log readings
-        Serial.println("=== Sensor Reading ===");
-        if (temperature <= -998.0f)
-            Serial.println("Temperature: N/A (ENS210 not found)");
-        else
-            Serial.printf("Temperature: %.1f C, Humidity: %.1f%%\n", temperature, humidity);
-        Serial.printf("Soil: %d%%, Water: %d%%\n", soilPercentage, waterPercentage);
-        Serial.printf("Pump: %s\n", devices.getPumpState() ? "ON" : "OFF");
-        
-        // Pump control logic (priority order)
-        
-        // 1. SAFETY: Auto-stop pump if water runs out (highest priority!)
-        if (waterPercentage <= 10 && devices.getPumpState()) {
-            devices.setPumpState(false);
-            Serial.println(">>> AUTO-STOP: Water level too low (<= 10%) - PUMP PROTECTION");
-        }
-        // 2. Auto-stop pump as soon as soil turns GREEN (>= 60%)
-        else if (soilPercentage >= 60 && devices.getPumpState()) {
-            devices.setPumpState(false);
-            Serial.println(">>> AUTO-STOP: Soil moisture >= 60% (WET - GREEN LED)");
-        }
-        // 3. Auto-start pump if soil is too dry (RED, < 20%) and water is available
-        else if (soilPercentage < 20 && waterPercentage > 10 && !devices.getPumpState()) {
-            devices.setPumpState(true);
-            Serial.println(">>> AUTO-START: Soil moisture < 20% (DRY - RED LED)");
-        }
-    }
-#endif
-
-    // Handle client requests
-    webServer.handleClient();
-    delay(2);
+    // Runs whatever is due, then blocks until the next deadline or event
+    scheduler.run();
 }
@@ -0,0 +1,128 @@
+// Host-side check of the web server's admission control.
+//
+// Build (Linux/macOS):
+//   g++ -O2 -std=c++11 -Isrc -o http_admission_check tools/http_admission_check.cpp src/HttpAdmission.cpp
+//
+// Usage:
+//   http_admission_check
+//
+// Drives HttpAdmission (src/HttpAdmission.h) with the traffic the firmware
+// sees: the soak driver over loopback at its full rate, a browser loading the
+// dashboard, a script hammering one route and many clients at once, and
+// checks what is accepted, what is shed and the Retry-After it reports.
+//
+// Exit status is 1 when any check failed.
+
+#include <stdio.h>
+#include <string.h>
+#include "HttpAdmission.h"
+
+namespace {
+
+int failures = 0;
+int checks = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void check(bool ok, const char* what, int line) {
+    checks++;
+    if (!ok) {
+        failures++;
+        printf("FAIL line %d: %s\n", line, what);
+    }
+}
+
+// IPAddress layout: first octet in the low byte
+uint32_t ipOf(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    return (uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24;
+}
+
+// Requests accepted out of count sent by ip, spaced intervalMs apart
+int send(HttpAdmission& admission, uint32_t ip, uint8_t cost, int count, uint32_t& nowMs, uint32_t intervalMs) {
+    int accepted = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t retryAfterSec;
+        if (admission.admit(ip, cost, nowMs, retryAfterSec) == AdmissionResult::Accepted) {
+            accepted++;
+        }
+        nowMs += intervalMs;
+    }
+    return accepted;
+}
+
+// The soak driver connects to HTTP_LOOPBACK_IP (SoakDriver::startRequest);
+// none of its requests may be shed, whatever the rate
+void checkSoakLoopback() {
+    HttpAdmission admission;
+    uint32_t now = 1000;
+    CHECK(ipOf(127, 0, 0, 1) == HTTP_LOOPBACK_IP);
+    int sent = HTTP_GLOBAL_BURST * 10;
+    CHECK(send(admission, HTTP_LOOPBACK_IP, HTTP_HEAVY_COST, sent, now, 0) == sent);
+    CHECK(admission.getStats().exempt == (uint32_t)sent);
+    CHECK(admission.getStats().shedClient == 0 && admission.getStats().shedGlobal == 0);
+
+    // Exempt traffic leaves the shared budget to real clients
+    CHECK(send(admission, ipOf(192, 168, 4, 2), 1, HTTP_CLIENT_BURST, now, 0) == HTTP_CLIENT_BURST);
+
+    // The softAP's own address is an ordinary client: a driver connecting to
+    // it would be rate limited like any browser
+    uint32_t softAp = ipOf(192, 168, 4, 1);
+    CHECK(send(admission, softAp, 1, HTTP_CLIENT_BURST * 2, now, 0) < HTTP_CLIENT_BURST * 2);
+    CHECK(admission.getStats().shedClient > 0);
+}
+
+void checkClientBucket() {
+    HttpAdmission admission;
+    uint32_t now = 1000;
+    uint32_t browser = ipOf(192, 168, 4, 2);
+
+    // A dashboard load and its fetches fit in the burst
+    CHECK(send(admission, browser, HTTP_HEAVY_COST, 1, now, 0) == 1);
+    CHECK(send(admission, browser, 1, HTTP_CLIENT_BURST - HTTP_HEAVY_COST, now, 0) ==
+          HTTP_CLIENT_BURST - HTTP_HEAVY_COST);
+
+    // The bucket is empty: the next request is shed with a Retry-After
+    uint32_t retryAfterSec;
+    CHECK(admission.admit(browser, 1, now, retryAfterSec) == AdmissionResult::ShedClient);
+    CHECK(retryAfterSec >= 1 && retryAfterSec <= 2);
+
+    // Refill at HTTP_CLIENT_RATE_PER_SEC
+    now += 1000;
+    CHECK(send(admission, browser, 1, HTTP_CLIENT_RATE_PER_SEC + 1, now, 0) == HTTP_CLIENT_RATE_PER_SEC);
+
+    // Sustained traffic at the client rate is never shed
+    now += 2000;
+    int sent = HTTP_CLIENT_RATE_PER_SEC * 60;
+    CHECK(send(admission, browser, 1, sent, now, 1000 / HTTP_CLIENT_RATE_PER_SEC) == sent);
+}
+
+void checkGlobalBucket() {
+    HttpAdmission admission;
+    uint32_t now = 1000;
+    int accepted = 0;
+    for (int client = 0; client < HTTP_ADMISSION_CLIENTS; client++) {
+        accepted += send(admission, ipOf(192, 168, 4, 10 + client), 1, HTTP_CLIENT_BURST, now, 0);
+    }
+    uint32_t retryAfterSec;
+    AdmissionResult result = admission.admit(ipOf(192, 168, 4, 99), 1, now, retryAfterSec);
+    CHECK(accepted == HTTP_GLOBAL_BURST);
+    CHECK(result == AdmissionResult::ShedGlobal && retryAfterSec >= 1);
+    CHECK(admission.getStats().shedGlobal > 0);
+    // More clients than slots reuse the longest idle one
+    CHECK(admission.getStats().evictions == 1);
+
+    char report[1024];
+    size_t length = admission.formatStats(report, sizeof(report), now);
+    CHECK(length > 0 && length < sizeof(report));
+    CHECK(strstr(report, "192.168.4.99") != nullptr);
+}
+
+}  // namespace
+
+int main() {
+    checkSoakLoopback();
+    checkClientBucket();
+    checkGlobalBucket();
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures ? 1 : 0;
+}
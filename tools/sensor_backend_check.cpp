@@ -0,0 +1,375 @@
+// Host-side check of the sensor manager and control code against every
+// Arduino-free sensor backend.
+//
+// Build (Linux/macOS):
+//   g++ -O2 -std=c++11 -Isrc -o sensor_backend_check tools/sensor_backend_check.cpp src/SensorManager.cpp src/Calibration.cpp src/SensorStats.cpp src/AnomalyDetector.cpp
+//
+// Usage:
+//   sensor_backend_check [--verbose]
+//
+// Runs BasicSensorManager<Backend> (src/SensorManager.h) with the firmware's
+// cycle order, AnomalyDetector and decidePump over SimulatedSensorBackend,
+// ReplaySensorBackend and FaultInjectingBackend, side by side, and checks the
+// percentages, pump decisions, fault effects, calibration storage and the
+// calibration table's error at breakpoints between entries.
+//
+// Exit status is 1 when any check failed.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "SensorManager.h"
+#include "SimulatedSensorBackend.h"
+#include "ReplaySensorBackend.h"
+#include "FaultInjectingBackend.h"
+#include "AnomalyDetector.h"
+#include "PumpPolicy.h"
+
+namespace {
+
+int failures = 0;
+int checks = 0;
+bool verbose = false;
+int logLines = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+#define CHECK_NEAR(value, expected, tolerance) \
+    check(abs((value) - (expected)) <= (tolerance), #value " ~ " #expected, __LINE__)
+
+void check(bool ok, const char* what, int line) {
+    checks++;
+    if (!ok) {
+        failures++;
+        printf("FAIL line %d: %s\n", line, what);
+    }
+}
+
+void countLog(const char* message) {
+    logLines++;
+    if (verbose) {
+        printf("  log: %s\n", message);
+    }
+}
+
+// SettingsStore stand-in
+class MemoryBlobStore : public BlobStore {
+public:
+    std::map<std::string, std::vector<uint8_t>> blobs;
+
+    bool getBlob(const char* key, void* data, size_t size) override {
+        auto it = blobs.find(key);
+        if (it == blobs.end() || it->second.size() != size) {
+            return false;
+        }
+        memcpy(data, it->second.data(), size);
+        return true;
+    }
+    void putBlob(const char* key, const void* data, size_t size) override {
+        const uint8_t* bytes = (const uint8_t*)data;
+        blobs[key].assign(bytes, bytes + size);
+    }
+    void removeBlob(const char* key) override { blobs.erase(key); }
+};
+
+struct CycleResult {
+    float temperature;
+    float humidity;
+    int soil;
+    int water;
+    PumpAction action;
+};
+
+// One sensor cycle in the firmware's order (runSensorCycle in main.cpp)
+template <class Manager>
+CycleResult runCycle(Manager& sensors, AnomalyDetector& anomalies, bool& pumpOn, uint32_t nowMs) {
+    CycleResult result;
+    sensors.beginCycle();
+    sensors.measureClimate();
+    result.temperature = sensors.readTemperature();
+    result.humidity = sensors.readHumidity();
+    result.water = sensors.getWaterPercentage();
+    sensors.endCycle();
+    result.soil = sensors.getSoilPercentage();
+    sensors.updateStats(nowMs);
+
+    AnomalySample sample = { nowMs, pumpOn, result.soil, sensors.getLastSoilRaw(), result.water,
+                             result.temperature, result.humidity };
+    anomalies.update(sample);
+    result.action = decidePump(result.soil, result.water, pumpOn, ANOMALY_BLOCKS_PUMP && anomalies.blocksPump());
+    pumpOn = pumpActionState(result.action, pumpOn);
+    return result;
+}
+
+// Raw soil value the default curve maps to percentage
+uint16_t soilRawFor(int percentage) {
+    return (uint16_t)(SOIL_DRY_VALUE - ((SOIL_DRY_VALUE - SOIL_WET_VALUE) * percentage + 50) / 100);
+}
+
+// A dry pot being watered and drying again, with a little ADC noise. The
+// reservoir level stays put: a falling one with the pump off is a leak.
+std::vector<SensorSample> makeTrace() {
+    std::vector<SensorSample> trace;
+    const int soil[] = { 30, 25, 18, 15, 22, 35, 50, 62, 64, 58, 45, 30 };
+    for (size_t i = 0; i < sizeof(soil) / sizeof(soil[0]); i++) {
+        SensorSample sample;
+        sample.temperature = 24.0f + 0.1f * i;
+        sample.humidity = 55.0f - 0.2f * i;
+        sample.soilRaw = (uint16_t)(soilRawFor(soil[i]) + (i & 1));
+        sample.waterSections = 16;
+        trace.push_back(sample);
+    }
+    return trace;
+}
+
+void checkSimulated() {
+    BasicSensorManager<SimulatedSensorBackend> sensors;
+    sensors.setLog(countLog);
+    sensors.begin();
+    AnomalyDetector anomalies;
+    bool pumpOn = false;
+    uint32_t now = 0;
+
+    SimulatedSensorBackend& backend = sensors.backend();
+    backend.setTemperature(23.5f);
+    backend.setHumidity(61.0f);
+    backend.setSoilPercentage(15);
+    backend.setWaterPercentage(70);
+    CycleResult r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    CHECK(r.temperature == 23.5f && r.humidity == 61.0f);
+    CHECK_NEAR(r.soil, 15, 1);
+    CHECK(r.water == 70);
+    CHECK(r.action == PumpAction::StartSoilDry && pumpOn);
+    CHECK(sensors.getLastSoilPercentage() == r.soil && sensors.getLastWaterPercentage() == 70);
+
+    // Watering in steps the jump check accepts
+    backend.setSoilPercentage(40);
+    r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    CHECK(r.action == PumpAction::None && pumpOn);
+    backend.setSoilPercentage(PUMP_SOIL_WET_PCT + 2);
+    r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    CHECK(r.action == PumpAction::StopSoilWet && !pumpOn);
+
+    // A jump no real soil makes stops the pump
+    backend.setSoilPercentage(10);
+    r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    CHECK(r.action == PumpAction::None && !pumpOn);
+    CHECK((anomalies.getActive() & ANOMALY_BIT(SoilJump)) != 0);
+
+    backend.setSoilPercentage(10);
+    backend.setWaterPercentage(PUMP_WATER_MIN_PCT);
+    r = runCycle(sensors, anomalies, pumpOn, now += ANOMALY_JUMP_HOLD_S * 1000UL);
+    CHECK(r.action == PumpAction::None && !pumpOn);     // no start on a dry tank
+    CHECK(logLines > 0);
+}
+
+// Replay and an inactive fault injector over the same trace decide alike
+void checkReplaySideBySide(const std::vector<SensorSample>& trace) {
+    BasicSensorManager<ReplaySensorBackend> replay;
+    BasicSensorManager<FaultInjectingBackend<ReplaySensorBackend>> wrapped;
+    replay.backend().load(trace.data(), trace.size(), false);
+    wrapped.backend().getInner().load(trace.data(), trace.size(), false);
+    replay.begin();
+    wrapped.begin();
+    AnomalyDetector replayAnomalies;
+    AnomalyDetector wrappedAnomalies;
+    bool replayPump = false;
+    bool wrappedPump = false;
+
+    int starts = 0;
+    int stops = 0;
+    for (size_t i = 0; i < trace.size(); i++) {
+        uint32_t now = (uint32_t)(i + 1) * 1000;
+        CycleResult a = runCycle(replay, replayAnomalies, replayPump, now);
+        CycleResult b = runCycle(wrapped, wrappedAnomalies, wrappedPump, now);
+        CHECK(a.temperature == trace[i].temperature && a.humidity == trace[i].humidity);
+        CHECK(a.water == trace[i].waterSections * 100 / WATER_LEVEL_MAX_SECTIONS);
+        CHECK(a.soil == b.soil && a.water == b.water && a.action == b.action && replayPump == wrappedPump);
+        starts += a.action == PumpAction::StartSoilDry;
+        stops += a.action == PumpAction::StopSoilWet;
+    }
+    CHECK(starts == 1 && stops == 1);
+    CHECK(wrapped.backend().getInjected() == 0);
+
+    // Past the end a non-looping replay holds its last sample
+    CHECK(!replay.backend().isFinished());
+    CycleResult last = runCycle(replay, replayAnomalies, replayPump, (uint32_t)(trace.size() + 1) * 1000);
+    CHECK(replay.backend().isFinished() && replay.backend().getPosition() == trace.size() - 1);
+    CHECK(last.temperature == trace.back().temperature);
+}
+
+void checkFaults(const std::vector<SensorSample>& trace) {
+    BasicSensorManager<FaultInjectingBackend<ReplaySensorBackend>> sensors;
+    FaultInjectingBackend<ReplaySensorBackend>& backend = sensors.backend();
+    backend.getInner().load(trace.data(), trace.size(), true);
+    sensors.begin();
+    AnomalyDetector anomalies;
+    bool pumpOn = true;
+    uint32_t now = 0;
+
+    // Climate dropout: both channels read N/A and both count as injected
+    SensorFaults faults = {};
+    faults.climateDropout = true;
+    backend.setFaults(faults);
+    CycleResult r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    CHECK(r.temperature == SENSOR_NO_READING && r.humidity == SENSOR_NO_READING);
+    uint32_t injected = backend.getInjected();
+    CHECK(injected > 0);
+    backend.readHumidity();
+    CHECK(backend.getInjected() == injected + 1);
+    backend.readTemperature();
+    CHECK(backend.getInjected() == injected + 2);
+
+    // Water sensor gone: the running pump stops
+    faults = SensorFaults();
+    faults.waterDropout = true;
+    backend.setFaults(faults);
+    r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    CHECK(r.water == 0 && r.action == PumpAction::StopWaterLow && !pumpOn);
+
+    // Drift moves the raw value by the offset (clamped to the ADC range)
+    faults = SensorFaults();
+    faults.soilOffset = 400;
+    backend.setFaults(faults);
+    r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    size_t position = backend.getInner().getPosition();
+    int expectedRaw = trace[position].soilRaw + 400;
+    CHECK(sensors.getLastSoilRaw() == (expectedRaw > 4095 ? 4095 : expectedRaw));
+
+    // Stuck soil: the raw value stops moving and the flatline alarm follows.
+    // The flatline alone does not block the pump; here the drift above made
+    // the soil read dry, so the pump runs with nothing moving: a dry pump.
+    faults = SensorFaults();
+    faults.soilStuck = true;
+    backend.setFaults(faults);
+    r = runCycle(sensors, anomalies, pumpOn, now += 1000);
+    int stuckRaw = sensors.getLastSoilRaw();
+    bool allStuck = true;
+    for (uint32_t s = 0; s <= ANOMALY_FLATLINE_S; s += 60) {
+        r = runCycle(sensors, anomalies, pumpOn, now += 60000);
+        allStuck &= sensors.getLastSoilRaw() == stuckRaw;
+    }
+    CHECK(allStuck);
+    CHECK((anomalies.getActive() & ANOMALY_BIT(SoilFlatline)) != 0);
+    CHECK((ANOMALY_BLOCKING & ANOMALY_BIT(SoilFlatline)) == 0);
+    CHECK((anomalies.getActive() & ANOMALY_BIT(PumpNoFlow)) != 0 && !pumpOn);
+
+    // Random dropouts are reproducible (fixed seed)
+    BasicSensorManager<FaultInjectingBackend<SimulatedSensorBackend>> a;
+    BasicSensorManager<FaultInjectingBackend<SimulatedSensorBackend>> b;
+    faults = SensorFaults();
+    faults.dropoutPercent = 30;
+    a.backend().setFaults(faults);
+    b.backend().setFaults(faults);
+    int dropped = 0;
+    bool same = true;
+    for (int i = 0; i < 200; i++) {
+        AnomalyDetector da;
+        AnomalyDetector db;
+        bool pa = false;
+        bool pb = false;
+        CycleResult ra = runCycle(a, da, pa, 1000);
+        CycleResult rb = runCycle(b, db, pb, 1000);
+        same &= ra.temperature == rb.temperature && ra.water == rb.water;
+        dropped += ra.temperature == SENSOR_NO_READING;
+    }
+    CHECK(same);
+    CHECK(dropped > 30 && dropped < 90);
+}
+
+void checkCalibrationStore() {
+    MemoryBlobStore store;
+    CalibrationData data = SensorManagerBase::defaultCalibration(CalibrationSensor::Soil);
+    data.points[0].raw = 1000;      // wet end moved
+
+    {
+        BasicSensorManager<SimulatedSensorBackend> sensors;
+        sensors.setSettingsStore(&store);
+        sensors.begin();
+        CHECK(sensors.setCalibration(CalibrationSensor::Soil, data));
+        CHECK(store.blobs.count("cal_soil") == 1);
+    }
+
+    // A new manager loads the stored curve in begin()
+    BasicSensorManager<SimulatedSensorBackend> sensors;
+    sensors.setSettingsStore(&store);
+    sensors.begin();
+    sensors.backend().setSoilPercentage(100);      // raw SOIL_WET_VALUE, now past the wet end
+    bool pumpOn = false;
+    AnomalyDetector anomalies;
+    CycleResult r = runCycle(sensors, anomalies, pumpOn, 1000);
+    CHECK(r.soil == 100);
+    sensors.backend().setSoilPercentage(50);
+    r = runCycle(sensors, anomalies, pumpOn, 2000);
+    CHECK(r.soil > 50);                             // same raw value reads wetter on the new curve
+
+    sensors.resetCalibration(CalibrationSensor::Soil);
+    CHECK(store.blobs.count("cal_soil") == 0);
+    r = runCycle(sensors, anomalies, pumpOn, 3000);
+    CHECK_NEAR(r.soil, 50, 1);
+}
+
+
+// The table samples the curve every 2^SOIL_CAL_LUT_SHIFT counts and evaluation
+// interpolates linearly between entries, so a knee between two entries is
+// rounded off: by at most |slope change| * stride / 4 at the breakpoint, and
+// not at all when the breakpoint sits on an entry
+void checkCalibrationStride() {
+    const int stride = 1 << SOIL_CAL_LUT_SHIFT;
+    CalibrationData data = SensorManagerBase::defaultCalibration(CalibrationSensor::Soil);
+    data.mode = CalibrationMode::Linear;
+    data.pointCount = 3;
+    data.points[0] = CalibrationPoint{0, 0};
+    data.points[1] = CalibrationPoint{(uint16_t)(stride * 15 + stride / 2), 90};     // mid-stride knee
+    data.points[2] = CalibrationPoint{4095, 100};
+
+    for (int aligned = 0; aligned < 2; aligned++) {
+        if (aligned) {
+            data.points[1].raw = stride * 15;
+        }
+        CalibrationCurve curve(4095, SOIL_CAL_LUT_SHIFT);
+        CHECK(curve.set(data));
+        float knee = data.points[1].raw;
+        float slopeIn = 90.0f / knee;
+        float slopeOut = 10.0f / (4095 - knee);
+        float worst = 0.0f;
+        int worstRaw = 0;
+        for (int raw = 0; raw <= 4095; raw++) {
+            float exact = raw <= knee ? raw * slopeIn : 90.0f + (raw - knee) * slopeOut;
+            float error = fabsf(curve.evaluateQ8(raw) / 256.0f - exact);
+            if (error > worst) {
+                worst = error;
+                worstRaw = raw;
+            }
+        }
+        if (verbose) {
+            printf("  calibration knee at %d: max error %.2f%% at raw %d\n", data.points[1].raw, worst, worstRaw);
+        }
+        if (aligned) {
+            CHECK(worst < 0.02f);                               // Q8 rounding only
+        } else {
+            CHECK(worstRaw == data.points[1].raw);
+            CHECK(worst <= (slopeIn - slopeOut) * stride / 4 + 0.02f);
+            CHECK(worst > 0.5f);                                // the limit is real at this shift
+        }
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    verbose = argc > 1 && strcmp(argv[1], "--verbose") == 0;
+    std::vector<SensorSample> trace = makeTrace();
+
+    checkSimulated();
+    checkReplaySideBySide(trace);
+    checkFaults(trace);
+    checkCalibrationStore();
+    checkCalibrationStride();
+
+    printf("%d checks, %d failed (backends: %s, %s, %s)\n", checks, failures, SimulatedSensorBackend::name(),
+           ReplaySensorBackend::name(), FaultInjectingBackend<ReplaySensorBackend>::name());
+    return failures ? 1 : 0;
+}
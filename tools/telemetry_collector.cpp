@@ -0,0 +1,461 @@
+// Host-side collector for the GrowBox binary UDP telemetry (src/TelemetryFrame.h).
+//
+// Build (Linux/macOS):
+//   g++ -O2 -std=c++11 -Isrc -o telemetry_collector tools/telemetry_collector.cpp
+//
+// Usage:
+//   telemetry_collector listen [--port 5170] [--csv out.csv] [--columns DIR] [--raw capture.bin]
+//   telemetry_collector decode capture.bin [--csv out.csv] [--columns DIR]
+//
+// --csv      one row per frame
+// --columns  columnar output: one little-endian binary file per field plus schema.txt
+// --raw      append every received datagram (u16 length + bytes) for later 'decode'
+//
+// Sequence gaps, duplicates, late frames, reboots and device-side drops are tracked
+// per box and printed on exit (Ctrl+C in listen mode). Every lost frame is counted
+// once: frames the box discarded itself (header.droppedFrames) as dev_drops, the
+// rest of a sequence gap as missing. A frame older than the last one is a reboot
+// only when its sequence is nearer zero than the last sequence, or when its
+// uptime clock went backwards while the sequence moved on; otherwise UDP delivered
+// it late, and it counts as reordered and fills its gap.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include "TelemetryFrame.h"
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onSignal(int) { stopRequested = 1; }
+
+double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Large-buffer file writer; fwrite per field is far too slow at 100k+ frames/s.
+class BufferedFile {
+public:
+    BufferedFile() : fp(nullptr), used(0) {}
+    ~BufferedFile() { close(); }
+
+    bool open(const std::string& path, const char* mode) {
+        fp = fopen(path.c_str(), mode);
+        if (!fp) {
+            fprintf(stderr, "cannot open %s: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        buffer.resize(1 << 20);
+        return true;
+    }
+
+    bool isOpen() const { return fp != nullptr; }
+
+    void write(const void* data, size_t len) {
+        if (used + len > buffer.size()) flush();
+        if (len > buffer.size()) {
+            fwrite(data, 1, len, fp);
+            return;
+        }
+        memcpy(&buffer[used], data, len);
+        used += len;
+    }
+
+    void flush() {
+        if (fp && used) fwrite(buffer.data(), 1, used, fp);
+        used = 0;
+    }
+
+    void close() {
+        if (!fp) return;
+        flush();
+        fclose(fp);
+        fp = nullptr;
+    }
+
+private:
+    FILE* fp;
+    std::vector<char> buffer;
+    size_t used;
+};
+
+// Appends decimal integers without printf overhead
+inline char* appendUInt(char* out, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (n) *out++ = tmp[--n];
+    return out;
+}
+
+inline char* appendInt(char* out, int32_t v) {
+    if (v < 0) { *out++ = '-'; return appendUInt(out, (uint32_t)(-(int64_t)v)); }
+    return appendUInt(out, (uint32_t)v);
+}
+
+// Fixed-point 0.01 value -> "12.34"
+inline char* appendCenti(char* out, int32_t v) {
+    if (v < 0) { *out++ = '-'; v = -v; }
+    out = appendUInt(out, (uint32_t)v / 100);
+    *out++ = '.';
+    *out++ = (char)('0' + (v / 10) % 10);
+    *out++ = (char)('0' + v % 10);
+    return out;
+}
+
+class CsvSink {
+public:
+    bool open(const std::string& path) {
+        if (!file.open(path, "w")) return false;
+        const char* header = "box_id,sequence,timestamp,uptime_clock,temperature_c,humidity_pct,"
+                             "soil_pct,water_pct,pump,grow_led,boost,rgb,brightness,sensor_errors,send_errors\n";
+        file.write(header, strlen(header));
+        return true;
+    }
+
+    void write(const TelemetryFrame& f) {
+        char line[160];
+        char* p = line;
+        p = appendUInt(p, f.boxId); *p++ = ',';
+        p = appendUInt(p, f.sequence); *p++ = ',';
+        p = appendUInt(p, f.timestamp); *p++ = ',';
+        *p++ = (f.flags & TELEMETRY_FLAG_UPTIME) ? '1' : '0'; *p++ = ',';
+        if (f.temperature != TELEMETRY_TEMP_INVALID) p = appendCenti(p, f.temperature);
+        *p++ = ',';
+        if (f.humidity != TELEMETRY_HUM_INVALID) p = appendCenti(p, f.humidity);
+        *p++ = ',';
+        p = appendUInt(p, f.soilPercentage); *p++ = ',';
+        p = appendUInt(p, f.waterPercentage); *p++ = ',';
+        *p++ = (f.actuators & TELEMETRY_ACT_PUMP) ? '1' : '0'; *p++ = ',';
+        *p++ = (f.actuators & TELEMETRY_ACT_GROWLED) ? '1' : '0'; *p++ = ',';
+        *p++ = (f.actuators & TELEMETRY_ACT_BOOST) ? '1' : '0'; *p++ = ',';
+        *p++ = (f.actuators & TELEMETRY_ACT_RGB) ? '1' : '0'; *p++ = ',';
+        p = appendUInt(p, f.brightness); *p++ = ',';
+        p = appendUInt(p, f.sensorErrors); *p++ = ',';
+        p = appendUInt(p, f.sendErrors); *p++ = '\n';
+        file.write(line, (size_t)(p - line));
+    }
+
+    void close() { file.close(); }
+
+private:
+    BufferedFile file;
+};
+
+// One raw little-endian array per field - loads directly into numpy/pandas/arrow
+// (np.fromfile(dir + "/temperature.bin", dtype="<i2") / 100.0).
+class ColumnSink {
+public:
+    bool open(const std::string& dir) {
+        mkdir(dir.c_str(), 0755);
+        static const struct { const char* name; const char* type; } columns[kColumnCount] = {
+            {"box_id", "uint16"}, {"sequence", "uint32"}, {"timestamp", "uint32"},
+            {"temperature", "int16 (0.01 C, -32768 = missing)"},
+            {"humidity", "uint16 (0.01 %RH, 65535 = missing)"},
+            {"soil_pct", "uint8"}, {"water_pct", "uint8"}, {"actuators", "uint8 (bit0 pump, bit1 grow_led, bit2 boost, bit3 rgb)"},
+            {"brightness", "uint8"}, {"flags", "uint8 (bit0 uptime clock, bit1 no climate)"},
+            {"sensor_errors", "uint16"}, {"send_errors", "uint16"},
+        };
+        BufferedFile schema;
+        if (!schema.open(dir + "/schema.txt", "w")) return false;
+        for (int i = 0; i < kColumnCount; i++) {
+            if (!files[i].open(dir + "/" + columns[i].name + ".bin", "wb")) return false;
+            std::string line = std::string(columns[i].name) + " " + columns[i].type + "\n";
+            schema.write(line.data(), line.size());
+        }
+        return true;
+    }
+
+    void write(const TelemetryFrame& f) {
+        files[0].write(&f.boxId, sizeof(f.boxId));
+        files[1].write(&f.sequence, sizeof(f.sequence));
+        files[2].write(&f.timestamp, sizeof(f.timestamp));
+        files[3].write(&f.temperature, sizeof(f.temperature));
+        files[4].write(&f.humidity, sizeof(f.humidity));
+        files[5].write(&f.soilPercentage, 1);
+        files[6].write(&f.waterPercentage, 1);
+        files[7].write(&f.actuators, 1);
+        files[8].write(&f.brightness, 1);
+        files[9].write(&f.flags, 1);
+        files[10].write(&f.sensorErrors, sizeof(f.sensorErrors));
+        files[11].write(&f.sendErrors, sizeof(f.sendErrors));
+    }
+
+    void close() {
+        for (int i = 0; i < kColumnCount; i++) files[i].close();
+    }
+
+private:
+    static const int kColumnCount = 12;
+    BufferedFile files[kColumnCount];
+};
+
+struct BoxState {
+    bool seen;
+    uint32_t lastSequence;
+    uint32_t lastTimestamp;
+    bool lastUptime;       // lastTimestamp is seconds since boot
+    uint64_t frames;
+    uint64_t missing;      // frames lost in transit (sequence gaps not explained by device drops)
+    uint64_t duplicates;   // the last sequence number again
+    uint64_t reordered;    // older than the last sequence, same boot
+    uint64_t deviceDrops;  // frames the box itself discarded (header.droppedFrames)
+    uint64_t reboots;      // sequence restarted near zero or uptime went backwards
+};
+
+class Collector {
+public:
+    Collector() : boxes(65536), datagrams(0), frames(0), malformed(0) {
+        memset(boxes.data(), 0, boxes.size() * sizeof(BoxState));
+    }
+
+    CsvSink* csv = nullptr;
+    ColumnSink* columns = nullptr;
+
+    void ingest(const uint8_t* data, size_t len) {
+        if (len < sizeof(TelemetryBatchHeader)) { malformed++; return; }
+        TelemetryBatchHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != TELEMETRY_MAGIC || header.version != TELEMETRY_VERSION ||
+            header.frameSize < sizeof(TelemetryFrame) ||
+            sizeof(header) + (size_t)header.frameCount * header.frameSize > len) {
+            malformed++;
+            return;
+        }
+        datagrams++;
+
+        const uint8_t* p = data + sizeof(header);
+        for (unsigned i = 0; i < header.frameCount; i++, p += header.frameSize) {
+            TelemetryFrame f;
+            memcpy(&f, p, sizeof(f));
+            track(f, i == 0 ? header.droppedFrames : 0);
+            if (csv) csv->write(f);
+            if (columns) columns->write(f);
+        }
+        frames += header.frameCount;
+    }
+
+    void report(double seconds) const {
+        fprintf(stderr, "\n%llu datagrams, %llu frames, %llu malformed in %.2f s (%.0f frames/s)\n",
+                (unsigned long long)datagrams, (unsigned long long)frames, (unsigned long long)malformed,
+                seconds, seconds > 0 ? frames / seconds : 0.0);
+        fprintf(stderr, "%6s %12s %12s %10s %10s %10s %10s %8s\n", "box", "frames", "last_seq", "missing", "dup",
+                "reordered", "dev_drops", "reboots");
+        for (size_t id = 0; id < boxes.size(); id++) {
+            const BoxState& b = boxes[id];
+            if (!b.seen) continue;
+            fprintf(stderr, "%6zu %12llu %12u %10llu %10llu %10llu %10llu %8llu\n", id,
+                    (unsigned long long)b.frames, b.lastSequence, (unsigned long long)b.missing,
+                    (unsigned long long)b.duplicates, (unsigned long long)b.reordered,
+                    (unsigned long long)b.deviceDrops, (unsigned long long)b.reboots);
+        }
+    }
+
+private:
+    void track(const TelemetryFrame& f, uint16_t deviceDrops) {
+        BoxState& b = boxes[f.boxId];
+        b.frames++;
+        b.deviceDrops += deviceDrops;
+        bool uptime = (f.flags & TELEMETRY_FLAG_UPTIME) != 0;
+        if (!b.seen) {
+            b.seen = true;
+            b.lastSequence = f.sequence;
+            b.lastTimestamp = f.timestamp;
+            b.lastUptime = uptime;
+            return;
+        }
+        if (f.sequence == b.lastSequence) {
+            b.duplicates++;
+            return;
+        }
+        uint32_t expected = b.lastSequence + 1;
+        bool reboot;
+        if (f.sequence < b.lastSequence) {
+            // A datagram overtaken by later ones is a few batches behind; a
+            // restarted box is back near 0
+            reboot = f.sequence < b.lastSequence - f.sequence;
+        } else {
+            // Same boot, later frame: the uptime clock cannot have gone back
+            reboot = uptime && b.lastUptime && f.timestamp < b.lastTimestamp;
+        }
+        if (!reboot && f.sequence < b.lastSequence) {
+            // Counted as missing when the later frame opened the gap, and so
+            // were the device drops in front of it
+            b.reordered++;
+            uint64_t filled = 1 + (uint64_t)deviceDrops;
+            b.missing -= filled < b.missing ? filled : b.missing;
+            return;
+        }
+        if (reboot) {
+            // The sequence restarts at 0, and the first frames after boot may
+            // have been dropped or lost
+            b.reboots++;
+            expected = 0;
+        }
+        // The device drops its oldest unsent frames, so they are part of the gap
+        // before the first frame of the batch; only the rest was lost in transit
+        uint32_t gap = f.sequence - expected;
+        b.missing += gap > deviceDrops ? gap - deviceDrops : 0;
+        b.lastSequence = f.sequence;
+        b.lastTimestamp = f.timestamp;
+        b.lastUptime = uptime;
+    }
+
+    std::vector<BoxState> boxes;
+    uint64_t datagrams;
+    uint64_t frames;
+    uint64_t malformed;
+};
+
+int listenLoop(Collector& collector, uint16_t port, BufferedFile* raw) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) { perror("socket"); return 1; }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int rcvbuf = 8 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct timeval tv = {0, 200000};   // wake up to notice Ctrl+C
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); close(fd); return 1; }
+    fprintf(stderr, "listening on udp/%u\n", port);
+
+#ifdef __linux__
+    // Drain up to kBatch datagrams per syscall
+    const int kBatch = 64;
+    static uint8_t buffers[kBatch][1500];
+    struct mmsghdr msgs[kBatch];
+    struct iovec iovecs[kBatch];
+    while (!stopRequested) {
+        memset(msgs, 0, sizeof(msgs));
+        for (int i = 0; i < kBatch; i++) {
+            iovecs[i].iov_base = buffers[i];
+            iovecs[i].iov_len = sizeof(buffers[i]);
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n = recvmmsg(fd, msgs, kBatch, MSG_WAITFORONE, nullptr);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+            perror("recvmmsg");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint16_t len = (uint16_t)msgs[i].msg_len;
+            if (raw) { raw->write(&len, sizeof(len)); raw->write(buffers[i], len); }
+            collector.ingest(buffers[i], len);
+        }
+    }
+#else
+    uint8_t buffer[1500];
+    while (!stopRequested) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+            perror("recv");
+            break;
+        }
+        uint16_t len = (uint16_t)n;
+        if (raw) { raw->write(&len, sizeof(len)); raw->write(buffer, len); }
+        collector.ingest(buffer, len);
+    }
+#endif
+    close(fd);
+    return 0;
+}
+
+int decodeFile(Collector& collector, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) { fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno)); return 1; }
+    std::vector<uint8_t> data;
+    uint8_t chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(fp);
+
+    size_t pos = 0;
+    while (pos + 2 <= data.size() && !stopRequested) {
+        uint16_t len;
+        memcpy(&len, &data[pos], sizeof(len));
+        pos += 2;
+        if (pos + len > data.size()) { fprintf(stderr, "truncated capture\n"); break; }
+        collector.ingest(&data[pos], len);
+        pos += len;
+    }
+    return 0;
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: telemetry_collector listen [--port N] [--csv FILE] [--columns DIR] [--raw FILE]\n"
+            "       telemetry_collector decode CAPTURE [--csv FILE] [--columns DIR]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) { usage(); return 2; }
+    std::string mode = argv[1];
+    const char* capture = nullptr;
+    int argi = 2;
+    if (mode == "decode") {
+        if (argc < 3) { usage(); return 2; }
+        capture = argv[argi++];
+    } else if (mode != "listen") {
+        usage();
+        return 2;
+    }
+
+    uint16_t port = 5170;
+    const char* csvPath = nullptr;
+    const char* columnsDir = nullptr;
+    const char* rawPath = nullptr;
+    for (; argi < argc; argi++) {
+        std::string opt = argv[argi];
+        if (argi + 1 >= argc) { usage(); return 2; }
+        if (opt == "--port") port = (uint16_t)atoi(argv[++argi]);
+        else if (opt == "--csv") csvPath = argv[++argi];
+        else if (opt == "--columns") columnsDir = argv[++argi];
+        else if (opt == "--raw") rawPath = argv[++argi];
+        else { usage(); return 2; }
+    }
+
+    Collector collector;
+    CsvSink csv;
+    ColumnSink columns;
+    BufferedFile raw;
+    if (csvPath) { if (!csv.open(csvPath)) return 1; collector.csv = &csv; }
+    if (columnsDir) { if (!columns.open(columnsDir)) return 1; collector.columns = &columns; }
+    if (rawPath && !raw.open(rawPath, "ab")) return 1;
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    double start = nowSeconds();
+    int rc = capture ? decodeFile(collector, capture)
+                     : listenLoop(collector, port, raw.isOpen() ? &raw : nullptr);
+    double elapsed = nowSeconds() - start;
+
+    csv.close();
+    columns.close();
+    raw.close();
+    collector.report(elapsed);
+    return rc;
+}
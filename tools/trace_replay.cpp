@@ -0,0 +1,304 @@
+// Host-side replayer for GrowBox sensor traces (src/TraceFormat.h, downloaded
+// from /debug/trace).
+//
+// Build (Linux/macOS):
+//   g++ -O2 -std=c++11 -Isrc -o trace_replay tools/trace_replay.cpp src/Calibration.cpp src/AnomalyDetector.cpp
+//
+// Usage:
+//   trace_replay growbox.trace [--csv cycles.csv] [--quiet]
+//
+// Every recorded sensor cycle is fed through the same conversion and pump
+// code the firmware runs (Calibration, countWaterSections, AnomalyDetector,
+// PumpPolicy.h), as
+// fast as the file can be read. Decisions that differ from the ones the
+// recording firmware took are printed, followed by a summary. External pump
+// changes (button, web) and PumpGuard cuts and refusals are applied to both
+// sides so they stay in step.
+//
+// Exit status is 3 when any cycle decided differently.
+//
+// To compare two firmware versions, build this tool in each tree and diff
+// the --csv outputs of the same trace; the replayed_* columns are the only
+// ones that depend on the build.
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <vector>
+#include "TraceFormat.h"
+#include "PumpPolicy.h"
+#include "SensorBackend.h"
+#include "AnomalyDetector.h"
+
+namespace {
+
+struct ReplayState {
+    // Inputs, latest raw values
+    int soilRaw = -1;
+    bool haveWater = false;
+    uint8_t water[TRACE_WATER_BYTES] = {};
+    bool temperatureValid = false;
+    int32_t centiCelsius = 0;
+    bool humidityValid = false;
+    int32_t centiHumidity = 0;
+    AnomalyDetector anomalies;
+
+    // Actuator as recorded and as replayed
+    bool recordedPump = false;
+    bool replayedPump = false;
+    bool decisionPending = false;       // firmware decision seen in this cycle
+    bool guardInCycle = false;          // PumpGuard overrode the relay in this cycle
+    PumpAction recordedAction = PumpAction::None;
+};
+
+struct Summary {
+    uint32_t cycles = 0;
+    uint32_t recordedDecisions = 0;
+    uint32_t replayedDecisions = 0;
+    uint32_t mismatches = 0;
+    uint32_t externalPumpChanges = 0;
+    uint32_t guardOverrides = 0;
+    uint32_t anomalies = 0;
+    uint32_t buttonEdges = 0;
+    uint32_t buttonPresses = 0;
+    uint64_t recordedPumpMs = 0;
+    uint64_t replayedPumpMs = 0;
+};
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(fp);
+    return true;
+}
+
+inline uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+void printMs(FILE* out, uint64_t ms) {
+    fprintf(out, "%llu.%03llus", (unsigned long long)(ms / 1000), (unsigned long long)(ms % 1000));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    const char* csvPath = nullptr;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (!strcmp(argv[i], "--quiet")) {
+            quiet = true;
+        } else if (argv[i][0] != '-' && !tracePath) {
+            tracePath = argv[i];
+        } else {
+            tracePath = nullptr;
+            break;
+        }
+    }
+    if (!tracePath) {
+        fprintf(stderr, "usage: %s growbox.trace [--csv cycles.csv] [--quiet]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(tracePath, data)) {
+        return 1;
+    }
+    TraceHeader header;
+    if (data.size() < sizeof(header)) {
+        fprintf(stderr, "%s: too short for a trace header\n", tracePath);
+        return 1;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION || header.headerSize < sizeof(header)) {
+        fprintf(stderr, "%s: not a version %d trace\n", tracePath, TRACE_VERSION);
+        return 1;
+    }
+    size_t end = (size_t)header.headerSize + header.recordBytes;
+    if (end > data.size()) {
+        fprintf(stderr, "%s: truncated (%zu of %zu bytes)\n", tracePath, data.size(), end);
+        end = data.size();
+    }
+
+    // The curves the device used; the pump rules come from this build
+    CalibrationCurve soilCurve(4095, SOIL_CAL_LUT_SHIFT);
+    CalibrationCurve waterCurve(WATER_LEVEL_MAX_SECTIONS, 0);
+    if (!soilCurve.set(header.soilCalibration) || !waterCurve.set(header.waterCalibration)) {
+        fprintf(stderr, "%s: invalid calibration in header\n", tracePath);
+        return 1;
+    }
+
+    char build[sizeof(header.build) + 1] = {};
+    memcpy(build, header.build, sizeof(header.build));
+    printf("trace: %s\nrecorded by: %s\nrecords: %u (%u dropped on device)\n",
+           tracePath, build, header.recordCount, header.droppedRecords);
+
+    FILE* csv = nullptr;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) {
+            fprintf(stderr, "cannot open %s: %s\n", csvPath, strerror(errno));
+            return 1;
+        }
+        fprintf(csv, "time_ms,soil_raw,soil_pct,water_sections,water_pct,temperature_c,"
+                     "recorded_action,replayed_action,recorded_pump,replayed_pump\n");
+    }
+
+    ReplayState state;
+    state.recordedPump = state.replayedPump = (header.flags & TRACE_HEADER_PUMP_ON) != 0;
+    if (header.flags & TRACE_HEADER_WATER) {
+        memcpy(state.water, header.waterBytes, TRACE_WATER_BYTES);
+        state.haveWater = true;
+    }
+    Summary summary;
+    uint64_t now = header.baseMillis;
+    uint64_t lastTime = now;
+    size_t pos = header.headerSize;
+
+    while (pos < end) {
+        uint8_t tag = data[pos++];
+        uint8_t type = tag & 0x0F;
+        uint32_t delta = 0;
+        uint8_t shift = 0;
+        while (pos < end) {
+            uint8_t b = data[pos++];
+            delta |= (uint32_t)(b & 0x7F) << shift;
+            shift += 7;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        int payloadSize = traceRecordPayload(type);
+        if (payloadSize < 0 || pos + payloadSize > end) {
+            fprintf(stderr, "bad record (type %u) at offset %zu, stopping\n", type, pos);
+            break;
+        }
+        const uint8_t* payload = &data[pos];
+        pos += payloadSize;
+
+        // Pump on-time accumulates between records
+        now += delta;
+        if (state.recordedPump) summary.recordedPumpMs += now - lastTime;
+        if (state.replayedPump) summary.replayedPumpMs += now - lastTime;
+        lastTime = now;
+
+        switch (type) {
+            case TRACE_SOIL:
+                state.soilRaw = readU16(payload);
+                break;
+            case TRACE_WATER:
+                memcpy(state.water, payload, TRACE_WATER_BYTES);
+                state.haveWater = true;
+                break;
+            case TRACE_WATER_SAME:
+                break;
+            case TRACE_CLIMATE:
+                state.temperatureValid = (tag & TRACE_CLIMATE_T_VALID) != 0;
+                state.centiCelsius = traceCentiCelsius(readU16(payload));
+                state.humidityValid = (tag & TRACE_CLIMATE_H_VALID) != 0;
+                state.centiHumidity = traceCentiHumidity(readU16(payload + 2));
+                break;
+            case TRACE_BUTTON:
+                summary.buttonEdges++;
+                if (payload[0] & TRACE_BUTTON_ACCEPTED) summary.buttonPresses++;
+                break;
+            case TRACE_DECISION:
+                state.recordedAction = (PumpAction)payload[0];
+                state.decisionPending = true;
+                summary.recordedDecisions++;
+                break;
+            case TRACE_PUMP:
+                state.recordedPump = payload[0] != 0;
+                if (tag & TRACE_PUMP_GUARD) {
+                    state.replayedPump = state.recordedPump;    // the guard wins over either side
+                    state.guardInCycle = true;
+                    summary.guardOverrides++;
+                } else if (state.decisionPending) {
+                    state.decisionPending = false;      // the firmware's own decision
+                } else {
+                    state.replayedPump = state.recordedPump;
+                    summary.externalPumpChanges++;
+                }
+                break;
+            case TRACE_CYCLE: {
+                summary.cycles++;
+                float temperature = state.temperatureValid ? state.centiCelsius / 100.0f : SENSOR_NO_READING;
+                int sections = state.haveWater ? countWaterSections(state.water, state.water + 8) : 0;
+                int soil = state.soilRaw >= 0 ? soilCurve.evaluate(state.soilRaw, temperature) : 0;
+                int water = waterCurve.evaluate(sections, SENSOR_NO_READING);
+
+                float humidity = state.humidityValid ? state.centiHumidity / 100.0f : SENSOR_NO_READING;
+                AnomalySample sample = { (uint32_t)now, state.replayedPump, soil, state.soilRaw, water, temperature,
+                                         humidity };
+                uint32_t raised = state.anomalies.update(sample);
+                for (int k = 0; k < (int)AnomalyKind::COUNT; k++) {
+                    if ((raised & (1u << k)) && !quiet) {
+                        printf("  t=");
+                        printMs(stdout, now - header.baseMillis);
+                        printf(" anomaly: %s\n", AnomalyDetector::kindName((AnomalyKind)k));
+                    }
+                }
+                summary.anomalies += __builtin_popcount(raised);
+
+                PumpAction replayed = decidePump(soil, water, state.replayedPump,
+                                                 ANOMALY_BLOCKS_PUMP && state.anomalies.blocksPump());
+                if (replayed != PumpAction::None) {
+                    summary.replayedDecisions++;
+                }
+                bool replayedPumpBefore = state.replayedPump;
+                state.replayedPump = pumpActionState(replayed, state.replayedPump);
+                if (state.guardInCycle) {
+                    state.replayedPump = state.recordedPump;
+                }
+                if (replayed != state.recordedAction) {
+                    summary.mismatches++;
+                    if (!quiet) {
+                        printf("  t=");
+                        printMs(stdout, now - header.baseMillis);
+                        printf(" soil=%d%% (raw %d) water=%d%% pump=%s: recorded %s, replayed %s\n",
+                               soil, state.soilRaw, water, replayedPumpBefore ? "on" : "off",
+                               pumpActionName(state.recordedAction), pumpActionName(replayed));
+                    }
+                }
+                if (csv) {
+                    fprintf(csv, "%llu,%d,%d,%d,%d,", (unsigned long long)now, state.soilRaw, soil, sections, water);
+                    if (state.temperatureValid) {
+                        fprintf(csv, "%.2f", state.centiCelsius / 100.0);
+                    }
+                    fprintf(csv, ",%s,%s,%d,%d\n", pumpActionName(state.recordedAction), pumpActionName(replayed),
+                            state.recordedPump, state.replayedPump);
+                }
+                state.recordedAction = PumpAction::None;
+                state.decisionPending = false;
+                state.guardInCycle = false;
+                break;
+            }
+        }
+    }
+    if (csv) {
+        fclose(csv);
+    }
+
+    printf("span: ");
+    printMs(stdout, now - header.baseMillis);
+    printf("\ncycles: %u\ndecisions: recorded %u, replayed %u\nmismatched cycles: %u\n",
+           summary.cycles, summary.recordedDecisions, summary.replayedDecisions, summary.mismatches);
+    printf("external pump changes: %u\npump guard overrides: %u\nanomalies raised: %u\n"
+           "button edges: %u (%u presses)\n", summary.externalPumpChanges, summary.guardOverrides,
+           summary.anomalies, summary.buttonEdges, summary.buttonPresses);
+    printf("pump on-time: recorded ");
+    printMs(stdout, summary.recordedPumpMs);
+    printf(", replayed ");
+    printMs(stdout, summary.replayedPumpMs);
+    printf("\n");
+    return summary.mismatches ? 3 : 0;
+}